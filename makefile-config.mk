@@ -59,19 +59,48 @@ lang                = en
 # Final executables
 #-------------------------------------------------------------------------------
 
-EXEC                = memdebug
+EXEC                = memdebug memdebug-bench memdebug-bench-leaks memdebug-bench-calloc memdebug-bench-sample memdebug-replay memdebug-top
 
 #-------------------------------------------------------------------------------
 # Dependancies for the executables (objects)
 #-------------------------------------------------------------------------------
 
-DEPS_memdebug       = 
+DEPS_memdebug                    = 
+DEPS_memdebug-bench              = 
+DEPS_memdebug-bench-leaks        = 
+DEPS_memdebug-bench-calloc       = 
+DEPS_memdebug-bench-sample       = 
+DEPS_memdebug-replay             = 
+DEPS_memdebug-top                = 
 
 #-------------------------------------------------------------------------------
 # Dependancies for the executables (libraries)
 #-------------------------------------------------------------------------------
 
-DEPS_LIB_memdebug   = libmemdebug
+DEPS_LIB_memdebug                = libmemdebug
+DEPS_LIB_memdebug-bench          = libmemdebug
+DEPS_LIB_memdebug-bench-leaks    = libmemdebug
+DEPS_LIB_memdebug-bench-calloc   = libmemdebug
+DEPS_LIB_memdebug-bench-sample   = libmemdebug
+DEPS_LIB_memdebug-replay         = libmemdebug
+
+#-------------------------------------------------------------------------------
+# The POSIX real-time library (shm_open), part of the C library on Mac OS X
+#-------------------------------------------------------------------------------
+
+SYSLIB_RT           = $(if $(filter Darwin,$(shell uname -s)),,rt)
+
+#-------------------------------------------------------------------------------
+# Dependancies for the executables (system libraries)
+#-------------------------------------------------------------------------------
+
+DEPS_SYSLIB_memdebug              = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-bench        = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-bench-leaks  = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-bench-calloc = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-bench-sample = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-replay       = pthread $(SYSLIB_RT)
+DEPS_SYSLIB_memdebug-top          = $(SYSLIB_RT)
 
 #-------------------------------------------------------------------------------
 # Used frameworks (relevant only for Objective-C)
@@ -108,6 +137,12 @@ SHELL               = /bin/sh
 ARGS_RM             = -rf
 ARGS_INSTALL        = 
 
+# Maximum number of live memory areas and of threads for the benchmarks
+ARGS_BENCH          = 1000000 4
+
+# Maximum sampling rate and number of threads for the benchmark of the inline fast path
+ARGS_BENCH_SAMPLE   = 1000 4
+
 #-------------------------------------------------------------------------------
 # Debug modes (only use for development purpose)
 #-------------------------------------------------------------------------------
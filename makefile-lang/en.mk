@@ -63,6 +63,7 @@ LANG_CLEAN_START         := Removing all the build files in _DIR_BUILD_
 LANG_NOSCRIPT_UNINSTALL  := Sorry, but there\'s actually no uninstall script
 LANG_NOSCRIPT_TEST       := Sorry, but there\'s actually no test script
 LANG_NOSCRIPT_INFOS      := You should find your build files and binaries in _DIR_BUILD_
+LANG_BENCH               := Running the benchmarks - Results written to _FILE_
 LANG_O_BUILD             := Building the object file for _CFILE_ in _DIR_BUILD_
 LANG_LO_BUILD            := Building the library object file for _CFILE_ in _DIR_BUILD_
 LANG_LA_BUILD            := Building the library archive file for _TNAME_ in _DIR_BUILD_
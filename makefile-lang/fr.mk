@@ -63,6 +63,7 @@ LANG_CLEAN_START         := Effacement des fichiers générés dans _DIR_BUILD_
 LANG_NOSCRIPT_UNINSTALL  := Désolé, mais il n\'y a actuellement aucun script de désinstallation
 LANG_NOSCRIPT_TEST       := Désolé, mais il n\'y a actuellement aucun script de test
 LANG_NOSCRIPT_INFOS      := Vous devriez trouver les fichiers générés et les binaires dans _DIR_BUILD_
+LANG_BENCH               := Exécution des benchmarks - Résultats écrits dans _FILE_
 LANG_O_BUILD             := Génération du fichier objet pour _CFILE_ dans _DIR_BUILD_
 LANG_LO_BUILD            := Génération du fichier objet de librairie pour _CFILE_ dans _DIR_BUILD_
 LANG_LA_BUILD            := Génération du fichier archive de librairie pour _TNAME_ dans _DIR_BUILD_
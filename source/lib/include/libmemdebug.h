@@ -66,8 +66,307 @@
 #endif
 #endif
 
+/*
+ * The compile-time feature levels of the standard memory functions
+ * 
+ * MEMDEBUG_LEVEL selects what malloc(), valloc(), calloc(), realloc() and
+ * free() are replaced with, so the work of the higher levels is not even
+ * compiled in the lower ones:
+ * 
+ *  -   MEMDEBUG_LEVEL_COUNTERS:    The real functions, plus inline counters
+ *  -   MEMDEBUG_LEVEL_SITES:       The counters, plus the statistics of the allocation sites
+ *  -   MEMDEBUG_LEVEL_FENCES:      The allocation sites, plus the buffer overflow fences
+ *  -   MEMDEBUG_LEVEL_FULL:        The memory records, with the backtraces (the default)
+ * 
+ * The memory areas of the different levels are not compatible, so all the
+ * files of a program must be compiled with the same level.
+ */
+#define MEMDEBUG_LEVEL_COUNTERS 1
+#define MEMDEBUG_LEVEL_SITES    2
+#define MEMDEBUG_LEVEL_FENCES   3
+#define MEMDEBUG_LEVEL_FULL     4
+
+/* Defines the feature level if it's not already defined */
+#ifndef MEMDEBUG_LEVEL
+#define MEMDEBUG_LEVEL MEMDEBUG_LEVEL_FULL
+#endif
+
+/* The allocation counters of the lower feature levels (see MEMDEBUG_LEVEL) */
+struct memdebug_counters
+{
+    volatile unsigned long int allocs;
+    volatile unsigned long int reallocs;
+    volatile unsigned long int frees;
+    volatile unsigned long int bytes;
+};
+
+/* The allocation counters, updated inline by the lower feature levels */
+extern struct memdebug_counters memdebug_counters;
+
+/* Checks if we are using GNU C */
+#ifdef __GNUC__
+
+/* Increments an allocation counter (atomically) */
+#define MEMDEBUG_COUNT( counter, value ) ( void )__sync_fetch_and_add( &memdebug_counters.counter, ( unsigned long int )( value ) )
+#define MEMDEBUG_INLINE static __inline__
+
+#else
+
+/* Increments an allocation counter (not atomically) */
+#define MEMDEBUG_COUNT( counter, value ) memdebug_counters.counter += ( unsigned long int )( value )
+#define MEMDEBUG_INLINE static inline
+
+#endif
+
+/* Prototypes for the standard memory functions */
+void * memdebug_malloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_valloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func );
+void * memdebug_realloc( void * ptr, size_t size, const char * file, const int line, const char * func );
+void   memdebug_free( void * ptr, const char * file, int line, const char * func );
+
+/* Prototypes for the standard memory functions of the lower feature levels (see MEMDEBUG_LEVEL), one set per level */
+void * memdebug_counted_valloc( size_t size );
+void * memdebug_sites_malloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_sites_valloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_sites_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func );
+void * memdebug_sites_realloc( void * ptr, size_t size, const char * file, const int line, const char * func );
+void   memdebug_sites_free( void * ptr, const char * file, const int line, const char * func );
+void * memdebug_fences_malloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_fences_valloc( size_t size, const char * file, const int line, const char * func );
+void * memdebug_fences_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func );
+void * memdebug_fences_realloc( void * ptr, size_t size, const char * file, const int line, const char * func );
+void   memdebug_fences_free( void * ptr, const char * file, const int line, const char * func );
+
+/* The marker of the memory areas not recorded because of the sampling (the value of their leading fence) */
+#define MEMDEBUG_FENCE_UNTRACKED 0x5AA5L
+
+/* The sampling state of a thread (see the sample option) */
+struct memdebug_sampling
+{
+    /* The number of allocations to skip before the next recorded one */
+    unsigned long int countdown;
+    
+    /* The allocations skipped by the inline fast path, not yet added to the status */
+    unsigned long int untracked;
+};
+
+/* Whether the inline fast path can be taken (MEMDebug is initialized and enabled, with sampling, and without capture) */
+extern volatile int memdebug_fast_ready;
+
+/* The inline fast path needs a sampling state per thread, so it is only available with GNU C */
+#ifdef __GNUC__
+
+/* Declares the real memory functions, before they are redefined */
+#include <stdlib.h>
+
+/* The sampling state of the calling thread */
+extern __thread struct memdebug_sampling memdebug_sampling;
+
+/**
+ * Allocates some memory - Inline fast path of memdebug_malloc()
+ * 
+ * The allocations skipped by the sampling only need the real function,
+ * and the marker of their leading fence, so they do not leave the caller.
+ * The recorded allocations, and the failures, go through memdebug_malloc().
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+MEMDEBUG_INLINE void * memdebug_fast_malloc( size_t size, const char * file, const int line, const char * func )
+{
+    unsigned long int * ptr;
+    
+    if
+    (
+           memdebug_fast_ready != 0
+        && memdebug_sampling.countdown != 0
+        && NULL != ( ptr = ( unsigned long int * )malloc( size + ( 2 * sizeof( unsigned long int ) ) ) )
+    )
+    {
+        memdebug_sampling.countdown--;
+        memdebug_sampling.untracked++;
+        
+        *( ptr ) = MEMDEBUG_FENCE_UNTRACKED;
+        
+        return ptr + 1;
+    }
+    
+    return memdebug_malloc( size, file, line, func );
+}
+
+/**
+ * Allocates some zeroed memory - Inline fast path of memdebug_calloc()
+ * 
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+MEMDEBUG_INLINE void * memdebug_fast_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    unsigned long int * ptr;
+    
+    if
+    (
+           memdebug_fast_ready != 0
+        && memdebug_sampling.countdown != 0
+        && ( size2 == 0 || size1 <= ( ( size_t )-1 - ( 2 * sizeof( unsigned long int ) ) ) / size2 )
+        && NULL != ( ptr = ( unsigned long int * )calloc( 1, ( size1 * size2 ) + ( 2 * sizeof( unsigned long int ) ) ) )
+    )
+    {
+        memdebug_sampling.countdown--;
+        memdebug_sampling.untracked++;
+        
+        *( ptr ) = MEMDEBUG_FENCE_UNTRACKED;
+        
+        return ptr + 1;
+    }
+    
+    return memdebug_calloc( size1, size2, file, line, func );
+}
+
+/**
+ * Reallocates a memory area - Inline fast path of memdebug_realloc()
+ * 
+ * The memory areas which are not recorded are reallocated as is.
+ * 
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+MEMDEBUG_INLINE void * memdebug_fast_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    unsigned long int * ptr_new;
+    
+    if
+    (
+           memdebug_fast_ready != 0
+        && ptr != NULL
+        && *( ( unsigned long int * )ptr - 1 ) == MEMDEBUG_FENCE_UNTRACKED
+        && NULL != ( ptr_new = ( unsigned long int * )realloc( ( unsigned long int * )ptr - 1, size + ( 2 * sizeof( unsigned long int ) ) ) )
+    )
+    {
+        return ptr_new + 1;
+    }
+    
+    return memdebug_realloc( ptr, size, file, line, func );
+}
+
+/**
+ * Frees a memory area - Inline fast path of memdebug_free()
+ * 
+ * The memory areas which are not recorded are released directly.
+ * 
+ * @param   void *          The address of the memory area to free
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void
+ */
+MEMDEBUG_INLINE void memdebug_fast_free( void * ptr, const char * file, const int line, const char * func )
+{
+    if( memdebug_fast_ready != 0 && ptr != NULL && *( ( unsigned long int * )ptr - 1 ) == MEMDEBUG_FENCE_UNTRACKED )
+    {
+        free( ( unsigned long int * )ptr - 1 );
+        return;
+    }
+    
+    memdebug_free( ptr, file, line, func );
+}
+
+#endif
+
 /* Checks if MEMDebug must be activated */
 #if defined( MEMDEBUG ) && MEMDEBUG
+
+/* Checks if only the counters are compiled in */
+#if MEMDEBUG_LEVEL == MEMDEBUG_LEVEL_COUNTERS
+
+/* Declares the real memory functions, before they are redefined */
+#include <stdlib.h>
+
+/* Counts the call, and calls the real malloc() */
+MEMDEBUG_INLINE void * memdebug_counted_malloc( size_t size )
+{
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    return malloc( size );
+}
+
+/* Counts the call, and calls the real calloc() */
+MEMDEBUG_INLINE void * memdebug_counted_calloc( size_t size1, size_t size2 )
+{
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size1 * size2 );
+    
+    return calloc( size1, size2 );
+}
+
+/* Counts the call, and calls the real realloc() */
+MEMDEBUG_INLINE void * memdebug_counted_realloc( void * ptr, size_t size )
+{
+    MEMDEBUG_COUNT( reallocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    return realloc( ptr, size );
+}
+
+/* Counts the call, and calls the real free() */
+MEMDEBUG_INLINE void memdebug_counted_free( void * ptr )
+{
+    MEMDEBUG_COUNT( frees, ( ptr != NULL ) );
+    
+    free( ptr );
+}
+
+/* Redefines the memory functions (valloc() is not always declared by stdlib.h, so it is counted out of line) */
+#define malloc( size )          memdebug_counted_malloc( size )
+#define valloc( size )          memdebug_counted_valloc( size )
+#define calloc( size1, size2 )  memdebug_counted_calloc( size1, size2 )
+#define realloc( ptr, size )    memdebug_counted_realloc( ptr, size )
+#define free( ptr )             memdebug_counted_free( ptr )
+
+/* Checks if only the allocation sites are compiled in */
+#elif MEMDEBUG_LEVEL == MEMDEBUG_LEVEL_SITES
+
+/* Redefines the memory functions */
+#define malloc( size )          memdebug_sites_malloc( size, __FILE__, __LINE__, __func__ )
+#define valloc( size )          memdebug_sites_valloc( size, __FILE__, __LINE__, __func__ )
+#define calloc( size1, size2 )  memdebug_sites_calloc( size1, size2, __FILE__, __LINE__, __func__ )
+#define realloc( ptr, size )    memdebug_sites_realloc( ptr, size, __FILE__, __LINE__, __func__ )
+#define free( ptr )             memdebug_sites_free( ptr, __FILE__, __LINE__, __func__ )
+
+/* Checks if the memory records are not compiled in */
+#elif MEMDEBUG_LEVEL == MEMDEBUG_LEVEL_FENCES
+
+/* Redefines the memory functions */
+#define malloc( size )          memdebug_fences_malloc( size, __FILE__, __LINE__, __func__ )
+#define valloc( size )          memdebug_fences_valloc( size, __FILE__, __LINE__, __func__ )
+#define calloc( size1, size2 )  memdebug_fences_calloc( size1, size2, __FILE__, __LINE__, __func__ )
+#define realloc( ptr, size )    memdebug_fences_realloc( ptr, size, __FILE__, __LINE__, __func__ )
+#define free( ptr )             memdebug_fences_free( ptr, __FILE__, __LINE__, __func__ )
+
+/* Checks if the inline fast path is available */
+#elif defined( __GNUC__ )
+
+/* Redefines the memory functions (valloc() is rare, and has no fast path) */
+#define malloc( size )          memdebug_fast_malloc( size, __FILE__, __LINE__, __func__ )
+#define valloc( size )          memdebug_valloc( size, __FILE__, __LINE__, __func__ )
+#define calloc( size1, size2 )  memdebug_fast_calloc( size1, size2, __FILE__, __LINE__, __func__ )
+#define realloc( ptr, size )    memdebug_fast_realloc( ptr, size, __FILE__, __LINE__, __func__ )
+#define free( ptr )             memdebug_fast_free( ptr, __FILE__, __LINE__, __func__ )
+
+#else
     
 /* Redefines the memory functions */
 #define malloc( size )          memdebug_malloc( size, __FILE__, __LINE__, __func__ )
@@ -76,6 +375,8 @@
 #define realloc( ptr, size )    memdebug_realloc( ptr, size, __FILE__, __LINE__, __func__ )
 #define free( ptr )             memdebug_free( ptr, __FILE__, __LINE__, __func__ )
 
+#endif
+
 /* Checks if the alloca function is available */
 #ifdef _ALLOCA_H_
 
@@ -114,6 +415,43 @@
 #define malloc_zone_realloc( zone, ptr, size )      memdebug_malloc_zone_realloc( zone, ptr, size, __FILE__, __LINE__, __func__ )
 
 #endif
+
+/* Declares the real memory mapping functions, before they are redefined, so they are recorded whatever the include order */
+#include <sys/mman.h>
+
+/* Checks if the memory mapping functions are available */
+#if defined( _SYS_MMAN_H ) || defined( _SYS_MMAN_H_ )
+
+/* Redefines the memory mapping functions */
+#define mmap( addr, length, prot, flags, fd, offset )   memdebug_mmap( addr, length, prot, flags, fd, offset, __FILE__, __LINE__, __func__ )
+#define munmap( addr, length )                          memdebug_munmap( addr, length, __FILE__, __LINE__, __func__ )
+
+/* Checks if the mremap function is available (Linux) */
+#ifdef MREMAP_MAYMOVE
+
+#define mremap( addr, old_size, new_size, ... )         memdebug_mremap( addr, old_size, new_size, __FILE__, __LINE__, __func__, __VA_ARGS__ )
+
+#endif
+#endif
+#endif
+
+/* Arena instrumentation (see memdebug_arena_create()) - No-ops if MEMDebug is not activated */
+#if defined( MEMDEBUG ) && MEMDEBUG
+
+#define MEMDEBUG_ARENA_CREATE( name, fences )       memdebug_arena_create( name, fences )
+#define MEMDEBUG_ARENA_ALLOC( arena, ptr, size )    memdebug_arena_alloc( arena, ptr, size, __FILE__, __LINE__, __func__ )
+#define MEMDEBUG_ARENA_FREE( arena, ptr )           memdebug_arena_free( arena, ptr, __FILE__, __LINE__, __func__ )
+#define MEMDEBUG_ARENA_RESET( arena )               memdebug_arena_reset( arena, __FILE__, __LINE__, __func__ )
+#define MEMDEBUG_ARENA_SIZE( size )                 ( ( size ) + ( 2 * sizeof( unsigned long int ) ) )
+
+#else
+
+#define MEMDEBUG_ARENA_CREATE( name, fences )       0UL
+#define MEMDEBUG_ARENA_ALLOC( arena, ptr, size )    ( ( void * )( ptr ) )
+#define MEMDEBUG_ARENA_FREE( arena, ptr )           ( ( void )0 )
+#define MEMDEBUG_ARENA_RESET( arena )               ( ( void )0 )
+#define MEMDEBUG_ARENA_SIZE( size )                 ( size )
+
 #endif
 
 /* Defines the original pool size if it's not already defined */
@@ -126,12 +464,123 @@
 #define MEMDEBUG_BACKTRACE_SIZE 100    
 #endif
 
-/* Prototypes for the standard memory functions */
-void * memdebug_malloc( size_t size, const char * file, const int line, const char * func );
-void * memdebug_valloc( size_t size, const char * file, const int line, const char * func );
-void * memdebug_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func );
-void * memdebug_realloc( void * ptr, size_t size, const char * file, const int line, const char * func );
-void   memdebug_free( void * ptr, const char * file, int line, const char * func );
+/* Defines the number of leading bytes displayed in memory dumps (0 means no limit) */
+#ifndef MEMDEBUG_DUMP_HEAD
+#define MEMDEBUG_DUMP_HEAD 0
+#endif
+
+/* Defines the number of trailing bytes displayed in memory dumps (0 means no limit) */
+#ifndef MEMDEBUG_DUMP_TAIL
+#define MEMDEBUG_DUMP_TAIL 0
+#endif
+
+/* Defines whether repeated identical lines are collapsed in memory dumps */
+#ifndef MEMDEBUG_DUMP_COLLAPSE
+#define MEMDEBUG_DUMP_COLLAPSE 1
+#endif
+
+/* The supported allocation types (see memdebug_histogram()) */
+#define MEMDEBUG_ALLOC_TYPE_MALLOC                  0x0001L
+#define MEMDEBUG_ALLOC_TYPE_VALLOC                  0x0002L
+#define MEMDEBUG_ALLOC_TYPE_CALLOC                  0x0004L
+#define MEMDEBUG_ALLOC_TYPE_REALLOC                 0x0008L
+#define MEMDEBUG_ALLOC_TYPE_STD                     0x000FL
+#define MEMDEBUG_ALLOC_TYPE_ALLOCA_FUNC             0x0010L
+#define MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN          0x0020L
+#define MEMDEBUG_ALLOC_TYPE_ALLOCA                  0x00F0L
+#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC          0x0100L
+#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC   0x0200L
+#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC          0x0400L
+#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC         0x0800L
+#define MEMDEBUG_ALLOC_TYPE_OBJC_GC                 0x0F00L
+#define MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC             0x1000L
+#define MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC             0x2000L
+#define MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC             0x4000L
+#define MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC            0x8000L
+#define MEMDEBUG_ALLOC_TYPE_ZONE                    0xF000L
+#define MEMDEBUG_ALLOC_TYPE_ARENA_ALLOC             0x10000L
+#define MEMDEBUG_ALLOC_TYPE_ARENA                   0xF0000L
+#define MEMDEBUG_ALLOC_TYPE_MMAP                    0x100000L
+#define MEMDEBUG_ALLOC_TYPE_MREMAP                  0x200000L
+#define MEMDEBUG_ALLOC_TYPE_MAP                     0xF00000L
+
+/* The number of size classes of the histograms (see memdebug_histogram()) */
+#define MEMDEBUG_SIZE_CLASSES 64
+
+/* The identifier of the shared memory statistics page (see memdebug_publish_stats()) */
+#define MEMDEBUG_STATS_MAGIC 0x4D454D44454247UL
+
+/* The number of allocation sites in the shared memory statistics page */
+#define MEMDEBUG_STATS_SITES 16
+
+/* The size of the strings of the allocation sites in the shared memory statistics page */
+#define MEMDEBUG_STATS_NAME_SIZE 64
+
+/* An allocation site in the shared memory statistics page */
+struct memdebug_stats_site
+{
+    char              func[ MEMDEBUG_STATS_NAME_SIZE ];
+    char              file[ MEMDEBUG_STATS_NAME_SIZE ];
+    int               line;
+    unsigned long int live_count;
+    unsigned long int live_size;
+    unsigned long int total_count;
+    unsigned long int total_size;
+};
+
+/*
+ * The shared memory statistics page
+ * 
+ * The page is written with a sequence lock: the sequence is odd while the
+ * page is updated, so a reader copies the page, and retries if the
+ * sequence was odd or has changed in the meantime.
+ */
+struct memdebug_stats
+{
+    unsigned long int           magic;
+    unsigned long int           size;
+    volatile unsigned long int  sequence;
+    long                        pid;
+    unsigned long int           num_objects;
+    unsigned long int           num_active;
+    unsigned long int           num_free;
+    unsigned long int           num_auto;
+    unsigned long int           num_untracked;
+    unsigned long int           num_peak;
+    unsigned long int           memory_total;
+    unsigned long int           memory_active;
+    unsigned long int           memory_peak;
+    unsigned long int           memory_quarantine;
+    unsigned long int           live[ MEMDEBUG_SIZE_CLASSES ];
+    unsigned long int           total[ MEMDEBUG_SIZE_CLASSES ];
+    unsigned long int           num_sites;
+    struct memdebug_stats_site  sites[ MEMDEBUG_STATS_SITES ];
+};
+
+/* The internal phases measured by the self-profiling (see memdebug_self_stats()) */
+#define MEMDEBUG_SELF_INDEX     0
+#define MEMDEBUG_SELF_FENCES    1
+#define MEMDEBUG_SELF_RECORDS   2
+#define MEMDEBUG_SELF_SITES     3
+#define MEMDEBUG_SELF_REPORTS   4
+#define MEMDEBUG_SELF_PHASES    5
+
+/* The time spent inside MEMDebug, by internal phase (MEMDEBUG_SELF_XXX) */
+struct memdebug_self_stats
+{
+    unsigned long int   calls[ MEMDEBUG_SELF_PHASES ];
+    unsigned long long  ticks[ MEMDEBUG_SELF_PHASES ];
+    double              ns[ MEMDEBUG_SELF_PHASES ];
+};
+
+/* Export formats for memdebug_export() */
+#define MEMDEBUG_EXPORT_JSON    1
+#define MEMDEBUG_EXPORT_CSV     2
+
+/* Memory records selected by memdebug_export() */
+#define MEMDEBUG_EXPORT_ALL     0
+#define MEMDEBUG_EXPORT_ACTIVE  1
+#define MEMDEBUG_EXPORT_FREE    2
 
 /* Checks if the alloca function is available */
 #ifdef _ALLOCA_H_
@@ -171,15 +620,66 @@ void * memdebug_malloc_zone_realloc( malloc_zone_t * zone, void * ptr, size_t si
 
 #endif
 
+/* Checks if the memory mapping functions are available */
+#if defined( _SYS_MMAN_H ) || defined( _SYS_MMAN_H_ )
+
+/* Prototypes for the memory mapping functions */
+void * memdebug_mmap( void * addr, size_t length, int prot, int flags, int fd, off_t offset, const char * file, const int line, const char * func );
+int    memdebug_munmap( void * addr, size_t length, const char * file, const int line, const char * func );
+
+/* Checks if the mremap function is available (Linux) */
+#ifdef MREMAP_MAYMOVE
+
+void * memdebug_mremap( void * addr, size_t old_size, size_t new_size, const char * file, const int line, const char * func, int flags, ... );
+
+#endif
+#endif
+
+/* Arena functions */
+unsigned long int memdebug_arena_create( const char * name, int fences );
+void * memdebug_arena_alloc( unsigned long int arena, void * ptr, size_t size, const char * file, const int line, const char * func );
+void   memdebug_arena_free( unsigned long int arena, void * ptr, const char * file, const int line, const char * func );
+void   memdebug_arena_reset( unsigned long int arena, const char * file, const int line, const char * func );
+
 /* Debug output functions */
 void memdebug_print_status( void );
 void memdebug_print_objects( void );
 void memdebug_print_free( void );
 void memdebug_print_active( void );
+void memdebug_print_sites( void );
+void memdebug_print_peak( void );
+void memdebug_print_lifetimes( void );
+void memdebug_print_reallocs( void );
+
+/* Export functions */
+unsigned long int memdebug_export( int fd, int format, int filter );
+unsigned long int memdebug_write_profile( int fd );
 
 /* Informational functions */
 unsigned long int memdebug_num_objects( void );
 unsigned long int memdebug_num_free( void );
 unsigned long int memdebug_num_active( void );
 
+/* Leak checking functions */
+unsigned long int memdebug_check_leaks( void );
+
+/* Statistics functions */
+void memdebug_histogram( unsigned long int alloc_types, unsigned long int * live, unsigned long int * total );
+int memdebug_self_stats( struct memdebug_self_stats * stats );
+
+/* Snapshot functions */
+unsigned long int memdebug_snapshot( void );
+unsigned long int memdebug_snapshot_diff( unsigned long int a, unsigned long int b );
+
+/* Listener functions */
+int memdebug_listen( const char * path );
+int memdebug_publish_stats( const char * name );
+
+/* Capture functions */
+int memdebug_capture( const char * path );
+
+/* Configuration functions */
+void memdebug_set_dump_options( size_t head, size_t tail, int collapse );
+void memdebug_set_leak_threads( unsigned int threads );
+
 #endif /* _MEMDEBUG_H_ */
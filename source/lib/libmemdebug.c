@@ -37,6 +37,17 @@
 #include <ctype.h>
 #include <signal.h>
 #include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <setjmp.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
 
 /* Checks if we are compiling under Mac OS X */
 #if defined( __APPLE__ )
@@ -56,6 +67,17 @@
 
 #endif
 
+/* Checks if we are compiling under Linux */
+#if defined( __linux__ )
+
+/* The leak scanner can find the data segments and stop the other threads */
+#include <link.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#define MEMDEBUG_HAVE_LEAK_SCANNER
+
+#endif
+
 /* Local includes */
 #include "libmemdebug.h"
 
@@ -89,43 +111,184 @@
 /* Macro to check if MEMDebug was inited (if not, it will init it) */
 #define MEMDEBUG_INIT_CHECK if( memdebug_inited == MEMDEBUG_FALSE ) { memdebug_init(); }
 
+/* Macros to protect the memory records from the listener thread (the lock is recursive) */
+#define MEMDEBUG_LOCK   pthread_mutex_lock( &memdebug_lock )
+#define MEMDEBUG_UNLOCK pthread_mutex_unlock( &memdebug_lock )
+
+/* Macros measuring an internal phase, when the self-profiling is enabled (see memdebug_self_stats()) */
+#define MEMDEBUG_SELF_START( start )        ( start ) = ( memdebug_config.self_profile == MEMDEBUG_TRUE ) ? memdebug_ticks() : 0
+#define MEMDEBUG_SELF_END( phase, start )   if( ( start ) != 0 ) { memdebug_self_add( phase, start, 0 ); }
+
 /* Horizontal ruler */
 #define MEMDEBUG_HR "#-----------------------------------------------------------------------------------------------------------------\n"
 
 #define MEMDEBUG_REV "# \n# $Revision$\n# $Date$\n"
 
-/* The supported allocation types */
-#define MEMDEBUG_ALLOC_TYPE_MALLOC                  0x0001L
-#define MEMDEBUG_ALLOC_TYPE_VALLOC                  0x0002L
-#define MEMDEBUG_ALLOC_TYPE_CALLOC                  0x0004L
-#define MEMDEBUG_ALLOC_TYPE_REALLOC                 0x0008L
-#define MEMDEBUG_ALLOC_TYPE_STD                     0x000FL
-#define MEMDEBUG_ALLOC_TYPE_ALLOCA_FUNC             0x0010L
-#define MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN          0x0020L
-#define MEMDEBUG_ALLOC_TYPE_ALLOCA                  0x00F0L
-#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC          0x0100L
-#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC   0x0200L
-#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC          0x0400L
-#define MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC         0x0800L
-#define MEMDEBUG_ALLOC_TYPE_OBJC_GC                 0x0F00L
-#define MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC             0x1000L
-#define MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC             0x2000L
-#define MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC             0x4000L
-#define MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC            0x8000L
-#define MEMDEBUG_ALLOC_TYPE_ZONE                    0xF000L
+/* The number of allocation types (bits of the MEMDEBUG_ALLOC_TYPE_XXX values) */
+#define MEMDEBUG_ALLOC_TYPES 22
+
+/* The allocation types without fences, which are not in the index of the active memory records */
+#define MEMDEBUG_ALLOC_TYPE_UNFENCED ( MEMDEBUG_ALLOC_TYPE_ARENA | MEMDEBUG_ALLOC_TYPE_MAP )
+
+/* Rounds a size to the page size (memory mappings) */
+#define MEMDEBUG_PAGE_ROUND( size ) ( ( ( size_t )( size ) + ( size_t )getpagesize() - 1 ) & ~( ( size_t )getpagesize() - 1 ) )
 
 /* The number of bytes for each line of the memory data dump */
 #define MEMDEBUG_DUMP_BYTES 24
 
+/* The maximum length of a formatted line of the memory data dump */
+#define MEMDEBUG_DUMP_LINE_SIZE ( 19 + ( 4 * MEMDEBUG_DUMP_BYTES ) )
+
+/* The size of the buffer used by the output writer */
+#define MEMDEBUG_WRITER_SIZE 65536
+
+/* Appends a string literal to the buffer of an output writer */
+#define MEMDEBUG_WRITER_LITERAL( writer, str ) memdebug_writer_append( writer, str, sizeof( str ) - 1 )
+
 /* The value of the fence, used to check for buffer overflows */
 #define MEMDEBUG_FENCE_VAL 0x3CC3L
 
+/* The maximum length of a command of the listener */
+#define MEMDEBUG_LISTENER_LINE_SIZE 1024
+
+/* The number of allocation sites printed by the "sites" command of the listener, by default */
+#define MEMDEBUG_LISTENER_SITES 10
+
+/* The initial size of the buffer of an answer of the listener (doubled until the answer fits) */
+#define MEMDEBUG_LISTENER_ANSWER_SIZE 65536
+
+/* The maximum time to wait for a client of the listener to read an answer, in seconds */
+#define MEMDEBUG_LISTENER_TIMEOUT 5
+
+/* The number of updates of the memory records between two refreshes of the size classes and allocation sites of the shared memory statistics page */
+#define MEMDEBUG_STATS_REFRESH 4096
+
+/* The value written to the freed memory areas kept in quarantine */
+#define MEMDEBUG_QUARANTINE_BYTE 0xDD
+
+/* The size of the chunks of the metadata arena, from which the small blocks are carved */
+#define MEMDEBUG_META_CHUNK_SIZE ( 1024 * 1024 )
+
+/* The smallest block of the metadata arena (2^4 bytes) */
+#define MEMDEBUG_META_MIN_CLASS 4
+
+/* The largest block carved from the chunks of the metadata arena (2^16 bytes) - Larger blocks have their own mapping */
+#define MEMDEBUG_META_MAX_CLASS 16
+
+/* Some systems only have the old name of anonymous mappings */
+#if !defined( MAP_ANONYMOUS ) && defined( MAP_ANON )
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+/* The error classes, used to select the action taken on errors */
+#define MEMDEBUG_ERROR_OVERFLOW         0
+#define MEMDEBUG_ERROR_DOUBLE_FREE      1
+#define MEMDEBUG_ERROR_INVALID_POINTER  2
+#define MEMDEBUG_ERROR_ALLOC_FAILURE    3
+#define MEMDEBUG_ERROR_USE_AFTER_FREE   4
+#define MEMDEBUG_ERROR_SIGNAL           5
+#define MEMDEBUG_ERROR_COUNT            6
+
+/* The initial number of slots of the index of the active memory records (must be a power of 2) */
+#define MEMDEBUG_INDEX_SIZE 1024
+
+/* The initial number of slots of the allocation sites table (must be a power of 2) */
+#define MEMDEBUG_SITES_SIZE 256
+
+/* The number of classes of the lifetime histograms */
+#define MEMDEBUG_LIFETIME_CLASSES 64
+
+/* The maximum number of sizes kept in the reallocation history of a memory record (must be a power of 2) */
+#define MEMDEBUG_REALLOC_HISTORY 32
+
+/* The percentage of the reallocation chains of a site fitting in the suggested reserve size */
+#define MEMDEBUG_REALLOC_RESERVE 90
+
+/* The initial size of the archive of the freed memory records, in bytes */
+#define MEMDEBUG_ARCHIVE_SIZE 65536
+
+/* The minimum share of freed memory records in the pool (1/N) for the archival to run (see memdebug_archive_records()) */
+#define MEMDEBUG_ARCHIVE_RATIO 8
+
+/* The number of bits of a word of the bitmaps of the leak scanner */
+#define MEMDEBUG_LEAK_BITS ( sizeof( unsigned long int ) * 8 )
+
+/* Tests a bit of a bitmap of the leak scanner */
+#define MEMDEBUG_LEAK_TEST( bitmap, i ) ( ( bitmap )[ ( i ) / MEMDEBUG_LEAK_BITS ] & ( 1UL << ( ( i ) % MEMDEBUG_LEAK_BITS ) ) )
+
+/* The capacity of the stack of each worker of the leak scanner */
+#define MEMDEBUG_LEAK_STACK_SIZE 65536
+
+/* The phases of the worker threads of the leak scanner */
+#define MEMDEBUG_LEAK_PHASE_WAIT 0
+#define MEMDEBUG_LEAK_PHASE_MARK 1
+
+/* The maximum number of threads stopped by the leak scanner */
+#define MEMDEBUG_LEAK_THREADS 1024
+
+/* The signal used by the leak scanner to stop the other threads */
+#ifdef SIGPWR
+#define MEMDEBUG_LEAK_SIGNAL SIGPWR
+#else
+#define MEMDEBUG_LEAK_SIGNAL SIGXCPU
+#endif
+
+/* The maximum time to wait for the other threads to stop, in milliseconds */
+#define MEMDEBUG_LEAK_TIMEOUT 2000
+
+/* Checks if we are using GCC */
+#ifdef __GNUC__
+
+/* The address of the code calling a MEMDebug function */
+#define MEMDEBUG_CALLER __builtin_return_address( 0 )
+
+/* Keeps the frames walked by __builtin_return_address() when optimizing */
+#define MEMDEBUG_NOINLINE __attribute__( ( noinline ) )
+
+/* Compiles a function in each of its callers, so its constant arguments remove its unused code */
+#define MEMDEBUG_ALWAYS_INLINE __inline__ __attribute__( ( always_inline ) )
+
+#else
+
+/* The calling code is unknown */
+#define MEMDEBUG_CALLER NULL
+
+/* No inlining control */
+#define MEMDEBUG_NOINLINE
+#define MEMDEBUG_ALWAYS_INLINE
+
+#endif
+
+/* The actions taken on errors */
+#define MEMDEBUG_ACTION_ASK             0
+#define MEMDEBUG_ACTION_CONTINUE        1
+#define MEMDEBUG_ACTION_LOG             2
+#define MEMDEBUG_ACTION_ABORT           3
+#define MEMDEBUG_ACTION_CORE            4
+#define MEMDEBUG_ACTION_COUNT           5
+
 /* The size of the fence value  */
 #define MEMDEBUG_FENCE_SIZE sizeof( memdebug_fence )
 
 /* The size of an allocation, plus the two fences values */
 #define MEMDEBUG_ALLOC_SIZE( size ) ( size ) + ( 2 * MEMDEBUG_FENCE_SIZE )
 
+/* The size of the fences of the lower feature levels (only the fences level has fences) */
+#define MEMDEBUG_LIGHT_FENCE_SIZE( level ) ( ( ( level ) == MEMDEBUG_LEVEL_FENCES ) ? MEMDEBUG_FENCE_SIZE : 0 )
+
+/* The size of the header of a memory area of the lower feature levels, rounded so the memory areas keep the alignment of malloc() */
+#define MEMDEBUG_LIGHT_HEADER_SIZE ( ( sizeof( struct memdebug_light ) + 15 ) & ~( ( size_t )15 ) )
+
+/* The offset of a memory area of the lower feature levels from its header, which is placed before the leading fence */
+#define MEMDEBUG_LIGHT_OFFSET( level ) ( MEMDEBUG_LIGHT_HEADER_SIZE + MEMDEBUG_LIGHT_FENCE_SIZE( level ) )
+
+/* The size of an allocation of the lower feature levels, plus the header and the fences */
+#define MEMDEBUG_LIGHT_SIZE( level, size ) ( MEMDEBUG_LIGHT_OFFSET( level ) + ( size ) + MEMDEBUG_LIGHT_FENCE_SIZE( level ) )
+
+/* The magic numbers of the header of an allocation of the lower feature levels, while it is active, and once it is freed */
+#define MEMDEBUG_LIGHT_MAGIC       0x4D454D44U
+#define MEMDEBUG_LIGHT_MAGIC_FREED 0x46524545U
+
 /* Definition of the type for the allocation type */
 typedef unsigned long int memdebug_alloc_type;
 
@@ -168,6 +331,33 @@ struct memdebug_object
     /* The name of the function in which the object was freed */
     const char * free_func;
     
+    /* The sequence number of the allocation (see memdebug_snapshot()) */
+    unsigned long int alloc_seq;
+    
+    /* The sequence number of the deallocation */
+    unsigned long int free_seq;
+    
+    /* The allocation site (position in the allocation sites table) */
+    unsigned long int site;
+    
+    /* The time of the allocation, in ticks (see memdebug_ticks()) */
+    unsigned long long alloc_time;
+    
+    /* The arena of the allocation (see memdebug_arena_create()), or 0 */
+    unsigned long int arena;
+    
+    /* The generation of the arena in which the allocation was made */
+    unsigned long int generation;
+    
+    /* The number of reallocations of the memory area */
+    unsigned long int realloc_count;
+    
+    /* The bytes copied by the reallocations which moved the memory area */
+    size_t realloc_copied;
+    
+    /* The successive sizes of the memory area, starting with the allocated size (MEMDEBUG_REALLOC_HISTORY at most), or NULL if it was never reallocated */
+    size_t * realloc_sizes;
+    
     /* Checks if we are using GCC */
     #ifdef __GNUC__
     
@@ -206,1827 +396,11015 @@ struct memdebug_pool
     
     /* The memory usage of active (non-freed) memory records */
     size_t memory_active;
+    
+    /* The number of allocations which were not recorded (sampling) */
+    unsigned long int num_untracked;
+    
+    /* The number of allocations which were not recorded, as the metadata reached its budget (meta_limit option) */
+    unsigned long int num_over_limit;
+    
+    /* The sequence number of the next allocation or deallocation */
+    unsigned long int sequence;
+    
+    /* The highest number of active memory records */
+    unsigned long int num_peak;
+    
+    /* The time at which the highest number of active memory records was reached */
+    struct timeval num_peak_time;
+    
+    /* The highest active memory */
+    size_t memory_peak;
+    
+    /* The time at which the highest active memory was reached */
+    struct timeval memory_peak_time;
 };
 
-/* Prototypes for the internal (private) functions */
-static void memdebug_fatal( const char * format, ... );
-static void memdebug_init( void );
-static struct memdebug_object * memdebug_new_object( void * ptr, size_t size, const char * file, const int line, const char * func, memdebug_alloc_type alloc_type );
-static void memdebug_update_object( void * ptr, void * ptr_new, size_t size, const char * file, const int line, const char * func, memdebug_alloc_type alloc_type );
-static void memdebug_free_object( void * ptr, const char * file, const int line, const char * func );
-static struct memdebug_object * memdebug_get_object( void * ptr );
-static void memdebug_write_fence( struct memdebug_object * object );
-static memdebug_bool memdebug_check_fence( struct memdebug_object * object );
-static void memdebug_dump( struct memdebug_object * object );
-static void memdebug_ask_debug_cmd( void );
-static void memdebug_sig_handler( int id );
-static void memdebug_warning( const char * str, const char * file, const int line, const char * func, ... );
-static void memdebug_print_object( struct memdebug_object * object );
-
-/* Checks if we can have a backtrace */
-#ifdef MEMDEBUG_HAVE_EXECINFO_H
-static void memdebug_backtrace( unsigned int skip_levels );
-#endif
-
-/* Whether MEMDebug has been inited or not */
-static memdebug_bool memdebug_inited;
-
-/* The MEMDebug memory record pool */
-static struct memdebug_pool * memdebug_trace;
-
-/**
- * Internal fatal error
- * 
- * @param   const char *    The error message
- * @param   ...             The format parameters, if any
- */
-static void memdebug_fatal( const char * format, ... )
+/* Structure for the index of the active memory records, by address */
+struct memdebug_index
 {
-    va_list ap;
-    
-    /* Gets the variable arguments */
-    va_start( ap, format );
+    /* The slots (open addressing with linear probing), holding memory record numbers plus one (0 is an empty slot) */
+    unsigned long int * slots;
     
-    /* Prints the error message */
-    vprintf( format, ap );
+    /* The number of slots (a power of 2) */
+    unsigned long int capacity;
     
-    /* Aborts the program execution */
-    va_end( ap );
-    exit( EXIT_FAILURE );
-}
+    /* The number of used slots */
+    unsigned long int count;
+};
 
-/**
- * Initializes MEMDebug
- * 
- * @return  void
- */
-static void memdebug_init( void )
+/* Structure for the counters of an allocation site */
+struct memdebug_site
 {
-    struct sigaction sa1;
-    struct sigaction sa2;
+    /* The name of the file in which the allocations are made */
+    const char * file;
     
-    /* Nothing to do if MEMDebug is already initialized */
-    if( memdebug_inited == MEMDEBUG_TRUE )
-    {
-        return;
-    }
+    /* The line of the file in which the allocations are made */
+    int line;
     
-    /* Signal handling */
-    sa1.sa_handler = memdebug_sig_handler;
-    sa1.sa_flags   = 0;
-    sigemptyset( &sa1.sa_mask );
+    /* The name of the function in which the allocations are made */
+    const char * func;
     
-    /* Handles segmentation faults ( SIGSEGV ) */
-    if( sigaction( SIGSEGV, &sa1, &sa2 ) != 0 )
-    {
-        memdebug_fatal
-        (
-            "MEMDebug error: cannot set a handler for SIGSEGV\n"
-        );
-    }
+    /* The address of the code making the first allocation, used as stack in the heap profiles */
+    void * caller;
     
-    /* Handles bus errors ( SIGBUS ) */
-    if( sigaction( SIGBUS, &sa1, &sa2 ) != 0 )
-    {
-        memdebug_fatal
-        (
-            "MEMDebug error: cannot set a handler for SIGBUS\n"
-        );
-    }
+    /* The number of active allocations */
+    unsigned long int live_count;
     
-    /* Allocates the memory record pool structure */
-    if( NULL == ( memdebug_trace = ( struct memdebug_pool * )calloc( 1, sizeof( struct memdebug_pool ) ) ) )
-    {
-        memdebug_fatal
-        (
-            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
-            strerror( errno )
-        );
-    }
+    /* The active memory */
+    size_t live_size;
     
-    /* Allocates room for memory record objects */
-    if( NULL == ( memdebug_trace->objects = ( struct memdebug_object * )calloc( MEMDEBUG_POOL_SIZE, sizeof( struct memdebug_object ) ) ) )
-    {
-        memdebug_fatal
-        (
-            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
-            strerror( errno )
-        );
-    }
+    /* The total number of allocations */
+    unsigned long int total_count;
     
-    /* Pool initialization */
-    memdebug_trace->num_objects   = 0;
-    memdebug_trace->num_active    = 0;
-    memdebug_trace->num_free      = 0;
-    memdebug_trace->memory_total  = 0;
-    memdebug_trace->memory_active = 0;
-    memdebug_trace->pool_size     = MEMDEBUG_POOL_SIZE;
-    memdebug_inited               = MEMDEBUG_TRUE;
-}
+    /* The total allocated memory */
+    size_t total_size;
+    
+    /* The highest active memory */
+    size_t peak_size;
+    
+    /* The number of active allocations at the last peak snapshot */
+    unsigned long int snapshot_count;
+    
+    /* The active memory at the last peak snapshot */
+    size_t snapshot_size;
+    
+    /* Whether the active counters changed since the last peak snapshot (see memdebug_peak_touch()) */
+    memdebug_bool snapshot_changed;
+    
+    /* The lifetimes of the freed allocations - The class N holds the lifetimes from 2^N to 2^(N+1) - 1 ticks */
+    unsigned long int lifetimes[ MEMDEBUG_LIFETIME_CLASSES ];
+    
+    /* The number of reallocations made at the site */
+    unsigned long int realloc_count;
+    
+    /* The number of reallocations made at the site which moved the memory area */
+    unsigned long int realloc_moves;
+    
+    /* The bytes copied by the reallocations made at the site */
+    size_t realloc_copied;
+    
+    /* The largest size requested by a reallocation made at the site */
+    size_t realloc_max;
+    
+    /* The final sizes of the freed memory areas last reallocated at the site - The class N holds the sizes from 2^N to 2^(N+1) - 1 bytes */
+    unsigned long int realloc_sizes[ MEMDEBUG_SIZE_CLASSES ];
+};
 
-/**
- * Creates a new memory record object in the pool
- * 
- * @param   void *                      The pointer to the allocated memory area
- * @param   size_t                      The size of the allocated memory area
- * @param   const char *                The file in which the allocation was made
- * @param   const int                   The line of the file in which the allocation was made
- * @param   const char *                The name of the function in which the allocation was made
- * @param   const char *                The allocation type (MEMDEBUG_ALLOC_TYPE_XXX)
- * @return  struct memdebug_object *    The new memory record object
- */
-static struct memdebug_object * memdebug_new_object( void * ptr, size_t size, const char * file, const int line, const char * func, memdebug_alloc_type alloc_type )
+/* Structure for the allocation sites table */
+struct memdebug_sites
 {
-    struct memdebug_object * object;
+    /* The allocation sites, in order of appearance */
+    struct memdebug_site * sites;
     
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    /* The number of allocation sites */
+    unsigned long int count;
     
-    /* Checks there's enough room in the current pool for a new object */
-    if( memdebug_trace->pool_size == memdebug_trace->num_objects )
-    {
-        /* No, let's reallocate some memory */
-        if( NULL == ( memdebug_trace->objects = ( struct memdebug_object * )realloc( memdebug_trace->objects, memdebug_trace->pool_size + MEMDEBUG_POOL_SIZE ) ) )
-        {
-            memdebug_fatal
-            (
-                "MEMDebug error: cannot reallocate the MEMDebug pool. Reason: %s\n",
-                strerror( errno )
-            );
-        }
-        
-        /* Sets the new pool size */
-        memdebug_trace->pool_size += MEMDEBUG_POOL_SIZE;
-    }
+    /* The number of allocated allocation sites */
+    unsigned long int size;
     
-    /* Increments the counter as we have a new object */
-    memdebug_trace->num_objects++;
+    /* The hash table slots (open addressing with linear probing), holding site numbers plus one (0 is an empty slot) */
+    unsigned long int * slots;
     
-    object = &memdebug_trace->objects[ memdebug_trace->num_objects - 1 ];
+    /* The number of slots (a power of 2) */
+    unsigned long int capacity;
+};
+
+/* Structure for the reference point of the clock of the lifetimes */
+struct memdebug_clock
+{
+    /* The ticks at the initialization */
+    unsigned long long ticks;
     
-    object->ptr        = ptr;
-    object->size       = size;
-    object->alloc_file = file;
-    object->alloc_line = line;
-    object->alloc_func = func;
-    object->alloc_type = alloc_type;
+    /* The time at the initialization */
+    struct timeval time;
+};
+
+/* Structure for an active memory area, for the leak scanner */
+struct memdebug_leak_block
+{
+    /* The start of the memory area */
+    const char * start;
     
-    /* Checks if the object is autamatically freed (alloca or GC functions) */
-    if( alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA || alloc_type & MEMDEBUG_ALLOC_TYPE_OBJC_GC )
-    {
-        /* The object will be automatically freed */
-        object->free = MEMDEBUG_TRUE;
-        memdebug_trace->num_auto++;
-        
-    }
-    else
-    {
-        /* The object will need to be manually freed */
-        object->free = MEMDEBUG_FALSE;
-        memdebug_trace->num_active++;
-    }
+    /* The end of the memory area */
+    const char * end;
     
-    /* Checks if we are using GCC */
-    #ifdef __GNUC__
+    /* The memory record number */
+    unsigned long int record;
+};
+
+/* Structure for a memory range scanned for pointers (data segment or stack) */
+struct memdebug_leak_range
+{
+    /* The start of the range */
+    const char * start;
     
-    /* Stores the address of the caller function */
-    object->alloc_func_addr = __builtin_return_address( 2 );
+    /* The end of the range */
+    const char * end;
+};
+
+/* Structure for a worker thread of the mark phase of the leak scanner */
+struct memdebug_leak_worker
+{
+    /* The thread (unused for the first worker, which is the calling thread) */
+    pthread_t thread;
     
-    #endif
+    /* The lock of the stack, as other workers may steal from it */
+    pthread_mutex_t lock;
     
-    /* Checks if the allocation was made using dynamic memory */
-    if( !( alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA ) )
-    {
-        /* Updates the memory usage */
-        memdebug_trace->memory_total  += size;
-        memdebug_trace->memory_active += size;
-    }
+    /* The memory areas to scan (positions in the blocks array) */
+    unsigned long int stack[ MEMDEBUG_LEAK_STACK_SIZE ];
     
-    memdebug_write_fence( object );
+    /* The number of memory areas to scan */
+    unsigned long int depth;
     
-    /* Returns the new object */
-    return object;    
-}
+    /* The system thread identifier, so the thread is not stopped */
+    long tid;
+    
+    /* The number of scanned memory areas */
+    unsigned long int scanned;
+};
 
-/**
- * Updates an existing memory record object in the pool
- * 
- * @param   void *          The address of the memory area corresponding to the memory record object
- * @param   void *          The new address of the memory area for the memory record object
- * @param   size_t          The size of the allocated memory area
- * @param   const char *    The file in which the allocation was made
- * @param   const int       The line of the file in which the allocation was made
- * @param   const char *    The name of the function in which the allocation was made
- * @param   const char *    The allocation type (MEMDEBUG_ALLOC_TYPE_XXX)
- * @return  void
- */
-static void memdebug_update_object( void * ptr, void * ptr_new, size_t size, const char * file, const int line, const char * func, memdebug_alloc_type alloc_type )
+/* Structure for the state of the leak scanner */
+struct memdebug_leaks
 {
-    struct memdebug_object * object;
+    /* The active memory areas, sorted by address (the interval index) */
+    struct memdebug_leak_block * blocks;
     
-    /* Checks if the address we are trying to reallocate exists in the pool */
-    if( NULL == ( object = memdebug_get_object( ptr ) ) )
-    {
-        memdebug_warning
-        (
-            "Trying to reallocate a non-existing object (pointer address: %p)",
+    /* The number of active memory areas */
+    unsigned long int count;
+    
+    /* The bitmap of the reachable memory areas */
+    unsigned long int * reachable;
+    
+    /* The bitmap of the memory areas referenced by leaked memory areas */
+    unsigned long int * indirect;
+    
+    /* The memory areas to scan which do not fit on the stacks of the workers */
+    unsigned long int * overflow;
+    
+    /* The number of memory areas on the overflow stack */
+    unsigned long int overflow_depth;
+    
+    /* The lock of the overflow stack */
+    pthread_mutex_t overflow_lock;
+    
+    /* The workers of the mark phase */
+    struct memdebug_leak_worker * workers;
+    
+    /* The number of workers */
+    unsigned int num_workers;
+    
+    /* The number of started worker threads */
+    volatile int ready;
+    
+    /* The phase of the worker threads (MEMDEBUG_LEAK_PHASE_XXX) */
+    volatile int phase;
+    
+    /* The number of memory areas pushed and not yet scanned */
+    volatile long pending;
+    
+    /* The duration of the mark phase, in ticks (see memdebug_ticks()) */
+    unsigned long long mark_ticks;
+    
+    /* The data segments */
+    struct memdebug_leak_range * roots;
+    
+    /* The number of data segments */
+    unsigned long int num_roots;
+    
+    /* The number of allocated data segments */
+    unsigned long int size_roots;
+    
+    /* The memory map of the process (/proc/self/maps), to find the ends of the stacks */
+    char * maps;
+    
+    /* The size of the buffer of the memory map */
+    size_t maps_size;
+    
+    /* The stack pointers of the stopped threads */
+    void * volatile stacks[ MEMDEBUG_LEAK_THREADS ];
+    
+    /* The number of stopped threads */
+    volatile int stopped;
+    
+    /* The number of threads in the stop signal handler */
+    volatile int running;
+    
+    /* Whether the stopped threads can resume */
+    volatile int resume;
+    
+    /* The threads sent the stop signal (reset to zero once a thread has handled it) */
+    volatile long tids[ MEMDEBUG_LEAK_THREADS ];
+    
+    /* The number of threads sent the stop signal */
+    unsigned long int num_tids;
+    
+    /* The action of the stop signal before the scan, restored once no thread can receive it anymore */
+    struct sigaction previous_action;
+    
+    /* Whether the handler of the stop signal is installed */
+    int installed;
+};
+
+/* Structure for the size-class histograms, by allocation type (bit number of MEMDEBUG_ALLOC_TYPE_XXX) */
+struct memdebug_histograms
+{
+    /* The number of active allocations */
+    unsigned long int live[ MEMDEBUG_ALLOC_TYPES ][ MEMDEBUG_SIZE_CLASSES ];
+    
+    /* The total number of allocations */
+    unsigned long int total[ MEMDEBUG_ALLOC_TYPES ][ MEMDEBUG_SIZE_CLASSES ];
+};
+
+/* Structure for the allocations of a single site, used by the reports */
+struct memdebug_site_stats
+{
+    /* The name of the file in which the allocations were made */
+    const char * file;
+    
+    /* The line of the file in which the allocations were made */
+    int line;
+    
+    /* The name of the function in which the allocations were made */
+    const char * func;
+    
+    /* The allocation site number, when the reports sort the sites of the table */
+    unsigned long int site;
+    
+    /* The number of allocations */
+    unsigned long int count;
+    
+    /* The allocated memory */
+    size_t size;
+};
+
+/* Structure for the snapshot of the active memory of each allocation site, at the peak of the active memory (the values are kept by the sites) */
+struct memdebug_peak
+{
+    /* The numbers of the allocation sites whose active counters changed since the last snapshot */
+    unsigned long int * changed;
+    
+    /* The number of changed allocation sites */
+    unsigned long int num_changed;
+    
+    /* The number of allocated changed allocation sites */
+    unsigned long int size;
+    
+    /* The number of active memory records at the time of the snapshot */
+    unsigned long int num_active;
+    
+    /* The active memory at the time of the snapshot */
+    size_t memory_active;
+    
+    /* The time of the snapshot */
+    struct timeval time;
+    
+    /* Whether a snapshot was taken */
+    memdebug_bool taken;
+    
+    /* Whether a new peak was reached since the last snapshot */
+    memdebug_bool pending;
+};
+
+/* Header of a block of the metadata arena */
+struct memdebug_meta_header
+{
+    /* The requested size */
+    size_t size;
+    
+    /* The size of the block, including the header (a power of two, or the size of the mapping) */
+    size_t capacity;
+};
+
+/* Structure for the metadata arena, holding the memory used by MEMDebug itself */
+struct memdebug_meta
+{
+    /* The current chunk, from which the small blocks are carved */
+    char * chunk;
+    
+    /* The number of bytes carved from the current chunk */
+    size_t chunk_used;
+    
+    /* The free small blocks, for each size class */
+    void * free_blocks[ MEMDEBUG_META_MAX_CLASS + 1 ];
+    
+    /* The number of mapped bytes */
+    size_t mapped;
+    
+    /* The highest number of mapped bytes */
+    size_t mapped_peak;
+    
+    /* The number of bytes of the allocated blocks, including the headers and the rounding */
+    size_t used;
+    
+    /* The number of bytes requested for the allocated blocks */
+    size_t requested;
+    
+    /* The number of allocated blocks */
+    unsigned long int blocks;
+    
+    /* The number of mappings */
+    unsigned long int mappings;
+};
+
+/* Structure for an instrumented arena (see memdebug_arena_create()) */
+struct memdebug_arena
+{
+    /* The name of the arena */
+    const char * name;
+    
+    /* Whether the allocations of the arena have fences */
+    memdebug_bool fences;
+    
+    /* The current generation, incremented by each reset */
+    unsigned long int generation;
+    
+    /* The number of active allocations of the current generation */
+    unsigned long int num_active;
+    
+    /* The memory size of the active allocations of the current generation */
+    size_t memory_active;
+    
+    /* The sequence number of the last reset */
+    unsigned long int reset_seq;
+    
+    /* The name of the file in which the last reset was made */
+    const char * reset_file;
+    
+    /* The line of the file in which the last reset was made */
+    int reset_line;
+    
+    /* The name of the function in which the last reset was made */
+    const char * reset_func;
+};
+
+/* Structure for the instrumented arenas */
+struct memdebug_arenas
+{
+    /* The arenas (the arena identifiers start at 1) */
+    struct memdebug_arena * arenas;
+    
+    /* The number of arenas */
+    unsigned long int count;
+    
+    /* The index of the active arena memory records */
+    struct memdebug_index index;
+    
+    /* The number of memory records left active by the resets, not retired yet */
+    unsigned long int stale;
+};
+
+/* Structure for the active memory mappings (see memdebug_mmap()) */
+struct memdebug_mappings
+{
+    /* The memory record numbers of the active mappings */
+    unsigned long int * records;
+    
+    /* The number of active mappings */
+    unsigned long int count;
+    
+    /* The size of the records array */
+    unsigned long int capacity;
+    
+    /* The total mapped memory */
+    size_t memory_total;
+    
+    /* The active mapped memory */
+    size_t memory_active;
+    
+    /* The highest active mapped memory */
+    size_t memory_peak;
+};
+
+/* Structure for a call site of the archive of the freed memory records */
+struct memdebug_archive_site
+{
+    /* The name of the file of the call */
+    const char * file;
+    
+    /* The line of the file of the call */
+    int line;
+    
+    /* The name of the function of the call */
+    const char * func;
+};
+
+/* Structure for the archive of the oldest freed memory records, packed when the metadata exceeds its budget (meta_limit option) */
+struct memdebug_archive
+{
+    /* The packed memory records (see memdebug_archive_add()) */
+    unsigned char * data;
+    
+    /* The number of bytes of packed memory records */
+    size_t size;
+    
+    /* The size of the data buffer */
+    size_t capacity;
+    
+    /* The number of archived memory records */
+    unsigned long int count;
+    
+    /* The number of oldest archived memory records dropped to stay within the budget (see memdebug_archive_trim()) */
+    unsigned long int dropped;
+    
+    /* The address and the allocation sequence number the first archived memory record is delta-encoded from */
+    size_t first_ptr;
+    unsigned long int first_seq;
+    
+    /* The address of the last archived memory record (the addresses are delta-encoded) */
+    size_t last_ptr;
+    
+    /* The allocation sequence number of the last archived memory record (the sequence numbers are delta-encoded) */
+    unsigned long int last_seq;
+    
+    /* The call sites of the archived memory records, in order of appearance */
+    struct memdebug_archive_site * sites;
+    
+    /* The number of call sites */
+    unsigned long int num_sites;
+    
+    /* The number of allocated call sites */
+    unsigned long int sites_size;
+    
+    /* The hash table slots (open addressing with linear probing), holding call site numbers plus one (0 is an empty slot) */
+    unsigned long int * slots;
+    
+    /* The number of slots (a power of 2) */
+    unsigned long int slots_capacity;
+};
+
+/* Structure for the position of a reader of the archive of the freed memory records */
+struct memdebug_archive_cursor
+{
+    /* The offset of the next packed memory record */
+    size_t offset;
+    
+    /* The address of the previous memory record */
+    size_t ptr;
+    
+    /* The allocation sequence number of the previous memory record */
+    unsigned long int seq;
+};
+
+/* Structure for the runtime options (MEMDEBUG_OPTIONS environment variable) */
+struct memdebug_options
+{
+    /* Whether the allocations are traced at all */
+    memdebug_bool enabled;
+    
+    /* Only one allocation out of sample_rate is recorded */
+    unsigned long int sample_rate;
+    
+    /* The maximum amount of freed memory kept in quarantine */
+    size_t quarantine_size;
+    
+    /* Whether the active memory of each allocation site is saved when a new peak is reached */
+    memdebug_bool peak_snapshot;
+    
+    /* Whether the leaks are checked at exit */
+    memdebug_bool leak_check;
+    
+    /* The number of threads of the mark phase of the leak scanner */
+    unsigned int leak_threads;
+    
+    /* The path of the socket of the listener (empty if not listening) */
+    char socket_path[ 256 ];
+    
+    /* The name of the shared memory statistics page (empty if not published) */
+    char stats_name[ 256 ];
+    
+    /* The signal requesting a dump of the active memory records (0 if none) */
+    int dump_signal;
+    
+    /* The directory of the dumps of the active memory records */
+    char dump_dir[ 256 ];
+    
+    /* Whether the full reports are written by a child process */
+    memdebug_bool fork_reports;
+    
+    /* The memory budget of the metadata, in bytes, over which the oldest freed memory records are archived (0 means no limit) */
+    size_t meta_limit;
+    
+    /* The path of the capture file of the allocation sequence (empty if not capturing) */
+    char capture_path[ 256 ];
+    
+    /* Whether the time spent in the internal phases is measured */
+    memdebug_bool self_profile;
+    
+    /* The action taken for each error class (MEMDEBUG_ACTION_XXX) */
+    int actions[ MEMDEBUG_ERROR_COUNT ];
+};
+
+/* Structure for the listener thread, answering commands on a Unix domain socket */
+struct memdebug_listener
+{
+    /* The listener thread */
+    pthread_t thread;
+    
+    /* The listening socket */
+    int fd;
+    
+    /* The path of the socket */
+    struct sockaddr_un address;
+    
+    /* Whether the listener is running */
+    memdebug_bool running;
+};
+
+/* Structure for the publication of the statistics in shared memory */
+struct memdebug_publisher
+{
+    /* The shared memory statistics page (NULL if not published) */
+    struct memdebug_stats * stats;
+    
+    /* The name of the shared memory object */
+    char name[ 256 ];
+    
+    /* The number of updates since the last refresh of the size classes and allocation sites */
+    unsigned long int updates;
+};
+
+/* Structure for the dumps of the active memory records requested by a signal */
+struct memdebug_dumper
+{
+    /* The thread writing the dumps */
+    pthread_t thread;
+    
+    /* The pipe waking the thread up, written by the signal handler */
+    int pipe[ 2 ];
+    
+    /* Whether a dump was requested (set by the signal handler) */
+    volatile sig_atomic_t requested;
+};
+
+/* Structure for the quarantine of the freed memory areas */
+struct memdebug_quarantine
+{
+    /* The numbers of the quarantined memory records, as a circular buffer */
+    unsigned long int * records;
+    
+    /* The capacity of the circular buffer */
+    unsigned long int capacity;
+    
+    /* The index of the oldest quarantined memory record */
+    unsigned long int head;
+    
+    /* The number of quarantined memory records */
+    unsigned long int count;
+    
+    /* The amount of quarantined memory */
+    size_t size;
+};
+
+/* Structure for the buffered output writer */
+struct memdebug_writer
+{
+    /* The file descriptor the buffered data is written to */
+    int fd;
+    
+    /* The number of bytes currently in the buffer */
+    size_t length;
+    
+    /* The buffered data */
+    char data[ MEMDEBUG_WRITER_SIZE ];
+};
+
+/* Structure for the self-profiling counters (see memdebug_self_stats()) */
+struct memdebug_self
+{
+    /* The number of measures of each phase (MEMDEBUG_SELF_XXX) */
+    unsigned long int calls[ MEMDEBUG_SELF_PHASES ];
+    
+    /* The ticks spent in each phase */
+    unsigned long long ticks[ MEMDEBUG_SELF_PHASES ];
+    
+    /* The ticks spent in the phases nested in the record updates, which are not accounted twice */
+    unsigned long long nested;
+};
+
+/* Structure for the capture of the allocation sequence, to be replayed by memdebug-replay */
+struct memdebug_capturer
+{
+    /* The writer of the capture file (NULL if not capturing) */
+    struct memdebug_writer * writer;
+    
+    /* The key of the number of the calling thread */
+    pthread_key_t thread_key;
+    
+    /* Whether the key of the thread numbers was created */
+    memdebug_bool has_key;
+    
+    /* The number of threads seen by the capture */
+    unsigned long int num_threads;
+    
+    /* The number of captured operations */
+    unsigned long int count;
+};
+
+/* Structure for the header of the memory areas of the lower feature levels (see MEMDEBUG_LEVEL) */
+struct memdebug_light
+{
+    /* The size of the memory area */
+    size_t size;
+    
+    /* The allocation site number */
+    unsigned int site;
+    
+    /* The offset of the memory area from the start of the allocated block */
+    unsigned int offset;
+    
+    /* The magic number (MEMDEBUG_LIGHT_MAGIC, or MEMDEBUG_LIGHT_MAGIC_FREED once freed), last as the allocator may reuse the start of a freed block */
+    unsigned int magic;
+};
+
+/* Prototypes for the internal (private) functions */
+static void memdebug_fatal( const char * format, ... );
+static void memdebug_init( void );
+static void memdebug_parse_options( const char * options );
+static void * memdebug_meta_map( size_t size );
+static void memdebug_meta_unmap( void * ptr, size_t size );
+static void * memdebug_meta_alloc( size_t size );
+static void * memdebug_meta_realloc( void * ptr, size_t size );
+static void memdebug_meta_free( void * ptr );
+static size_t memdebug_meta_growth( void * ptr, size_t size );
+static void memdebug_set_option( const char * name, const char * value );
+static int memdebug_parse_action( const char * value );
+static MEMDEBUG_NOINLINE struct memdebug_object * memdebug_new_object( void * ptr, size_t size, const char * file, const int line, const char * func, void * caller, memdebug_alloc_type alloc_type );
+static MEMDEBUG_NOINLINE void memdebug_update_object( struct memdebug_object * object, void * ptr_new, size_t size, const char * file, const int line, const char * func, void * caller, memdebug_alloc_type alloc_type );
+static void memdebug_realloc_add( struct memdebug_object * object, void * ptr_new, size_t size );
+static MEMDEBUG_NOINLINE struct memdebug_object * memdebug_free_object( void * ptr, const char * file, const int line, const char * func );
+static struct memdebug_object * memdebug_check_object( void * ptr, const char * operation, const char * file, const int line, const char * func );
+static struct memdebug_object * memdebug_get_object( void * ptr );
+static void memdebug_arena_release( struct memdebug_object * object, const char * file, const int line, const char * func );
+static void memdebug_arena_retire( struct memdebug_object * object );
+static void memdebug_arena_retire_all( void );
+static void memdebug_mapping_add( struct memdebug_object * object );
+static void memdebug_mapping_resize( struct memdebug_object * object, void * ptr, size_t size );
+static void memdebug_mapping_unmap( char * start, char * end, const char * file, const int line, const char * func );
+static void memdebug_archive_records( void );
+static void memdebug_archive_trim( size_t growth );
+static void memdebug_archive_rewind( struct memdebug_archive_cursor * cursor );
+static void memdebug_archive_add( struct memdebug_object * object );
+static void memdebug_archive_put( size_t value );
+static size_t memdebug_archive_get( struct memdebug_archive_cursor * cursor );
+static unsigned long int memdebug_archive_site( const char * file, const int line, const char * func );
+static memdebug_bool memdebug_archive_next( struct memdebug_archive_cursor * cursor, struct memdebug_object * object );
+static struct memdebug_object * memdebug_archive_find( void * ptr, unsigned long int arena );
+static void memdebug_print_archive( void );
+static memdebug_bool memdebug_is_tracked( void * ptr );
+static memdebug_bool memdebug_calloc_size( size_t size1, size_t size2, size_t * size );
+static void memdebug_quarantine_push( struct memdebug_object * object );
+static void memdebug_quarantine_pop( void );
+static unsigned long int memdebug_index_slot( struct memdebug_index * table, void * ptr );
+static void memdebug_index_insert( struct memdebug_index * table, struct memdebug_object * object );
+static void memdebug_index_remove( struct memdebug_index * table, void * ptr );
+static struct memdebug_object * memdebug_index_find( struct memdebug_index * table, void * ptr );
+static int memdebug_site_stats_compare( const void * a, const void * b );
+static unsigned long int memdebug_site_hash( const char * file, const int line, const char * func, unsigned long int capacity );
+static unsigned long int memdebug_site_get( const char * file, const int line, const char * func, void * caller );
+static void memdebug_site_add( unsigned long int site, size_t size );
+static void memdebug_site_remove( unsigned long int site, size_t size );
+static unsigned int memdebug_log2( unsigned long long value );
+static unsigned long long memdebug_ticks( void );
+static double memdebug_tick_ns( void );
+static void memdebug_format_duration( double ns, char * str, size_t length );
+static unsigned long int memdebug_site_freed( struct memdebug_site * site );
+static unsigned int memdebug_site_median_lifetime( struct memdebug_site * site );
+static int memdebug_site_lifetime_compare( const void * a, const void * b );
+static void memdebug_peak_check( void );
+static void memdebug_peak_touch( unsigned long int site );
+static void memdebug_peak_release( void );
+static void memdebug_peak_save( void );
+static void memdebug_format_time( const struct timeval * time, char * str, size_t length );
+static unsigned int memdebug_type_index( memdebug_alloc_type alloc_type );
+static void memdebug_write_fence( struct memdebug_object * object );
+static memdebug_bool memdebug_check_fence( struct memdebug_object * object );
+static void memdebug_writer_init( struct memdebug_writer * writer, int fd );
+static void memdebug_writer_flush( struct memdebug_writer * writer );
+static char * memdebug_writer_reserve( struct memdebug_writer * writer, size_t length );
+static void memdebug_writer_append( struct memdebug_writer * writer, const char * str, size_t length );
+static void memdebug_writer_append_ulong( struct memdebug_writer * writer, unsigned long int value );
+static void memdebug_writer_append_pointer( struct memdebug_writer * writer, const void * ptr );
+static void memdebug_writer_append_hex( struct memdebug_writer * writer, size_t value );
+static void memdebug_writer_append_json_string( struct memdebug_writer * writer, const char * str );
+static void memdebug_writer_append_csv_string( struct memdebug_writer * writer, const char * str );
+static void memdebug_dump_line( struct memdebug_writer * writer, const unsigned char * data, size_t offset, size_t length );
+static void memdebug_dump( struct memdebug_object * object );
+static void memdebug_ask_debug_cmd( void );
+static void memdebug_sig_handler( int id );
+static void memdebug_warning( int error, const char * str, const char * file, const int line, const char * func, ... );
+static void memdebug_print_object( struct memdebug_object * object );
+static const char * memdebug_alloc_type_name( memdebug_alloc_type alloc_type );
+static const char * memdebug_object_state( struct memdebug_object * object );
+static void memdebug_export_object( struct memdebug_writer * writer, struct memdebug_object * object, unsigned long int record, int format );
+static void memdebug_leak_atexit( void );
+static int memdebug_leak_block_compare( const void * a, const void * b );
+static unsigned long int memdebug_leak_find( const char * value );
+static void memdebug_leak_push( struct memdebug_leak_worker * worker, unsigned long int block );
+static memdebug_bool memdebug_leak_pop( struct memdebug_leak_worker * worker, unsigned long int * block );
+static memdebug_bool memdebug_leak_steal( struct memdebug_leak_worker * worker );
+static void memdebug_leak_scan( struct memdebug_leak_worker * worker, const char * start, const char * end );
+static void memdebug_leak_work( struct memdebug_leak_worker * worker );
+static void * memdebug_leak_worker_main( void * data );
+static void memdebug_leak_scan_stack( const char * sp );
+static void memdebug_leak_mark( void );
+static void memdebug_leak_mark_indirect( void );
+static void memdebug_leak_report( unsigned long int num_direct, unsigned long int num_indirect );
+static void memdebug_print_histograms( void );
+static void memdebug_print_top_sites( unsigned long int max );
+static void memdebug_print_realloc_sites( unsigned long int max );
+static void memdebug_print_realloc_sizes( struct memdebug_object * object );
+static const char * memdebug_realloc_growth( struct memdebug_object * object );
+static void * memdebug_listener_main( void * data );
+static void memdebug_listener_serve( int fd );
+static char * memdebug_listener_command( char * command, size_t * length );
+static void memdebug_listener_answer( const char * name, const char * argument );
+static void memdebug_listener_atexit( void );
+static void memdebug_stats_update( void );
+static void memdebug_stats_refresh( void );
+static void memdebug_stats_atexit( void );
+static int memdebug_create_thread( pthread_t * thread, void * ( * start )( void * ) );
+static int memdebug_signal_number( const char * name );
+static void memdebug_dumper_start( void );
+static void memdebug_dumper_handler( int id );
+static void * memdebug_dumper_main( void * data );
+static void memdebug_dumper_write( void );
+static memdebug_bool memdebug_report_fork( void );
+static void memdebug_report_end( void );
+static void memdebug_capture_op( const char * op, void * ptr, void * ptr_new, size_t size );
+static void memdebug_capture_atexit( void );
+static void memdebug_self_add( unsigned int phase, unsigned long long start, unsigned long long nested );
+static void memdebug_print_self_stats( void );
+static void memdebug_fast_update( void );
+static void memdebug_sampling_flush( void );
+static void memdebug_sampling_exit( void * data );
+static unsigned long int memdebug_light_site( size_t size, const char * file, const int line, const char * func, void * caller );
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_write( int level, char * block, size_t offset, size_t size, unsigned long int site );
+static MEMDEBUG_ALWAYS_INLINE struct memdebug_light * memdebug_light_check( int level, void * ptr, const char * operation, const char * file, const int line, const char * func );
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_malloc( int level, size_t size, const char * file, const int line, const char * func );
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_valloc( int level, size_t size, const char * file, const int line, const char * func );
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_calloc( int level, size_t size1, size_t size2, const char * file, const int line, const char * func );
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_realloc( int level, void * ptr, size_t size, const char * file, const int line, const char * func );
+static MEMDEBUG_ALWAYS_INLINE void memdebug_light_free( int level, void * ptr, const char * file, const int line, const char * func );
+
+/* Checks if the leak scanner can find the data segments and stop the other threads */
+#ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+static int memdebug_leak_add_segments( struct dl_phdr_info * info, size_t size, void * data );
+static void memdebug_leak_read_maps( void );
+static unsigned long int memdebug_leak_stop_threads( void );
+static void memdebug_leak_resume_threads( void );
+static void memdebug_leak_stop_handler( int id, siginfo_t * info, void * context );
+#endif
+
+/* Checks if we can have a backtrace */
+#ifdef MEMDEBUG_HAVE_EXECINFO_H
+static void memdebug_backtrace( unsigned int skip_levels );
+#endif
+
+/* Whether MEMDebug has been inited or not */
+static memdebug_bool memdebug_inited;
+
+/* The MEMDebug memory record pool */
+static struct memdebug_pool * memdebug_trace;
+
+/* The metadata arena */
+static struct memdebug_meta memdebug_meta;
+
+/* The runtime options */
+static struct memdebug_options memdebug_config;
+
+/* The quarantine of the freed memory areas */
+static struct memdebug_quarantine memdebug_quarantine;
+
+/* The index of the active memory records */
+static struct memdebug_index memdebug_active_index;
+
+/* The instrumented arenas */
+static struct memdebug_arenas memdebug_arenas;
+
+/* The active memory mappings */
+static struct memdebug_mappings memdebug_mappings;
+
+/* The archive of the oldest freed memory records */
+static struct memdebug_archive memdebug_archive;
+
+/* The last memory record found in the archive (see memdebug_archive_find()) */
+static struct memdebug_object memdebug_archive_object;
+
+/* The allocation sites table */
+static struct memdebug_sites memdebug_sites;
+
+/* The size-class histograms */
+static struct memdebug_histograms memdebug_histograms;
+
+/* The snapshot of the allocation sites at the peak of the active memory */
+static struct memdebug_peak memdebug_peak;
+
+/* The reference point of the clock of the lifetimes */
+static struct memdebug_clock memdebug_clock;
+
+/* The state of the leak scanner */
+static struct memdebug_leaks memdebug_leaks;
+
+/* The listener thread */
+static struct memdebug_listener memdebug_listener;
+
+/* The lock of the memory records */
+static pthread_mutex_t memdebug_lock;
+
+/* The publication of the statistics in shared memory */
+static struct memdebug_publisher memdebug_publisher;
+
+/* The dumps of the active memory records requested by a signal */
+static struct memdebug_dumper memdebug_dumper;
+
+/* The capture of the allocation sequence */
+static struct memdebug_capturer memdebug_capturer;
+
+/* The self-profiling counters */
+static struct memdebug_self memdebug_self;
+
+/* The allocation counters of the lower feature levels (not static, as they are updated inline by the header) */
+struct memdebug_counters memdebug_counters;
+
+/* Whether the current process is a child writing a report (see memdebug_report_fork()) */
+static memdebug_bool memdebug_report_child;
+
+/* Whether the inline fast path of the header can be taken (not static, as it is read inline by the header) */
+volatile int memdebug_fast_ready;
+
+/* Checks if we are using GNU C */
+#ifdef __GNUC__
+
+/* The sampling state of each thread (not static, as it is updated inline by the header) */
+__thread struct memdebug_sampling memdebug_sampling;
+
+#else
+
+/* The sampling state, shared by the threads (there is no inline fast path) */
+static struct memdebug_sampling memdebug_sampling;
+
+#endif
+
+/* The key whose destructor adds the allocations skipped by an exiting thread to the status (see memdebug_sampling_exit()) */
+static pthread_key_t memdebug_sampling_key;
+
+/* Whether the key of the sampling state was created */
+static memdebug_bool memdebug_sampling_has_key;
+
+/* The stream used for the MEMDebug output */
+static FILE * memdebug_output;
+
+/* The names of the error classes, for the MEMDEBUG_OPTIONS environment variable */
+static const char * memdebug_error_names[ MEMDEBUG_ERROR_COUNT ] =
+{
+    "overflow",
+    "double_free",
+    "invalid_pointer",
+    "alloc_failure",
+    "use_after_free",
+    "signal"
+};
+
+/* The names of the actions, for the MEMDEBUG_OPTIONS environment variable */
+static const char * memdebug_action_names[ MEMDEBUG_ACTION_COUNT ] =
+{
+    "ask",
+    "continue",
+    "log",
+    "abort",
+    "core"
+};
+
+/* The writer used for the memory data dumps */
+static struct memdebug_writer memdebug_dump_writer;
+
+/* The writer used for the exports of the memory records */
+static struct memdebug_writer memdebug_export_writer;
+
+/* The writer of the dumps requested by a signal, used without the lock (see memdebug_dumper_write()) */
+static struct memdebug_writer memdebug_dumper_writer;
+
+/* The number of leading bytes displayed in memory dumps */
+static size_t memdebug_dump_head = MEMDEBUG_DUMP_HEAD;
+
+/* The number of trailing bytes displayed in memory dumps */
+static size_t memdebug_dump_tail = MEMDEBUG_DUMP_TAIL;
+
+/* Whether repeated identical lines are collapsed in memory dumps */
+static memdebug_bool memdebug_dump_collapse = ( MEMDEBUG_DUMP_COLLAPSE ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+
+/* Hexadecimal digits, used to encode the memory data dumps */
+static const char memdebug_hex_digits[] = "0123456789ABCDEF";
+
+/**
+ * Internal fatal error
+ * 
+ * @param   const char *    The error message
+ * @param   ...             The format parameters, if any
+ */
+static void memdebug_fatal( const char * format, ... )
+{
+    va_list ap;
+    
+    /* Gets the variable arguments */
+    va_start( ap, format );
+    
+    /* Prints the error message */
+    vfprintf( ( memdebug_output == NULL ) ? stdout : memdebug_output, format, ap );
+    
+    /* Aborts the program execution */
+    va_end( ap );
+    exit( EXIT_FAILURE );
+}
+
+/**
+ * Initializes MEMDebug
+ * 
+ * @return  void
+ */
+static void memdebug_init( void )
+{
+    struct sigaction sa1;
+    struct sigaction sa2;
+    pthread_mutexattr_t attributes;
+    int i;
+    
+    /* Nothing to do if MEMDebug is already initialized */
+    if( memdebug_inited == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    /* The lock is recursive, as the output functions may be called with the lock held */
+    pthread_mutexattr_init( &attributes );
+    pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+    pthread_mutex_init( &memdebug_lock, &attributes );
+    pthread_mutexattr_destroy( &attributes );
+    
+    /* Default options */
+    memdebug_output                 = stdout;
+    memdebug_config.enabled         = MEMDEBUG_TRUE;
+    memdebug_config.sample_rate     = 1;
+    memdebug_config.quarantine_size = 0;
+    memdebug_config.peak_snapshot   = MEMDEBUG_FALSE;
+    memdebug_config.leak_check      = MEMDEBUG_FALSE;
+    memdebug_config.leak_threads    = 1;
+    memdebug_config.socket_path[ 0 ] = 0;
+    memdebug_config.stats_name[ 0 ]  = 0;
+    memdebug_config.dump_signal      = 0;
+    memdebug_config.dump_dir[ 0 ]    = '.';
+    memdebug_config.dump_dir[ 1 ]    = 0;
+    memdebug_config.fork_reports     = MEMDEBUG_FALSE;
+    memdebug_config.meta_limit       = 0;
+    memdebug_config.capture_path[ 0 ] = 0;
+    memdebug_config.self_profile     = MEMDEBUG_FALSE;
+    
+    for( i = 0; i < MEMDEBUG_ERROR_COUNT; i++ )
+    {
+        memdebug_config.actions[ i ] = MEMDEBUG_ACTION_ASK;
+    }
+    
+    /* Runtime options */
+    memdebug_parse_options( getenv( "MEMDEBUG_OPTIONS" ) );
+    
+    /* Signals are only handled when MEMDebug is enabled */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE )
+    {
+        /* Signal handling */
+        sa1.sa_handler = memdebug_sig_handler;
+        sa1.sa_flags   = 0;
+        sigemptyset( &sa1.sa_mask );
+        
+        /* Handles segmentation faults ( SIGSEGV ) */
+        if( sigaction( SIGSEGV, &sa1, &sa2 ) != 0 )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot set a handler for SIGSEGV\n"
+            );
+        }
+        
+        /* Handles bus errors ( SIGBUS ) */
+        if( sigaction( SIGBUS, &sa1, &sa2 ) != 0 )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot set a handler for SIGBUS\n"
+            );
+        }
+    }
+    
+    /* Allocates the memory record pool structure */
+    if( NULL == ( memdebug_trace = ( struct memdebug_pool * )memdebug_meta_alloc( sizeof( struct memdebug_pool ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Allocates room for memory record objects */
+    if( NULL == ( memdebug_trace->objects = ( struct memdebug_object * )memdebug_meta_alloc( MEMDEBUG_POOL_SIZE * sizeof( struct memdebug_object ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Allocates the index of the active memory records */
+    if( NULL == ( memdebug_active_index.slots = ( unsigned long int * )memdebug_meta_alloc( MEMDEBUG_INDEX_SIZE * sizeof( unsigned long int ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    memdebug_active_index.capacity = MEMDEBUG_INDEX_SIZE;
+    memdebug_active_index.count    = 0;
+    
+    /* Allocates the allocation sites table */
+    if
+    (
+           NULL == ( memdebug_sites.slots = ( unsigned long int * )memdebug_meta_alloc( MEMDEBUG_SITES_SIZE * sizeof( unsigned long int ) ) )
+        || NULL == ( memdebug_sites.sites = ( struct memdebug_site * )memdebug_meta_alloc( ( MEMDEBUG_SITES_SIZE / 2 ) * sizeof( struct memdebug_site ) ) )
+    )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot initialize the trace pool. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    memdebug_sites.capacity = MEMDEBUG_SITES_SIZE;
+    memdebug_sites.size     = MEMDEBUG_SITES_SIZE / 2;
+    memdebug_sites.count    = 0;
+    
+    /* Reference point for the calibration of the clock */
+    gettimeofday( &memdebug_clock.time, NULL );
+    
+    memdebug_clock.ticks = memdebug_ticks();
+    
+    /* Pool initialization */
+    memdebug_trace->num_objects   = 0;
+    memdebug_trace->num_active    = 0;
+    memdebug_trace->num_free      = 0;
+    memdebug_trace->memory_total  = 0;
+    memdebug_trace->memory_active = 0;
+    memdebug_trace->pool_size     = MEMDEBUG_POOL_SIZE;
+    memdebug_inited               = MEMDEBUG_TRUE;
+    
+    /* Checks the leaks when the program exits */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE && memdebug_config.leak_check == MEMDEBUG_TRUE )
+    {
+        atexit( memdebug_leak_atexit );
+    }
+    
+    /* Starts the listener thread */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE && memdebug_config.socket_path[ 0 ] != 0 && memdebug_listen( memdebug_config.socket_path ) != 0 )
+    {
+        fprintf( memdebug_output, "MEMDebug: cannot listen on '%s'. Reason: %s\n", memdebug_config.socket_path, strerror( errno ) );
+    }
+    
+    /* Publishes the statistics in shared memory */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE && memdebug_config.stats_name[ 0 ] != 0 && memdebug_publish_stats( memdebug_config.stats_name ) != 0 )
+    {
+        fprintf( memdebug_output, "MEMDebug: cannot publish the statistics in '%s'. Reason: %s\n", memdebug_config.stats_name, strerror( errno ) );
+    }
+    
+    /* Dumps the active memory records when the signal is received */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE && memdebug_config.dump_signal != 0 )
+    {
+        memdebug_dumper_start();
+    }
+    
+    /* Captures the allocation sequence */
+    if( memdebug_config.enabled == MEMDEBUG_TRUE && memdebug_config.capture_path[ 0 ] != 0 && memdebug_capture( memdebug_config.capture_path ) != 0 )
+    {
+        fprintf( memdebug_output, "MEMDebug: cannot capture the allocations in '%s'. Reason: %s\n", memdebug_config.capture_path, strerror( errno ) );
+    }
+    
+    /* The allocations skipped by a thread are added to the status when it exits */
+    if( memdebug_config.sample_rate > 1 && pthread_key_create( &memdebug_sampling_key, memdebug_sampling_exit ) == 0 )
+    {
+        memdebug_sampling_has_key = MEMDEBUG_TRUE;
+    }
+    
+    memdebug_fast_update();
+}
+
+/**
+ * Parses the runtime options
+ * 
+ * Options are given as a list of name=value pairs, separated by colons,
+ * for instance: "output=stderr:sample=10:on_overflow=abort"
+ * 
+ * @param   const char *    The options string (may be NULL)
+ * @return  void
+ */
+static void memdebug_parse_options( const char * options )
+{
+    size_t length;
+    char   option[ 1024 ];
+    char * value;
+    
+    if( options == NULL )
+    {
+        return;
+    }
+    
+    while( *( options ) != 0 )
+    {
+        length = strcspn( options, ":" );
+        
+        if( length > 0 )
+        {
+            if( length >= sizeof( option ) )
+            {
+                length = sizeof( option ) - 1;
+            }
+            
+            memcpy( option, options, length );
+            
+            option[ length ] = 0;
+            
+            if( NULL == ( value = strchr( option, '=' ) ) )
+            {
+                fprintf( memdebug_output, "MEMDebug: ignoring invalid option '%s'\n", option );
+            }
+            else
+            {
+                *( value++ ) = 0;
+                
+                memdebug_set_option( option, value );
+            }
+        }
+        
+        options += strcspn( options, ":" );
+        
+        if( *( options ) == ':' )
+        {
+            options++;
+        }
+    }
+}
+
+/**
+ * Sets a runtime option
+ * 
+ * @param   const char *    The name of the option
+ * @param   const char *    The value of the option
+ * @return  void
+ */
+static void memdebug_set_option( const char * name, const char * value )
+{
+    int    i;
+    int    action;
+    FILE * output;
+    
+    if( strcmp( name, "enabled" ) == 0 )
+    {
+        memdebug_config.enabled = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strcmp( name, "output" ) == 0 )
+    {
+        if( strcmp( value, "stdout" ) == 0 )
+        {
+            memdebug_output = stdout;
+        }
+        else if( strcmp( value, "stderr" ) == 0 )
+        {
+            memdebug_output = stderr;
+        }
+        else if( NULL != ( output = fopen( value, "a" ) ) )
+        {
+            memdebug_output = output;
+        }
+        else
+        {
+            fprintf( memdebug_output, "MEMDebug: cannot open the output file '%s'. Reason: %s\n", value, strerror( errno ) );
+        }
+    }
+    else if( strcmp( name, "sample" ) == 0 )
+    {
+        memdebug_config.sample_rate = strtoul( value, NULL, 0 );
+        
+        if( memdebug_config.sample_rate == 0 )
+        {
+            memdebug_config.sample_rate = 1;
+        }
+    }
+    else if( strcmp( name, "quarantine" ) == 0 )
+    {
+        memdebug_config.quarantine_size = ( size_t )strtoul( value, NULL, 0 );
+    }
+    else if( strcmp( name, "peak_snapshot" ) == 0 )
+    {
+        memdebug_config.peak_snapshot = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strcmp( name, "leak_check" ) == 0 )
+    {
+        memdebug_config.leak_check = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strcmp( name, "leak_threads" ) == 0 )
+    {
+        memdebug_set_leak_threads( ( unsigned int )strtoul( value, NULL, 0 ) );
+    }
+    else if( strcmp( name, "socket" ) == 0 )
+    {
+        strncpy( memdebug_config.socket_path, value, sizeof( memdebug_config.socket_path ) - 1 );
+        
+        memdebug_config.socket_path[ sizeof( memdebug_config.socket_path ) - 1 ] = 0;
+    }
+    else if( strcmp( name, "stats" ) == 0 )
+    {
+        strncpy( memdebug_config.stats_name, value, sizeof( memdebug_config.stats_name ) - 1 );
+        
+        memdebug_config.stats_name[ sizeof( memdebug_config.stats_name ) - 1 ] = 0;
+    }
+    else if( strcmp( name, "dump_signal" ) == 0 )
+    {
+        if( ( memdebug_config.dump_signal = memdebug_signal_number( value ) ) == 0 )
+        {
+            fprintf( memdebug_output, "MEMDebug: ignoring invalid signal '%s' for option '%s'\n", value, name );
+        }
+    }
+    else if( strcmp( name, "dump_dir" ) == 0 )
+    {
+        strncpy( memdebug_config.dump_dir, value, sizeof( memdebug_config.dump_dir ) - 1 );
+        
+        memdebug_config.dump_dir[ sizeof( memdebug_config.dump_dir ) - 1 ] = 0;
+    }
+    else if( strcmp( name, "fork_reports" ) == 0 )
+    {
+        memdebug_config.fork_reports = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strcmp( name, "meta_limit" ) == 0 )
+    {
+        memdebug_config.meta_limit = ( size_t )strtoul( value, NULL, 0 );
+    }
+    else if( strcmp( name, "self_profile" ) == 0 )
+    {
+        memdebug_config.self_profile = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strcmp( name, "capture" ) == 0 )
+    {
+        strncpy( memdebug_config.capture_path, value, sizeof( memdebug_config.capture_path ) - 1 );
+        
+        memdebug_config.capture_path[ sizeof( memdebug_config.capture_path ) - 1 ] = 0;
+    }
+    else if( strcmp( name, "dump_head" ) == 0 )
+    {
+        memdebug_dump_head = ( size_t )strtoul( value, NULL, 0 );
+    }
+    else if( strcmp( name, "dump_tail" ) == 0 )
+    {
+        memdebug_dump_tail = ( size_t )strtoul( value, NULL, 0 );
+    }
+    else if( strcmp( name, "dump_collapse" ) == 0 )
+    {
+        memdebug_dump_collapse = ( strtoul( value, NULL, 0 ) != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    }
+    else if( strncmp( name, "on_", 3 ) == 0 )
+    {
+        if( ( action = memdebug_parse_action( value ) ) < 0 )
+        {
+            fprintf( memdebug_output, "MEMDebug: ignoring invalid action '%s' for option '%s'\n", value, name );
+            return;
+        }
+        
+        /* Checks for the action of all the error classes */
+        if( strcmp( name + 3, "error" ) == 0 )
+        {
+            for( i = 0; i < MEMDEBUG_ERROR_COUNT; i++ )
+            {
+                memdebug_config.actions[ i ] = action;
+            }
+            
+            return;
+        }
+        
+        for( i = 0; i < MEMDEBUG_ERROR_COUNT; i++ )
+        {
+            if( strcmp( name + 3, memdebug_error_names[ i ] ) == 0 )
+            {
+                memdebug_config.actions[ i ] = action;
+                return;
+            }
+        }
+        
+        fprintf( memdebug_output, "MEMDebug: ignoring unknown option '%s'\n", name );
+    }
+    else
+    {
+        fprintf( memdebug_output, "MEMDebug: ignoring unknown option '%s'\n", name );
+    }
+}
+
+/**
+ * Gets an action from its name
+ * 
+ * @param   const char *    The name of the action
+ * @return  int             The action (MEMDEBUG_ACTION_XXX), or -1 if the name is unknown
+ */
+static int memdebug_parse_action( const char * value )
+{
+    int i;
+    
+    for( i = 0; i < MEMDEBUG_ACTION_COUNT; i++ )
+    {
+        if( strcmp( value, memdebug_action_names[ i ] ) == 0 )
+        {
+            return i;
+        }
+    }
+    
+    return -1;
+}
+
+/**
+ * Maps memory for the metadata arena
+ * 
+ * @param   size_t  The size of the mapping (a multiple of the page size)
+ * @return  void *  The mapping
+ */
+static void * memdebug_meta_map( size_t size )
+{
+    void * ptr;
+    
+    if( MAP_FAILED == ( ptr = mmap( NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot map memory for the MEMDebug metadata. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    memdebug_meta.mapped += size;
+    memdebug_meta.mappings++;
+    
+    if( memdebug_meta.mapped > memdebug_meta.mapped_peak )
+    {
+        memdebug_meta.mapped_peak = memdebug_meta.mapped;
+    }
+    
+    return ptr;
+}
+
+/**
+ * Unmaps memory of the metadata arena
+ * 
+ * @param   void *  The mapping
+ * @param   size_t  The size of the mapping
+ * @return  void
+ */
+static void memdebug_meta_unmap( void * ptr, size_t size )
+{
+    munmap( ptr, size );
+    
+    memdebug_meta.mapped -= size;
+    memdebug_meta.mappings--;
+}
+
+/**
+ * Allocates zeroed memory for MEMDebug itself, from the metadata arena
+ * 
+ * The metadata never comes from the allocator of the program, so it does
+ * not change its heap. Small blocks are carved from chunks (bump
+ * allocation) and recycled by size class (slabs), while large blocks, like
+ * the memory record pool, have their own mapping.
+ * 
+ * @param   size_t  The size to allocate
+ * @return  void *  The allocated memory (never NULL, the errors are fatal)
+ */
+static void * memdebug_meta_alloc( size_t size )
+{
+    size_t capacity;
+    size_t remaining;
+    unsigned int size_class;
+    struct memdebug_meta_header * header;
+    
+    MEMDEBUG_LOCK;
+    
+    /* Rounds the block up to a power of two, or to the page size */
+    size_class = memdebug_log2( size + sizeof( struct memdebug_meta_header ) - 1 ) + 1;
+    size_class = ( size_class < MEMDEBUG_META_MIN_CLASS ) ? MEMDEBUG_META_MIN_CLASS : size_class;
+    
+    if( size_class > MEMDEBUG_META_MAX_CLASS )
+    {
+        capacity = size + sizeof( struct memdebug_meta_header );
+        capacity = ( capacity + ( size_t )getpagesize() - 1 ) & ~( ( size_t )getpagesize() - 1 );
+        header   = ( struct memdebug_meta_header * )memdebug_meta_map( capacity );
+    }
+    else if( memdebug_meta.free_blocks[ size_class ] != NULL )
+    {
+        capacity = ( size_t )1 << size_class;
+        header   = ( struct memdebug_meta_header * )memdebug_meta.free_blocks[ size_class ];
+        
+        memdebug_meta.free_blocks[ size_class ] = *( ( void ** )header );
+        
+        memset( header, 0, capacity );
+    }
+    else
+    {
+        capacity = ( size_t )1 << size_class;
+        
+        if( memdebug_meta.chunk == NULL || memdebug_meta.chunk_used + capacity > MEMDEBUG_META_CHUNK_SIZE )
+        {
+            /* The end of the current chunk is kept as free blocks */
+            while( memdebug_meta.chunk != NULL && ( remaining = MEMDEBUG_META_CHUNK_SIZE - memdebug_meta.chunk_used ) >= ( ( size_t )1 << MEMDEBUG_META_MIN_CLASS ) )
+            {
+                size_class = memdebug_log2( remaining );
+                size_class = ( size_class > MEMDEBUG_META_MAX_CLASS ) ? MEMDEBUG_META_MAX_CLASS : size_class;
+                header     = ( struct memdebug_meta_header * )( memdebug_meta.chunk + memdebug_meta.chunk_used );
+                
+                *( ( void ** )header ) = memdebug_meta.free_blocks[ size_class ];
+                
+                memdebug_meta.free_blocks[ size_class ] = header;
+                memdebug_meta.chunk_used               += ( size_t )1 << size_class;
+            }
+            
+            memdebug_meta.chunk      = ( char * )memdebug_meta_map( MEMDEBUG_META_CHUNK_SIZE );
+            memdebug_meta.chunk_used = 0;
+        }
+        
+        /* The chunks are zeroed by the system */
+        header = ( struct memdebug_meta_header * )( memdebug_meta.chunk + memdebug_meta.chunk_used );
+        
+        memdebug_meta.chunk_used += capacity;
+    }
+    
+    header->size     = size;
+    header->capacity = capacity;
+    
+    memdebug_meta.used      += capacity;
+    memdebug_meta.requested += size;
+    memdebug_meta.blocks++;
+    
+    MEMDEBUG_UNLOCK;
+    
+    return header + 1;
+}
+
+/**
+ * Resizes memory of the metadata arena
+ * 
+ * The added memory is zeroed. Large blocks grow geometrically, as only
+ * the used pages of a mapping take memory.
+ * 
+ * @param   void *  The memory to resize (may be NULL)
+ * @param   size_t  The new size
+ * @return  void *  The resized memory (never NULL, the errors are fatal)
+ */
+static void * memdebug_meta_realloc( void * ptr, size_t size )
+{
+    size_t capacity;
+    void * ptr_new;
+    struct memdebug_meta_header * header;
+    
+    if( ptr == NULL )
+    {
+        return memdebug_meta_alloc( size );
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    header = ( struct memdebug_meta_header * )ptr - 1;
+    
+    /* The block is large enough */
+    if( size + sizeof( struct memdebug_meta_header ) <= header->capacity )
+    {
+        if( size > header->size )
+        {
+            memset( ( char * )ptr + header->size, 0, size - header->size );
+        }
+        
+        memdebug_meta.requested += size;
+        memdebug_meta.requested -= header->size;
+        header->size             = size;
+        
+        MEMDEBUG_UNLOCK;
+        
+        return ptr;
+    }
+    
+    /* Checks if a mapping can be moved by the system */
+    #ifdef MREMAP_MAYMOVE
+    
+    if( header->capacity > ( ( size_t )1 << MEMDEBUG_META_MAX_CLASS ) )
+    {
+        capacity = ( size + sizeof( struct memdebug_meta_header ) > header->capacity * 2 ) ? size + sizeof( struct memdebug_meta_header ) : header->capacity * 2;
+        capacity = ( capacity + ( size_t )getpagesize() - 1 ) & ~( ( size_t )getpagesize() - 1 );
+        
+        /* The new pages are zeroed by the system */
+        memset( ( char * )ptr + header->size, 0, header->capacity - sizeof( struct memdebug_meta_header ) - header->size );
+        
+        if( MAP_FAILED == ( header = ( struct memdebug_meta_header * )mremap( header, header->capacity, capacity, MREMAP_MAYMOVE ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot map memory for the MEMDebug metadata. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        memdebug_meta.mapped    += capacity - header->capacity;
+        memdebug_meta.used      += capacity - header->capacity;
+        memdebug_meta.requested += size - header->size;
+        header->capacity         = capacity;
+        header->size             = size;
+        
+        if( memdebug_meta.mapped > memdebug_meta.mapped_peak )
+        {
+            memdebug_meta.mapped_peak = memdebug_meta.mapped;
+        }
+        
+        MEMDEBUG_UNLOCK;
+        
+        return header + 1;
+    }
+    
+    #endif
+    
+    /* Large blocks grow geometrically */
+    capacity = ( header->capacity > ( ( size_t )1 << MEMDEBUG_META_MAX_CLASS ) && size < header->capacity * 2 ) ? header->capacity * 2 : size;
+    ptr_new  = memdebug_meta_alloc( capacity );
+    
+    memcpy( ptr_new, ptr, header->size );
+    memdebug_meta_free( ptr );
+    
+    header = ( struct memdebug_meta_header * )ptr_new - 1;
+    
+    memdebug_meta.requested += size;
+    memdebug_meta.requested -= header->size;
+    header->size             = size;
+    
+    MEMDEBUG_UNLOCK;
+    
+    return ptr_new;
+}
+
+/**
+ * Gets how much the used metadata memory would grow if a block was resized
+ * 
+ * This follows the rounding of memdebug_meta_alloc() and the geometric
+ * growth of the large blocks of memdebug_meta_realloc().
+ * 
+ * @param   void *  The memory to resize (may be NULL)
+ * @param   size_t  The new size
+ * @return  size_t  The growth of the used metadata memory, in bytes
+ */
+static size_t memdebug_meta_growth( void * ptr, size_t size )
+{
+    size_t capacity;
+    size_t previous;
+    unsigned int size_class;
+    
+    previous = ( ptr == NULL ) ? 0 : ( ( struct memdebug_meta_header * )ptr - 1 )->capacity;
+    capacity = size + sizeof( struct memdebug_meta_header );
+    
+    /* The block is large enough */
+    if( capacity <= previous )
+    {
+        return 0;
+    }
+    
+    /* Large blocks grow geometrically */
+    if( previous > ( ( size_t )1 << MEMDEBUG_META_MAX_CLASS ) && capacity < previous * 2 )
+    {
+        capacity = previous * 2;
+    }
+    
+    size_class = memdebug_log2( capacity - 1 ) + 1;
+    size_class = ( size_class < MEMDEBUG_META_MIN_CLASS ) ? MEMDEBUG_META_MIN_CLASS : size_class;
+    
+    if( size_class > MEMDEBUG_META_MAX_CLASS )
+    {
+        capacity = ( capacity + ( size_t )getpagesize() - 1 ) & ~( ( size_t )getpagesize() - 1 );
+    }
+    else
+    {
+        capacity = ( size_t )1 << size_class;
+    }
+    
+    return capacity - previous;
+}
+
+/**
+ * Frees memory of the metadata arena
+ * 
+ * @param   void *  The memory to free (may be NULL)
+ * @return  void
+ */
+static void memdebug_meta_free( void * ptr )
+{
+    unsigned int size_class;
+    struct memdebug_meta_header * header;
+    
+    if( ptr == NULL )
+    {
+        return;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    header = ( struct memdebug_meta_header * )ptr - 1;
+    
+    memdebug_meta.used      -= header->capacity;
+    memdebug_meta.requested -= header->size;
+    memdebug_meta.blocks--;
+    
+    if( header->capacity > ( ( size_t )1 << MEMDEBUG_META_MAX_CLASS ) )
+    {
+        memdebug_meta_unmap( header, header->capacity );
+    }
+    else
+    {
+        size_class = memdebug_log2( header->capacity );
+        
+        *( ( void ** )header ) = memdebug_meta.free_blocks[ size_class ];
+        
+        memdebug_meta.free_blocks[ size_class ] = header;
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Creates a new memory record object in the pool
+ * 
+ * @param   void *                      The pointer to the allocated memory area
+ * @param   size_t                      The size of the allocated memory area
+ * @param   const char *                The file in which the allocation was made
+ * @param   const int                   The line of the file in which the allocation was made
+ * @param   const char *                The name of the function in which the allocation was made
+ * @param   void *                      The address of the code which made the allocation (MEMDEBUG_CALLER)
+ * @param   const char *                The allocation type (MEMDEBUG_ALLOC_TYPE_XXX)
+ * @return  struct memdebug_object *    The new memory record object, or NULL if the allocation is not recorded (sampling)
+ */
+static struct memdebug_object * memdebug_new_object( void * ptr, size_t size, const char * file, const int line, const char * func, void * caller, memdebug_alloc_type alloc_type )
+{
+    struct memdebug_object * object;
+    memdebug_bool skip;
+    memdebug_bool over_limit;
+    size_t growth;
+    unsigned long long self_start;
+    unsigned long long self_nested;
+    unsigned long long start;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    MEMDEBUG_SELF_START( self_start );
+    
+    self_nested = memdebug_self.nested;
+    
+    memdebug_sampling_flush();
+    
+    skip = MEMDEBUG_FALSE;
+    
+    /* Sampling - Only one allocation out of sample_rate is recorded in each thread (arena allocations and mappings have no fence to mark) */
+    if( memdebug_config.sample_rate > 1 && !( alloc_type & MEMDEBUG_ALLOC_TYPE_UNFENCED ) )
+    {
+        if( memdebug_sampling.countdown == 0 )
+        {
+            memdebug_sampling.countdown = memdebug_config.sample_rate - 1;
+            
+            /* The first allocation of each thread is recorded, so the thread is known before it skips any */
+            if( memdebug_sampling_has_key == MEMDEBUG_TRUE && pthread_getspecific( memdebug_sampling_key ) == NULL )
+            {
+                pthread_setspecific( memdebug_sampling_key, &memdebug_sampling );
+            }
+        }
+        else
+        {
+            memdebug_sampling.countdown--;
+            
+            skip = MEMDEBUG_TRUE;
+        }
+    }
+    
+    over_limit = MEMDEBUG_FALSE;
+    
+    /* Over the metadata budget, the oldest freed records are archived, and the oldest archived ones dropped, instead of growing the pool */
+    if( skip == MEMDEBUG_FALSE && memdebug_trace->pool_size == memdebug_trace->num_objects && memdebug_config.meta_limit > 0 )
+    {
+        growth = memdebug_meta_growth( memdebug_trace->objects, ( memdebug_trace->pool_size + MEMDEBUG_POOL_SIZE ) * sizeof( struct memdebug_object ) );
+        
+        if( memdebug_meta.used + growth > memdebug_config.meta_limit )
+        {
+            memdebug_archive_records();
+            
+            growth = ( memdebug_trace->pool_size == memdebug_trace->num_objects ) ? growth : 0;
+            
+            memdebug_archive_trim( growth );
+            
+            /* The allocation is not recorded if the pool still cannot grow (mappings and arena allocations have no fence to mark) */
+            if( memdebug_meta.used + growth > memdebug_config.meta_limit && !( alloc_type & MEMDEBUG_ALLOC_TYPE_UNFENCED ) )
+            {
+                if( memdebug_trace->num_over_limit == 0 )
+                {
+                    fprintf( memdebug_output, "MEMDebug: the metadata budget (meta_limit) is reached, the new allocations are not recorded until records are archived\n" );
+                }
+                
+                over_limit = MEMDEBUG_TRUE;
+                skip       = MEMDEBUG_TRUE;
+            }
+        }
+    }
+    
+    if( skip == MEMDEBUG_TRUE )
+    {
+        /* Marks the memory area, so it won't be looked up when freed */
+        *( ( memdebug_fence * )ptr - 1 ) = MEMDEBUG_FENCE_UNTRACKED;
+        
+        if( over_limit == MEMDEBUG_TRUE )
+        {
+            memdebug_trace->num_over_limit++;
+        }
+        else
+        {
+            memdebug_trace->num_untracked++;
+        }
+        
+        memdebug_stats_update();
+        
+        if( self_start != 0 )
+        {
+            memdebug_self_add( MEMDEBUG_SELF_RECORDS, self_start, memdebug_self.nested - self_nested );
+        }
+        
+        MEMDEBUG_UNLOCK;
+        
+        return NULL;
+    }
+    
+    /* Checks there's enough room in the current pool for a new object */
+    if( memdebug_trace->pool_size == memdebug_trace->num_objects )
+    {
+        /* No, let's reallocate some memory */
+        if( NULL == ( memdebug_trace->objects = ( struct memdebug_object * )memdebug_meta_realloc( memdebug_trace->objects, ( memdebug_trace->pool_size + MEMDEBUG_POOL_SIZE ) * sizeof( struct memdebug_object ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the MEMDebug pool. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        /* Sets the new pool size */
+        memdebug_trace->pool_size += MEMDEBUG_POOL_SIZE;
+    }
+    
+    /* Increments the counter as we have a new object */
+    memdebug_trace->num_objects++;
+    
+    object = &memdebug_trace->objects[ memdebug_trace->num_objects - 1 ];
+    
+    object->ptr        = ptr;
+    object->size       = size;
+    object->alloc_file = file;
+    object->alloc_line = line;
+    object->alloc_func = func;
+    object->alloc_type = alloc_type;
+    object->alloc_seq  = memdebug_trace->sequence++;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    object->site = memdebug_site_get( file, line, func, caller );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_SITES, start );
+    
+    object->alloc_time = memdebug_ticks();
+    object->arena      = 0;
+    object->generation = 0;
+    
+    object->realloc_count  = 0;
+    object->realloc_copied = 0;
+    object->realloc_sizes  = NULL;
+    
+    /* Checks if the object is autamatically freed (alloca or GC functions) */
+    if( alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA || alloc_type & MEMDEBUG_ALLOC_TYPE_OBJC_GC )
+    {
+        /* The object will be automatically freed */
+        object->free     = MEMDEBUG_TRUE;
+        object->free_seq = object->alloc_seq;
+        memdebug_trace->num_auto++;
+        
+        /* Only counted in the total of the allocation site */
+        memdebug_site_add( object->site, size );
+        memdebug_site_remove( object->site, size );
+        
+        memdebug_histograms.total[ memdebug_type_index( alloc_type ) ][ memdebug_log2( size ) ]++;
+    }
+    else
+    {
+        /* The object will need to be manually freed */
+        object->free = MEMDEBUG_FALSE;
+        memdebug_trace->num_active++;
+        
+        /* Arena allocations are indexed by memdebug_arena_alloc(), and mappings are kept in their own list */
+        if( alloc_type & MEMDEBUG_ALLOC_TYPE_MAP )
+        {
+            memdebug_mapping_add( object );
+        }
+        else if( !( alloc_type & MEMDEBUG_ALLOC_TYPE_ARENA ) )
+        {
+            MEMDEBUG_SELF_START( start );
+            
+            memdebug_index_insert( &memdebug_active_index, object );
+            
+            MEMDEBUG_SELF_END( MEMDEBUG_SELF_INDEX, start );
+        }
+        
+        memdebug_site_add( object->site, size );
+        
+        memdebug_histograms.total[ memdebug_type_index( alloc_type ) ][ memdebug_log2( size ) ]++;
+        memdebug_histograms.live[ memdebug_type_index( alloc_type ) ][ memdebug_log2( size ) ]++;
+    }
+    
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Stores the address of the caller function */
+    object->alloc_func_addr = __builtin_return_address( 2 );
+    
+    #endif
+    
+    /* Checks if the allocation was made using dynamic memory */
+    if( !( alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA ) )
+    {
+        /* Updates the memory usage */
+        memdebug_trace->memory_total  += size;
+        memdebug_trace->memory_active += size;
+    }
+    
+    memdebug_peak_check();
+    
+    /* The fences of arena allocations are optional, and written by memdebug_arena_alloc() - Mappings have none, as they are page-aligned */
+    if( !( alloc_type & MEMDEBUG_ALLOC_TYPE_UNFENCED ) )
+    {
+        memdebug_write_fence( object );
+    }
+    
+    memdebug_stats_update();
+    
+    if( self_start != 0 )
+    {
+        memdebug_self_add( MEMDEBUG_SELF_RECORDS, self_start, memdebug_self.nested - self_nested );
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Returns the new object */
+    return object;    
+}
+
+/**
+ * Updates an existing memory record object in the pool, after a reallocation
+ * 
+ * @param   struct memdebug_object *    The memory record object, as returned by memdebug_check_object()
+ * @param   void *                      The new address of the memory area for the memory record object
+ * @param   size_t                      The size of the allocated memory area
+ * @param   const char *                The file in which the allocation was made
+ * @param   const int                   The line of the file in which the allocation was made
+ * @param   const char *                The name of the function in which the allocation was made
+ * @param   void *                      The address of the code which made the allocation (MEMDEBUG_CALLER)
+ * @param   const char *                The allocation type (MEMDEBUG_ALLOC_TYPE_XXX)
+ * @return  void
+ */
+static void memdebug_update_object( struct memdebug_object * object, void * ptr_new, size_t size, const char * file, const int line, const char * func, void * caller, memdebug_alloc_type alloc_type )
+{
+    unsigned long long self_start;
+    unsigned long long self_nested;
+    unsigned long long start;
+    
+    MEMDEBUG_LOCK;
+    
+    MEMDEBUG_SELF_START( self_start );
+    
+    self_nested = memdebug_self.nested;
+    
+    /* The active memory may decrease */
+    memdebug_peak_release();
+    
+    MEMDEBUG_SELF_START( start );
+    
+    /* The address may have changed */
+    memdebug_index_remove( &memdebug_active_index, object->ptr );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_INDEX, start );
+    
+    /* A reallocation is accounted as a deallocation and a new allocation, at the new site */
+    memdebug_site_remove( object->site, object->size );
+    
+    MEMDEBUG_SELF_START( start );
+    
+    object->site = memdebug_site_get( file, line, func, caller );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_SITES, start );
+    
+    object->alloc_time = memdebug_ticks();
+    
+    memdebug_site_add( object->site, size );
+    memdebug_realloc_add( object, ptr_new, size );
+    
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+    memdebug_histograms.live[ memdebug_type_index( alloc_type ) ][ memdebug_log2( size ) ]++;
+    memdebug_histograms.total[ memdebug_type_index( alloc_type ) ][ memdebug_log2( size ) ]++;
+    
+    /* Updates the memory record informations */
+    object->ptr        = ptr_new;
+    object->alloc_file = file;
+    object->alloc_line = line;
+    object->alloc_func = func;
+    object->alloc_type = alloc_type;
+    
+    /* Updates the pool memory size and usage */
+    memdebug_trace->memory_total  -= object->size;
+    memdebug_trace->memory_active -= object->size;
+    memdebug_trace->memory_total  += size;
+    memdebug_trace->memory_active += size;
+    
+    /* Updates the size of the memory record */
+    object->size = size;
+    
+    memdebug_peak_check();
+    
+    /* The trailing fence has moved with the size */
+    memdebug_write_fence( object );
+    
+    MEMDEBUG_SELF_START( start );
+    
+    memdebug_index_insert( &memdebug_active_index, object );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_INDEX, start );
+    
+    memdebug_stats_update();
+    
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Stores the address of the caller function */
+    object->alloc_func_addr = __builtin_return_address( 2 );
+    
+    #endif
+    
+    if( self_start != 0 )
+    {
+        memdebug_self_add( MEMDEBUG_SELF_RECORDS, self_start, memdebug_self.nested - self_nested );
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Adds a reallocation to the reallocation chain of a memory record, and to the counters of its new site
+ * 
+ * The memory area was copied if its address has changed. The history of
+ * the sizes grows by powers of 2, up to MEMDEBUG_REALLOC_HISTORY sizes.
+ * 
+ * @param   struct memdebug_object *    The memory record object, with the site of the reallocation
+ * @param   void *                      The new address of the memory area
+ * @param   size_t                      The new size of the memory area
+ * @return  void
+ */
+static void memdebug_realloc_add( struct memdebug_object * object, void * ptr_new, size_t size )
+{
+    size_t copied;
+    unsigned long int num_sizes;
+    struct memdebug_site * site;
+    
+    site   = &memdebug_sites.sites[ object->site ];
+    copied = ( ptr_new == object->ptr ) ? 0 : ( ( size < object->size ) ? size : object->size );
+    
+    object->realloc_count++;
+    object->realloc_copied += copied;
+    
+    site->realloc_count++;
+    site->realloc_copied += copied;
+    
+    if( ptr_new != object->ptr )
+    {
+        site->realloc_moves++;
+    }
+    
+    if( size > site->realloc_max )
+    {
+        site->realloc_max = size;
+    }
+    
+    /* Number of sizes in the history, with the new one */
+    num_sizes = object->realloc_count + 1;
+    
+    if( num_sizes > MEMDEBUG_REALLOC_HISTORY )
+    {
+        return;
+    }
+    
+    /* The history is full when the previous number of sizes is a power of 2 */
+    if( ( ( num_sizes - 1 ) & ( num_sizes - 2 ) ) == 0 )
+    {
+        if( NULL == ( object->realloc_sizes = ( size_t * )memdebug_meta_realloc( object->realloc_sizes, ( num_sizes - 1 ) * 2 * sizeof( size_t ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the reallocation history. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+    }
+    
+    if( num_sizes == 2 )
+    {
+        object->realloc_sizes[ 0 ] = object->size;
+    }
+    
+    object->realloc_sizes[ num_sizes - 1 ] = size;
+}
+
+/**
+ * Marks an existing memory record object as free
+ * 
+ * @param   void *                      The address of the memory area corresponding to the memory record object
+ * @param   const char *                The file in which the deallocation was made
+ * @param   const int                   The line of the file in which the deallocation was made
+ * @param   const char *                The name of the function in which the deallocation was made
+ * @return  struct memdebug_object *    The memory record object, or NULL if the memory area must not be released (invalid pointer or double free)
+ */
+static struct memdebug_object * memdebug_free_object( void * ptr, const char * file, const int line, const char * func )
+{
+    struct memdebug_object * object;
+    unsigned long long self_start;
+    unsigned long long self_nested;
+    unsigned long long start;
+    
+    MEMDEBUG_LOCK;
+    
+    MEMDEBUG_SELF_START( self_start );
+    
+    self_nested = memdebug_self.nested;
+    
+    /* Checks the memory record object */
+    if( NULL == ( object = memdebug_check_object( ptr, "free", file, line, func ) ) )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return NULL;
+    }
+    
+    memdebug_peak_release();
+    
+    /* Udpates the memory record object */
+    object->free      = MEMDEBUG_TRUE;
+    object->free_file = file;
+    object->free_line = line;
+    object->free_func = func;
+    object->free_seq  = memdebug_trace->sequence++;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    memdebug_index_remove( &memdebug_active_index, ptr );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_INDEX, start );
+    
+    memdebug_site_remove( object->site, object->size );
+    
+    memdebug_sites.sites[ object->site ].lifetimes[ memdebug_log2( memdebug_ticks() - object->alloc_time ) ]++;
+    
+    /* End of a reallocation chain, at the site of the last reallocation */
+    if( object->realloc_count > 0 )
+    {
+        memdebug_sites.sites[ object->site ].realloc_sizes[ memdebug_log2( object->size ) ]++;
+    }
+    
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+    
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Stores the address of the caller function */
+    object->free_func_addr = __builtin_return_address( 1 );
+    
+    #endif
+    
+    /* Updates the memory usage */
+    memdebug_trace->num_active--;
+    memdebug_trace->num_free++;
+    memdebug_trace->memory_active -= object->size;
+    
+    memdebug_stats_update();
+    
+    if( self_start != 0 )
+    {
+        memdebug_self_add( MEMDEBUG_SELF_RECORDS, self_start, memdebug_self.nested - self_nested );
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    return object;
+}
+
+/**
+ * Checks a memory record object before its memory area is freed or reallocated
+ * 
+ * Issues a warning if the memory area is unknown, was already freed, or if
+ * its fences were overwritten.
+ * 
+ * @param   void *                      The address of the memory area corresponding to the memory record object
+ * @param   const char *                The operation ("free" or "reallocate")
+ * @param   const char *                The file in which the operation was made
+ * @param   const int                   The line of the file in which the operation was made
+ * @param   const char *                The name of the function in which the operation was made
+ * @return  struct memdebug_object *    The memory record object, or NULL if the memory area is unknown or was already freed
+ */
+static struct memdebug_object * memdebug_check_object( void * ptr, const char * operation, const char * file, const int line, const char * func )
+{
+    struct memdebug_object * object;
+    
+    /* Checks if the address exists in the pool */
+    if( NULL == ( object = memdebug_get_object( ptr ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_INVALID_POINTER,
+            "Trying to %s a non-existing object (pointer address: %p)",
+            file,
+            line,
+            func,
+            operation,
+            ptr
+        );
+        
+        return NULL;
+    }
+    
+    /* Checks if the memory area was already freed */
+    if( object->free == MEMDEBUG_TRUE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_DOUBLE_FREE,
+            "Trying to %s a freed object (pointer address: %p)",
+            file,
+            line,
+            func,
+            operation,
+            ptr
+        );
+        
+        return NULL;
+    }
+    
+    if( memdebug_check_fence( object ) == MEMDEBUG_FALSE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_OVERFLOW,
+            "A buffer overflow was detected (pointer address: %p)",
+            file,
+            line,
+            func,
+            ptr
+        );
+    }
+    
+    return object;
+}
+
+/**
+ * Gets a memory record object from the pool
+ * 
+ * As addresses are reused by the allocator, the active memory record object
+ * for the given address is returned, or else the most recent freed one.
+ * 
+ * @param   void *                      The address of the memory area corresponding to the memory record object
+ * @return  struct memdebug_object *    The memory record object, or NULL if it was not found in the pool
+ */
+static struct memdebug_object * memdebug_get_object( void * ptr )
+{
+    unsigned long int i;
+    unsigned long long start;
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    object = memdebug_index_find( &memdebug_active_index, ptr );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_INDEX, start );
+    
+    /* Active objects are indexed */
+    if( object != NULL )
+    {
+        return object;
+    }
+    
+    /* Freed objects are only searched when an error is about to be reported */
+    /* Tries to find the object in the pool */
+    for( i = memdebug_trace->num_objects; i > 0; i-- )
+    {
+        /* Checks if the given pointer is the same as the one in the memory record object (arena allocations and mappings are not released by free) */
+        if( memdebug_trace->objects[ i - 1 ].ptr == ptr && !( memdebug_trace->objects[ i - 1 ].alloc_type & MEMDEBUG_ALLOC_TYPE_UNFENCED ) )
+        {
+            /* Yes, returns the memory record object corresponding to the given pointer */
+            return &memdebug_trace->objects[ i - 1 ];
+        }
+    }
+    
+    /* The oldest freed objects may have been archived */
+    return memdebug_archive_find( ptr, 0 );
+}
+
+/**
+ * Gets the first slot to probe for an address, in an index of active memory records
+ * 
+ * @param   struct memdebug_index * The index table
+ * @param   void *                  The address of the memory area
+ * @return  unsigned long int       The slot number
+ */
+static unsigned long int memdebug_index_slot( struct memdebug_index * table, void * ptr )
+{
+    size_t hash;
+    
+    /* Fibonacci hashing - The low bits of the addresses are mostly alignment */
+    hash = ( ( size_t )ptr >> 4 ) * ( size_t )0x9E3779B97F4A7C15ULL;
+    
+    return ( unsigned long int )( hash ^ ( hash >> 29 ) ) & ( table->capacity - 1 );
+}
+
+/**
+ * Adds a memory record object to an index of active memory records
+ * 
+ * @param   struct memdebug_index *     The index table
+ * @param   struct memdebug_object *    The memory record object
+ * @return  void
+ */
+static void memdebug_index_insert( struct memdebug_index * table, struct memdebug_object * object )
+{
+    unsigned long int * slots;
+    unsigned long int   capacity;
+    unsigned long int   i;
+    unsigned long int   slot;
+    
+    /* Keeps the load factor under 50% */
+    if( ( table->count + 1 ) * 2 > table->capacity )
+    {
+        slots    = table->slots;
+        capacity = table->capacity;
+        
+        if( NULL == ( table->slots = ( unsigned long int * )memdebug_meta_alloc( capacity * 2 * sizeof( unsigned long int ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the MEMDebug index. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        table->capacity = capacity * 2;
+        
+        /* Rehashes the existing entries */
+        for( i = 0; i < capacity; i++ )
+        {
+            if( slots[ i ] == 0 )
+            {
+                continue;
+            }
+            
+            slot = memdebug_index_slot( table, memdebug_trace->objects[ slots[ i ] - 1 ].ptr );
+            
+            while( table->slots[ slot ] != 0 )
+            {
+                slot = ( slot + 1 ) & ( table->capacity - 1 );
+            }
+            
+            table->slots[ slot ] = slots[ i ];
+        }
+        
+        memdebug_meta_free( slots );
+    }
+    
+    slot = memdebug_index_slot( table, object->ptr );
+    
+    while( table->slots[ slot ] != 0 )
+    {
+        slot = ( slot + 1 ) & ( table->capacity - 1 );
+    }
+    
+    table->slots[ slot ] = ( unsigned long int )( object - memdebug_trace->objects ) + 1;
+    table->count++;
+}
+
+/**
+ * Removes an address from an index of active memory records
+ * 
+ * @param   struct memdebug_index * The index table
+ * @param   void *                  The address of the memory area
+ * @return  void
+ */
+static void memdebug_index_remove( struct memdebug_index * table, void * ptr )
+{
+    unsigned long int mask;
+    unsigned long int slot;
+    unsigned long int next;
+    unsigned long int home;
+    
+    mask = table->capacity - 1;
+    slot = memdebug_index_slot( table, ptr );
+    
+    /* Finds the slot of the address */
+    while( table->slots[ slot ] != 0 )
+    {
+        if( memdebug_trace->objects[ table->slots[ slot ] - 1 ].ptr == ptr )
+        {
+            break;
+        }
+        
+        slot = ( slot + 1 ) & mask;
+    }
+    
+    if( table->slots[ slot ] == 0 )
+    {
+        return;
+    }
+    
+    table->slots[ slot ] = 0;
+    table->count--;
+    
+    /* Backward shift deletion - Moves back the following entries of the probe sequence, so no tombstone is needed */
+    next = ( slot + 1 ) & mask;
+    
+    while( table->slots[ next ] != 0 )
+    {
+        home = memdebug_index_slot( table, memdebug_trace->objects[ table->slots[ next ] - 1 ].ptr );
+        
+        /* Checks if the entry's home slot is cyclically outside ]slot, next] */
+        if( ( ( next - home ) & mask ) >= ( ( next - slot ) & mask ) )
+        {
+            table->slots[ slot ] = table->slots[ next ];
+            table->slots[ next ] = 0;
+            slot                                = next;
+        }
+        
+        next = ( next + 1 ) & mask;
+    }
+}
+
+/**
+ * Finds an active memory record object in the index
+ * 
+ * @param   struct memdebug_index *     The index table
+ * @param   void *                      The address of the memory area
+ * @return  struct memdebug_object *    The active memory record object, or NULL
+ */
+static struct memdebug_object * memdebug_index_find( struct memdebug_index * table, void * ptr )
+{
+    unsigned long int slot;
+    struct memdebug_object * object;
+    
+    slot = memdebug_index_slot( table, ptr );
+    
+    while( table->slots[ slot ] != 0 )
+    {
+        object = &memdebug_trace->objects[ table->slots[ slot ] - 1 ];
+        
+        if( object->ptr == ptr )
+        {
+            return object;
+        }
+        
+        slot = ( slot + 1 ) & ( table->capacity - 1 );
+    }
+    
+    return NULL;
+}
+
+/**
+ * Gets the first slot to probe for an allocation site, in the allocation sites table
+ * 
+ * The file and function names are compared by address, as they are string
+ * constants (__FILE__ and __func__).
+ * 
+ * @param   const char *        The name of the file in which the allocation is made
+ * @param   const int           The line of the file in which the allocation is made
+ * @param   const char *        The name of the function in which the allocation is made
+ * @param   unsigned long int   The number of slots of the table (a power of 2)
+ * @return  unsigned long int   The slot number
+ */
+static unsigned long int memdebug_site_hash( const char * file, const int line, const char * func, unsigned long int capacity )
+{
+    size_t hash;
+    
+    hash = ( ( size_t )file ^ ( ( size_t )func << 1 ) ) * ( size_t )0x9E3779B97F4A7C15ULL + ( size_t )line;
+    
+    return ( unsigned long int )( hash ^ ( hash >> 29 ) ) & ( capacity - 1 );
+}
+
+/**
+ * Gets an allocation site from the allocation sites table, creating it if needed
+ * 
+ * @param   const char *        The name of the file in which the allocation is made
+ * @param   const int           The line of the file in which the allocation is made
+ * @param   const char *        The name of the function in which the allocation is made
+ * @param   void *              The address of the code making the allocation
+ * @return  unsigned long int   The allocation site number
+ */
+static unsigned long int memdebug_site_get( const char * file, const int line, const char * func, void * caller )
+{
+    unsigned long int i;
+    unsigned long int slot;
+    struct memdebug_site * site;
+    
+    slot = memdebug_site_hash( file, line, func, memdebug_sites.capacity );
+    
+    while( memdebug_sites.slots[ slot ] != 0 )
+    {
+        site = &memdebug_sites.sites[ memdebug_sites.slots[ slot ] - 1 ];
+        
+        if( site->file == file && site->line == line && site->func == func )
+        {
+            return memdebug_sites.slots[ slot ] - 1;
+        }
+        
+        slot = ( slot + 1 ) & ( memdebug_sites.capacity - 1 );
+    }
+    
+    /* New allocation site - Keeps the load factor of the table under 50% */
+    if( memdebug_sites.count == memdebug_sites.size )
+    {
+        memdebug_meta_free( memdebug_sites.slots );
+        
+        memdebug_sites.capacity *= 2;
+        memdebug_sites.size     *= 2;
+        
+        if
+        (
+               NULL == ( memdebug_sites.slots = ( unsigned long int * )memdebug_meta_alloc( memdebug_sites.capacity * sizeof( unsigned long int ) ) )
+            || NULL == ( memdebug_sites.sites = ( struct memdebug_site * )memdebug_meta_realloc( memdebug_sites.sites, memdebug_sites.size * sizeof( struct memdebug_site ) ) )
+        )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the MEMDebug allocation sites. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        /* Rehashes the existing allocation sites */
+        for( i = 0; i < memdebug_sites.count; i++ )
+        {
+            site = &memdebug_sites.sites[ i ];
+            slot = memdebug_site_hash( site->file, site->line, site->func, memdebug_sites.capacity );
+            
+            while( memdebug_sites.slots[ slot ] != 0 )
+            {
+                slot = ( slot + 1 ) & ( memdebug_sites.capacity - 1 );
+            }
+            
+            memdebug_sites.slots[ slot ] = i + 1;
+        }
+        
+        slot = memdebug_site_hash( file, line, func, memdebug_sites.capacity );
+        
+        while( memdebug_sites.slots[ slot ] != 0 )
+        {
+            slot = ( slot + 1 ) & ( memdebug_sites.capacity - 1 );
+        }
+    }
+    
+    site = &memdebug_sites.sites[ memdebug_sites.count ];
+    
+    memset( site, 0, sizeof( struct memdebug_site ) );
+    
+    site->file   = file;
+    site->line   = line;
+    site->func   = func;
+    site->caller = caller;
+    
+    memdebug_sites.slots[ slot ] = ++memdebug_sites.count;
+    
+    return memdebug_sites.count - 1;
+}
+
+/**
+ * Adds an allocation to the counters of an allocation site
+ * 
+ * @param   unsigned long int   The allocation site number
+ * @param   size_t              The allocated size
+ * @return  void
+ */
+static void memdebug_site_add( unsigned long int site, size_t size )
+{
+    struct memdebug_site * counters;
+    
+    counters = &memdebug_sites.sites[ site ];
+    
+    memdebug_peak_touch( site );
+    
+    counters->live_count++;
+    counters->total_count++;
+    counters->live_size  += size;
+    counters->total_size += size;
+    
+    if( counters->live_size > counters->peak_size )
+    {
+        counters->peak_size = counters->live_size;
+    }
+}
+
+/**
+ * Removes a deallocation from the active counters of an allocation site
+ * 
+ * @param   unsigned long int   The allocation site number
+ * @param   size_t              The deallocated size
+ * @return  void
+ */
+static void memdebug_site_remove( unsigned long int site, size_t size )
+{
+    memdebug_peak_touch( site );
+    
+    memdebug_sites.sites[ site ].live_count--;
+    memdebug_sites.sites[ site ].live_size -= size;
+}
+
+/**
+ * Gets the class of a value (allocation size or lifetime), for the histograms
+ * 
+ * The class is the position of the highest set bit of the value, so the
+ * class N holds the values from 2^N to 2^(N+1) - 1 (the class 0 also holds
+ * the value 0).
+ * 
+ * @param   unsigned long long  The value
+ * @return  unsigned int        The class
+ */
+static unsigned int memdebug_log2( unsigned long long value )
+{
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Branch-free, as a single instruction (bsr or clz) */
+    return ( unsigned int )( ( sizeof( unsigned long long ) * 8 ) - 1 - ( size_t )__builtin_clzll( value | 1 ) );
+    
+    #else
+    
+    unsigned int log2;
+    
+    for( log2 = 0; value > 1; value >>= 1 )
+    {
+        log2++;
+    }
+    
+    return log2;
+    
+    #endif
+}
+
+/**
+ * Reads the clock used for the lifetimes of the allocations
+ * 
+ * On x86, the time-stamp counter is used, as it costs a few cycles.
+ * Otherwise, the monotonic clock is used, with its coarse version when
+ * available (Linux), as its resolution is enough for the histograms.
+ * 
+ * @return  unsigned long long  The current time, in ticks (see memdebug_tick_ns())
+ */
+static unsigned long long memdebug_ticks( void )
+{
+    /* Checks for the time-stamp counter */
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    
+    return __builtin_ia32_rdtsc();
+    
+    #elif defined( CLOCK_MONOTONIC )
+    
+    struct timespec now;
+    
+    #ifdef CLOCK_MONOTONIC_COARSE
+    clock_gettime( CLOCK_MONOTONIC_COARSE, &now );
+    #else
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    #endif
+    
+    return ( unsigned long long )now.tv_sec * 1000000000ULL + ( unsigned long long )now.tv_nsec;
+    
+    #else
+    
+    struct timeval now;
+    
+    gettimeofday( &now, NULL );
+    
+    return ( unsigned long long )now.tv_sec * 1000000000ULL + ( unsigned long long )now.tv_usec * 1000ULL;
+    
+    #endif
+}
+
+/**
+ * Gets the duration of a tick of memdebug_ticks(), in nanoseconds
+ * 
+ * The time-stamp counter is calibrated against the wall clock, since the
+ * initialization of MEMDebug.
+ * 
+ * @return  double  The duration of a tick
+ */
+static double memdebug_tick_ns( void )
+{
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    
+    struct timeval now;
+    unsigned long long ticks;
+    double elapsed;
+    
+    gettimeofday( &now, NULL );
+    
+    ticks   = memdebug_ticks() - memdebug_clock.ticks;
+    elapsed = ( double )( now.tv_sec - memdebug_clock.time.tv_sec ) * 1e9 + ( double )( now.tv_usec - memdebug_clock.time.tv_usec ) * 1e3;
+    
+    /* Not enough time to calibrate */
+    if( ticks == 0 || elapsed <= 0 )
+    {
+        return 1;
+    }
+    
+    return elapsed / ( double )ticks;
+    
+    #else
+    
+    return 1;
+    
+    #endif
+}
+
+/**
+ * Formats a duration for the reports, with a suitable unit
+ * 
+ * @param   double  The duration, in nanoseconds
+ * @param   char *  The buffer for the formatted duration
+ * @param   size_t  The size of the buffer
+ * @return  void
+ */
+static void memdebug_format_duration( double ns, char * str, size_t length )
+{
+    if( ns < 1e3 )
+    {
+        snprintf( str, length, "%.0f ns", ns );
+    }
+    else if( ns < 1e6 )
+    {
+        snprintf( str, length, "%.1f us", ns / 1e3 );
+    }
+    else if( ns < 1e9 )
+    {
+        snprintf( str, length, "%.1f ms", ns / 1e6 );
+    }
+    else
+    {
+        snprintf( str, length, "%.1f s", ns / 1e9 );
+    }
+}
+
+/**
+ * Records the peaks of the active memory records and memory, after an allocation
+ * 
+ * @return  void
+ */
+static void memdebug_peak_check( void )
+{
+    if( memdebug_trace->num_active > memdebug_trace->num_peak )
+    {
+        memdebug_trace->num_peak = memdebug_trace->num_active;
+        
+        gettimeofday( &memdebug_trace->num_peak_time, NULL );
+    }
+    
+    if( memdebug_trace->memory_active > memdebug_trace->memory_peak )
+    {
+        memdebug_trace->memory_peak = memdebug_trace->memory_active;
+        
+        gettimeofday( &memdebug_trace->memory_peak_time, NULL );
+        
+        /* The snapshot is taken when the active memory starts decreasing, so it is exactly at the peak */
+        memdebug_peak.pending = memdebug_config.peak_snapshot;
+    }
+}
+
+/**
+ * Notes that the active counters of an allocation site are about to change, for the next peak snapshot
+ * 
+ * Only the changed sites are saved by memdebug_peak_save(), so each new
+ * peak can be saved, at a cost proportional to the allocations made since
+ * the previous one.
+ * 
+ * @param   unsigned long int   The allocation site number
+ * @return  void
+ */
+static void memdebug_peak_touch( unsigned long int site )
+{
+    if( memdebug_config.peak_snapshot == MEMDEBUG_FALSE || memdebug_sites.sites[ site ].snapshot_changed == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    if( memdebug_peak.num_changed == memdebug_peak.size )
+    {
+        memdebug_peak.size = ( memdebug_peak.size == 0 ) ? MEMDEBUG_SITES_SIZE : memdebug_peak.size * 2;
+        
+        if( NULL == ( memdebug_peak.changed = ( unsigned long int * )memdebug_meta_realloc( memdebug_peak.changed, memdebug_peak.size * sizeof( unsigned long int ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot allocate memory for the peak snapshot. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+    }
+    
+    memdebug_sites.sites[ site ].snapshot_changed = MEMDEBUG_TRUE;
+    
+    memdebug_peak.changed[ memdebug_peak.num_changed++ ] = site;
+}
+
+/**
+ * Takes the pending peak snapshot, before the active memory decreases
+ * 
+ * @return  void
+ */
+static void memdebug_peak_release( void )
+{
+    if( memdebug_peak.pending == MEMDEBUG_FALSE )
+    {
+        return;
+    }
+    
+    memdebug_peak.pending = MEMDEBUG_FALSE;
+    
+    if( memdebug_trace->memory_active == memdebug_trace->memory_peak )
+    {
+        memdebug_peak_save();
+    }
+}
+
+/**
+ * Saves the active memory of each allocation site, at a peak of the active memory
+ * 
+ * Each new peak is saved, so the snapshot is always the one of the highest
+ * peak. Only the sites changed since the previous snapshot are copied.
+ * 
+ * @return  void
+ */
+static void memdebug_peak_save( void )
+{
+    unsigned long int i;
+    struct memdebug_site * site;
+    
+    for( i = 0; i < memdebug_peak.num_changed; i++ )
+    {
+        site = &memdebug_sites.sites[ memdebug_peak.changed[ i ] ];
+        
+        site->snapshot_count   = site->live_count;
+        site->snapshot_size    = site->live_size;
+        site->snapshot_changed = MEMDEBUG_FALSE;
+    }
+    
+    memdebug_peak.num_changed = 0;
+    
+    gettimeofday( &memdebug_peak.time, NULL );
+    
+    memdebug_peak.num_active    = memdebug_trace->num_active;
+    memdebug_peak.memory_active = memdebug_trace->memory_active;
+    memdebug_peak.taken         = MEMDEBUG_TRUE;
+}
+
+/**
+ * Formats a time for the reports (local time, with milliseconds)
+ * 
+ * @param   const struct timeval *  The time
+ * @param   char *                  The buffer for the formatted time
+ * @param   size_t                  The size of the buffer
+ * @return  void
+ */
+static void memdebug_format_time( const struct timeval * time, char * str, size_t length )
+{
+    time_t      seconds;
+    struct tm   local;
+    size_t      used;
+    
+    seconds = time->tv_sec;
+    
+    if( time->tv_sec == 0 && time->tv_usec == 0 )
+    {
+        snprintf( str, length, "-" );
+        return;
+    }
+    
+    localtime_r( &seconds, &local );
+    
+    used = strftime( str, length, "%Y-%m-%d %H:%M:%S", &local );
+    
+    snprintf( str + used, length - used, ".%03li", ( long int )( time->tv_usec / 1000 ) );
+}
+
+/**
+ * Gets the index of an allocation type (MEMDEBUG_ALLOC_TYPE_XXX), for the histograms
+ * 
+ * @param   memdebug_alloc_type     The allocation type
+ * @return  unsigned int            The position of the lowest set bit of the allocation type
+ */
+static unsigned int memdebug_type_index( memdebug_alloc_type alloc_type )
+{
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Branch-free, as a single instruction (bsf or ctz) - The extra bit guards against an empty type */
+    return ( unsigned int )__builtin_ctzl( alloc_type | ( 1UL << ( MEMDEBUG_ALLOC_TYPES - 1 ) ) );
+    
+    #else
+    
+    unsigned int index;
+    
+    for( index = 0; index < MEMDEBUG_ALLOC_TYPES - 1 && !( alloc_type & ( 1UL << index ) ); index++ );
+    
+    return index;
+    
+    #endif
+}
+
+/**
+ * Checks if a memory area has a memory record object (see the sampling option)
+ * 
+ * @param   void *          The address of the memory area
+ * @return  memdebug_bool   Whether the memory area is recorded
+ */
+static memdebug_bool memdebug_is_tracked( void * ptr )
+{
+    return ( *( ( memdebug_fence * )ptr - 1 ) == MEMDEBUG_FENCE_UNTRACKED ) ? MEMDEBUG_FALSE : MEMDEBUG_TRUE;
+}
+
+/**
+ * Computes the size of an array allocation, checking for overflows
+ * 
+ * @param   size_t          The number of elements
+ * @param   size_t          The size of an element
+ * @param   size_t *        The size of the array
+ * @return  memdebug_bool   Whether the size of the array, plus the fences, can be allocated
+ */
+static memdebug_bool memdebug_calloc_size( size_t size1, size_t size2, size_t * size )
+{
+    if( size2 != 0 && size1 > ( ( size_t )-1 - ( 2 * MEMDEBUG_FENCE_SIZE ) ) / size2 )
+    {
+        return MEMDEBUG_FALSE;
+    }
+    
+    *( size ) = size1 * size2;
+    
+    return MEMDEBUG_TRUE;
+}
+
+/**
+ * Keeps a freed memory area in quarantine, instead of releasing it
+ * 
+ * The memory area is filled with MEMDEBUG_QUARANTINE_BYTE, so writes made
+ * after the deallocation can be detected when it leaves the quarantine.
+ * The oldest memory areas are released when the quarantine size is exceeded.
+ * 
+ * @param   struct memdebug_object *    The freed memory record object
+ * @return  void
+ */
+static void memdebug_quarantine_push( struct memdebug_object * object )
+{
+    unsigned long int * records;
+    unsigned long int   capacity;
+    unsigned long int   i;
+    
+    MEMDEBUG_LOCK;
+    
+    /* Checks if the circular buffer is full */
+    if( memdebug_quarantine.count == memdebug_quarantine.capacity )
+    {
+        capacity = ( memdebug_quarantine.capacity == 0 ) ? MEMDEBUG_POOL_SIZE : memdebug_quarantine.capacity * 2;
+        
+        if( NULL == ( records = ( unsigned long int * )memdebug_meta_alloc( capacity * sizeof( unsigned long int ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot allocate the quarantine. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        /* Copies the records, oldest first */
+        for( i = 0; i < memdebug_quarantine.count; i++ )
+        {
+            records[ i ] = memdebug_quarantine.records[ ( memdebug_quarantine.head + i ) % memdebug_quarantine.capacity ];
+        }
+        
+        memdebug_meta_free( memdebug_quarantine.records );
+        
+        memdebug_quarantine.records  = records;
+        memdebug_quarantine.capacity = capacity;
+        memdebug_quarantine.head     = 0;
+    }
+    
+    memset( object->ptr, MEMDEBUG_QUARANTINE_BYTE, object->size );
+    
+    i = ( memdebug_quarantine.head + memdebug_quarantine.count ) % memdebug_quarantine.capacity;
+    
+    memdebug_quarantine.records[ i ] = ( unsigned long int )( object - memdebug_trace->objects );
+    memdebug_quarantine.count++;
+    memdebug_quarantine.size        += object->size;
+    
+    /* Releases the oldest memory areas */
+    while( memdebug_quarantine.size > memdebug_config.quarantine_size && memdebug_quarantine.count > 0 )
+    {
+        memdebug_quarantine_pop();
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Releases the oldest memory area kept in quarantine
+ * 
+ * @return  void
+ */
+static void memdebug_quarantine_pop( void )
+{
+    struct memdebug_object * object;
+    unsigned char          * data;
+    size_t                   i;
+    
+    object = &memdebug_trace->objects[ memdebug_quarantine.records[ memdebug_quarantine.head ] ];
+    data   = ( unsigned char * )object->ptr;
+    
+    memdebug_quarantine.head   = ( memdebug_quarantine.head + 1 ) % memdebug_quarantine.capacity;
+    memdebug_quarantine.count--;
+    memdebug_quarantine.size  -= object->size;
+    
+    /* Checks if the memory area was written after being freed */
+    for( i = 0; i < object->size; i++ )
+    {
+        if( data[ i ] != MEMDEBUG_QUARANTINE_BYTE )
+        {
+            memdebug_warning
+            (
+                MEMDEBUG_ERROR_USE_AFTER_FREE,
+                "A freed object was modified at offset %lu (pointer address: %p)",
+                object->free_file,
+                object->free_line,
+                object->free_func,
+                ( unsigned long int )i,
+                object->ptr
+            );
+            
+            break;
+        }
+    }
+    
+    free( ( memdebug_fence * )object->ptr - 1 );
+}
+
+/**
+ * 
+ */
+static void memdebug_write_fence( struct memdebug_object * object )
+{
+    memdebug_fence * ptr;
+    unsigned long long start;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    ptr      = ( ( memdebug_fence * )object->ptr - 1 );
+    *( ptr ) = MEMDEBUG_FENCE_VAL;
+    ptr      = ( memdebug_fence * )( ( char * )ptr + object->size ) + 1;
+    *( ptr ) = MEMDEBUG_FENCE_VAL;
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_FENCES, start );
+}
+
+/**
+ * 
+ */
+static memdebug_bool memdebug_check_fence( struct memdebug_object * object )
+{
+    memdebug_fence * ptr;
+    memdebug_bool valid;
+    unsigned long long start;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    ptr   = ( ( memdebug_fence * )object->ptr - 1 );
+    valid = ( *( ptr ) == MEMDEBUG_FENCE_VAL ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    ptr   = ( memdebug_fence * )( ( char * )ptr + object->size ) + 1;
+    
+    if( *( ptr ) != MEMDEBUG_FENCE_VAL )
+    {
+        valid = MEMDEBUG_FALSE;
+    }
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_FENCES, start );
+    
+    return valid;
+}
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_malloc( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return malloc( size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )malloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_MALLOC );
+        
+        /* Captures the allocation, for a replay */
+        if( memdebug_capturer.writer != NULL )
+        {
+            memdebug_capture_op( "malloc", ptr, NULL, size );
+        }
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_valloc( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return valloc( size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )valloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to valloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_VALLOC );
+        
+        /* Captures the allocation, for a replay */
+        if( memdebug_capturer.writer != NULL )
+        {
+            memdebug_capture_op( "valloc", ptr, NULL, size );
+        }
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    size_t size;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return calloc( size1, size2 );
+    }
+    
+    /* Checks if the size overflows, including the fences */
+    if( memdebug_calloc_size( size1, size2, &size ) == MEMDEBUG_FALSE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The size of the call to calloc() overflows (%lu * %lu bytes)",
+            file,
+            line,
+            func,
+            ( unsigned long int )size1,
+            ( unsigned long int )size2
+        );
+        
+        errno = ENOMEM;
+        
+        return NULL;
+    }
+    
+    /* Allocates memory */
+    /* The memory is zeroed by calloc, so large areas keep the zero pages of the system - Only the fences are written */
+    if( NULL == ( ptr = ( void * )calloc( 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to calloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_CALLOC );
+        
+        /* Captures the allocation, for a replay */
+        if( memdebug_capturer.writer != NULL )
+        {
+            memdebug_capture_op( "calloc", ptr, NULL, size );
+        }
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Reallocates a memory area
+ * 
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+void * memdebug_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr_new;
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return realloc( ptr, size );
+    }
+    
+    /* Reallocating a NULL pointer is the same as allocating */
+    if( ptr == NULL )
+    {
+        return memdebug_malloc( size, file, line, func );
+    }
+    
+    /* The memory record object must stay valid until it is updated (the pool moves when it grows, and the other threads may reuse the address once it is reallocated) */
+    MEMDEBUG_LOCK;
+    
+    object = NULL;
+    
+    /* Checks the memory record object before the memory area is moved (areas not recorded because of the sampling are reallocated as is) */
+    if( memdebug_is_tracked( ptr ) == MEMDEBUG_TRUE && NULL == ( object = memdebug_check_object( ptr, "reallocate", file, line, func ) ) )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return NULL;
+    }
+    
+    /* Rellocates memory */
+    if( NULL == ( ptr_new = ( void * )realloc( ( memdebug_fence * )ptr - 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to realloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return ptr_new;
+    }
+    else
+    {
+        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
+        
+        /* Updates the memory record object */
+        if( object != NULL )
+        {
+            memdebug_update_object( object, ptr_new, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_REALLOC );
+        }
+        
+        /* Captures the reallocation, for a replay */
+        if( memdebug_capturer.writer != NULL )
+        {
+            memdebug_capture_op( "realloc", ptr, ptr_new, size );
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Returns the address of the reallocated area */
+    return ptr_new;
+}
+
+/**
+ * Frees a memory area
+ * 
+ * @param   void *          The address of the memory area to free
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void
+ */
+void memdebug_free( void * ptr, const char * file, const int line, const char * func )
+{
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        free( ptr );
+        return;
+    }
+    
+    /* Freeing a NULL pointer does nothing */
+    if( ptr == NULL )
+    {
+        return;
+    }
+    
+    /* Memory areas not recorded because of the sampling are released directly */
+    if( memdebug_is_tracked( ptr ) == MEMDEBUG_FALSE )
+    {
+        /* Captured before the release, so the address cannot be reused first */
+        if( memdebug_capturer.writer != NULL )
+        {
+            memdebug_capture_op( "free", ptr, NULL, 0 );
+        }
+        
+        free( ( memdebug_fence * )ptr - 1 );
+        return;
+    }
+    
+    /* The memory record object must stay valid until it is quarantined (the pool moves when it grows) */
+    MEMDEBUG_LOCK;
+    
+    /* Marks the object as freed (invalid pointers and double frees are not released) */
+    if( NULL == ( object = memdebug_free_object( ptr, file, line, func ) ) )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    /* Captures the deallocation, for a replay */
+    if( memdebug_capturer.writer != NULL )
+    {
+        memdebug_capture_op( "free", ptr, NULL, 0 );
+    }
+    
+    /* Checks if freed memory areas are kept in quarantine */
+    if( memdebug_config.quarantine_size > 0 )
+    {
+        memdebug_quarantine_push( object );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Frees the memory area */
+    free( ( memdebug_fence * )ptr - 1 );
+}
+
+/**
+ * Gets the allocation site of a memory area of the lower feature levels, and adds the allocation to its counters
+ * 
+ * @param   size_t              The allocated size
+ * @param   const char *        The file in which the call was made
+ * @param   const int           The line of the file in which the call was made
+ * @param   const char *        The name of the function in which the call was made
+ * @param   void *              The address of the code making the allocation
+ * @return  unsigned long int   The allocation site number
+ */
+static unsigned long int memdebug_light_site( size_t size, const char * file, const int line, const char * func, void * caller )
+{
+    unsigned long int site;
+    
+    MEMDEBUG_LOCK;
+    
+    site = memdebug_site_get( file, line, func, caller );
+    
+    memdebug_site_add( site, size );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return site;
+}
+
+/**
+ * Writes the header and the fences of a memory area of the lower feature levels
+ * 
+ * @param   int                 The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   char *              The allocated block
+ * @param   size_t              The offset of the memory area from the start of the block
+ * @param   size_t              The size of the memory area
+ * @param   unsigned long int   The allocation site number
+ * @return  void *              The address of the memory area
+ */
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_write( int level, char * block, size_t offset, size_t size, unsigned long int site )
+{
+    char * ptr;
+    struct memdebug_light * light;
+    
+    ptr   = block + offset;
+    light = ( struct memdebug_light * )( ptr - MEMDEBUG_LIGHT_OFFSET( level ) );
+    
+    light->magic  = MEMDEBUG_LIGHT_MAGIC;
+    light->size   = size;
+    light->site   = ( unsigned int )site;
+    light->offset = ( unsigned int )offset;
+    
+    if( level == MEMDEBUG_LEVEL_FENCES )
+    {
+        *( ( memdebug_fence * )ptr - 1 )        = MEMDEBUG_FENCE_VAL;
+        *( ( memdebug_fence * )( ptr + size ) ) = MEMDEBUG_FENCE_VAL;
+    }
+    
+    return ( void * )ptr;
+}
+
+/**
+ * Gets the header of a memory area of the lower feature levels, and checks its fences
+ * 
+ * Issues a warning if the header is not the one of an active memory area
+ * (the memory area was not allocated by the lower feature levels, or was
+ * already freed), or if the fences were overwritten.
+ * 
+ * @param   int                         The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   void *                      The address of the memory area
+ * @param   const char *                The operation ("free" or "reallocate")
+ * @param   const char *                The file in which the call was made
+ * @param   const int                   The line of the file in which the call was made
+ * @param   const char *                The name of the function in which the call was made
+ * @return  struct memdebug_light *     The header of the memory area, or NULL if the memory area must not be released
+ */
+static MEMDEBUG_ALWAYS_INLINE struct memdebug_light * memdebug_light_check( int level, void * ptr, const char * operation, const char * file, const int line, const char * func )
+{
+    struct memdebug_light * light;
+    
+    light = ( struct memdebug_light * )( ( char * )ptr - MEMDEBUG_LIGHT_OFFSET( level ) );
+    
+    /* Checks if the memory area was already freed */
+    if( light->magic == MEMDEBUG_LIGHT_MAGIC_FREED )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_DOUBLE_FREE,
+            "Trying to %s a freed object (pointer address: %p)",
+            file,
+            line,
+            func,
+            operation,
+            ptr
+        );
+        
+        return NULL;
+    }
+    
+    /* Checks if the memory area was allocated by the lower feature levels */
+    if( light->magic != MEMDEBUG_LIGHT_MAGIC || light->site >= memdebug_sites.count )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_INVALID_POINTER,
+            "Trying to %s a non-existing object (pointer address: %p)",
+            file,
+            line,
+            func,
+            operation,
+            ptr
+        );
+        
+        return NULL;
+    }
+    
+    if
+    (
+           level == MEMDEBUG_LEVEL_FENCES
+        && (
+                  *( ( memdebug_fence * )ptr - 1 ) != MEMDEBUG_FENCE_VAL
+               || *( ( memdebug_fence * )( ( char * )ptr + light->size ) ) != MEMDEBUG_FENCE_VAL
+           )
+    )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_OVERFLOW,
+            "A buffer overflow was detected (pointer address: %p)",
+            file,
+            line,
+            func,
+            ptr
+        );
+    }
+    
+    return light;
+}
+
+/**
+ * Allocates some memory, for the lower feature levels (see MEMDEBUG_LEVEL)
+ * 
+ * The memory area has a small header, with its size and its allocation
+ * site, and the fences of the fences level, but no memory record.
+ * 
+ * @param   int             The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_malloc( int level, size_t size, const char * file, const int line, const char * func )
+{
+    char * block;
+    
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Allocates memory */
+    if( NULL == ( block = ( char * )malloc( MEMDEBUG_LIGHT_SIZE( level, size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        return NULL;
+    }
+    
+    return memdebug_light_write( level, block, MEMDEBUG_LIGHT_OFFSET( level ), size, memdebug_light_site( size, file, line, func, MEMDEBUG_CALLER ) );
+}
+
+/**
+ * Allocates some page-aligned memory, for the lower feature levels (see MEMDEBUG_LEVEL)
+ * 
+ * The memory area starts one page after the allocated block, so the header
+ * and the leading fence fit before it, and it stays page-aligned.
+ * 
+ * @param   int             The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_valloc( int level, size_t size, const char * file, const int line, const char * func )
+{
+    char * block;
+    size_t offset;
+    
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    offset = ( size_t )getpagesize();
+    
+    /* Allocates memory */
+    if( NULL == ( block = ( char * )valloc( offset + size + MEMDEBUG_LIGHT_FENCE_SIZE( level ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to valloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        return NULL;
+    }
+    
+    return memdebug_light_write( level, block, offset, size, memdebug_light_site( size, file, line, func, MEMDEBUG_CALLER ) );
+}
+
+/**
+ * Allocates some zeroed memory, for the lower feature levels (see MEMDEBUG_LEVEL)
+ * 
+ * @param   int             The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_calloc( int level, size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    char * block;
+    size_t size;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if the size overflows, including the header and the fences */
+    if( size2 != 0 && size1 > ( ( size_t )-1 - MEMDEBUG_LIGHT_SIZE( level, 0 ) ) / size2 )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The size of the call to calloc() overflows (%lu * %lu bytes)",
+            file,
+            line,
+            func,
+            ( unsigned long int )size1,
+            ( unsigned long int )size2
+        );
+        
+        errno = ENOMEM;
+        
+        return NULL;
+    }
+    
+    size = size1 * size2;
+    
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    /* Allocates memory */
+    if( NULL == ( block = ( char * )calloc( 1, MEMDEBUG_LIGHT_SIZE( level, size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to calloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        return NULL;
+    }
+    
+    return memdebug_light_write( level, block, MEMDEBUG_LIGHT_OFFSET( level ), size, memdebug_light_site( size, file, line, func, MEMDEBUG_CALLER ) );
+}
+
+/**
+ * Reallocates a memory area, for the lower feature levels (see MEMDEBUG_LEVEL)
+ * 
+ * @param   int             The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+static MEMDEBUG_ALWAYS_INLINE void * memdebug_light_realloc( int level, void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    char * block;
+    void * ptr_new;
+    struct memdebug_light * light;
+    unsigned long int site;
+    size_t old_size;
+    
+    /* Reallocating a NULL pointer is the same as allocating */
+    if( ptr == NULL )
+    {
+        return memdebug_light_malloc( level, size, file, line, func );
+    }
+    
+    if( NULL == ( light = memdebug_light_check( level, ptr, "reallocate", file, line, func ) ) )
+    {
+        return NULL;
+    }
+    
+    /* Page-aligned memory areas do not start at the usual offset, so they are copied to a new memory area */
+    if( light->offset != MEMDEBUG_LIGHT_OFFSET( level ) )
+    {
+        if( NULL != ( ptr_new = memdebug_light_malloc( level, size, file, line, func ) ) )
+        {
+            memcpy( ptr_new, ptr, ( light->size < size ) ? light->size : size );
+            memdebug_light_free( level, ptr, file, line, func );
+        }
+        
+        return ptr_new;
+    }
+    
+    site     = light->site;
+    old_size = light->size;
+    
+    /* The previous memory area may stay readable, so it must not look active */
+    light->magic = MEMDEBUG_LIGHT_MAGIC_FREED;
+    
+    /* Reallocates memory */
+    if( NULL == ( block = ( char * )realloc( ( char * )ptr - MEMDEBUG_LIGHT_OFFSET( level ), MEMDEBUG_LIGHT_SIZE( level, size ) ) ) )
+    {
+        light->magic = MEMDEBUG_LIGHT_MAGIC;
+        
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to realloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        return NULL;
+    }
+    
+    MEMDEBUG_COUNT( reallocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    /* The reallocation belongs to the site of the realloc() call */
+    MEMDEBUG_LOCK;
+    
+    memdebug_site_remove( site, old_size );
+    
+    site = memdebug_site_get( file, line, func, MEMDEBUG_CALLER );
+    
+    memdebug_site_add( site, size );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return memdebug_light_write( level, block, MEMDEBUG_LIGHT_OFFSET( level ), size, site );
+}
+
+/**
+ * Frees a memory area, for the lower feature levels (see MEMDEBUG_LEVEL)
+ * 
+ * Without the memory records, double frees and invalid pointers are only
+ * detected with the header of the memory area, which is marked as freed.
+ * 
+ * @param   int             The feature level (MEMDEBUG_LEVEL_SITES or MEMDEBUG_LEVEL_FENCES)
+ * @param   void *          The address of the memory area to free
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void
+ */
+static MEMDEBUG_ALWAYS_INLINE void memdebug_light_free( int level, void * ptr, const char * file, const int line, const char * func )
+{
+    struct memdebug_light * light;
+    
+    /* Freeing a NULL pointer does nothing */
+    if( ptr == NULL )
+    {
+        return;
+    }
+    
+    /* Invalid pointers and double frees are not released */
+    if( NULL == ( light = memdebug_light_check( level, ptr, "free", file, line, func ) ) )
+    {
+        return;
+    }
+    
+    MEMDEBUG_COUNT( frees, 1 );
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_site_remove( light->site, light->size );
+    
+    light->magic = MEMDEBUG_LIGHT_MAGIC_FREED;
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Frees the memory area */
+    free( ( char * )ptr - light->offset );
+}
+
+/**
+ * Allocates some page-aligned memory, for the counters level (see MEMDEBUG_LEVEL)
+ * 
+ * valloc() is not always declared by stdlib.h, so it is not counted inline.
+ * 
+ * @param   size_t  The memory size to allocate
+ * @return  void *  A pointer to the allocated memory area
+ */
+void * memdebug_counted_valloc( size_t size )
+{
+    MEMDEBUG_COUNT( allocs, 1 );
+    MEMDEBUG_COUNT( bytes, size );
+    
+    return valloc( size );
+}
+
+/**
+ * Allocates some memory, for the sites level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_sites_malloc( size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_malloc( MEMDEBUG_LEVEL_SITES, size, file, line, func );
+}
+
+/**
+ * Allocates some page-aligned memory, for the sites level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_sites_valloc( size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_valloc( MEMDEBUG_LEVEL_SITES, size, file, line, func );
+}
+
+/**
+ * Allocates some zeroed memory, for the sites level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_sites_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    return memdebug_light_calloc( MEMDEBUG_LEVEL_SITES, size1, size2, file, line, func );
+}
+
+/**
+ * Reallocates a memory area, for the sites level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+void * memdebug_sites_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_realloc( MEMDEBUG_LEVEL_SITES, ptr, size, file, line, func );
+}
+
+/**
+ * Frees a memory area, for the sites level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   void *          The address of the memory area to free
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void
+ */
+void memdebug_sites_free( void * ptr, const char * file, const int line, const char * func )
+{
+    memdebug_light_free( MEMDEBUG_LEVEL_SITES, ptr, file, line, func );
+}
+
+/**
+ * Allocates some memory, for the fences level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_fences_malloc( size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_malloc( MEMDEBUG_LEVEL_FENCES, size, file, line, func );
+}
+
+/**
+ * Allocates some page-aligned memory, for the fences level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_fences_valloc( size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_valloc( MEMDEBUG_LEVEL_FENCES, size, file, line, func );
+}
+
+/**
+ * Allocates some zeroed memory, for the fences level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_fences_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    return memdebug_light_calloc( MEMDEBUG_LEVEL_FENCES, size1, size2, file, line, func );
+}
+
+/**
+ * Reallocates a memory area, for the fences level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+void * memdebug_fences_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    return memdebug_light_realloc( MEMDEBUG_LEVEL_FENCES, ptr, size, file, line, func );
+}
+
+/**
+ * Frees a memory area, for the fences level (see MEMDEBUG_LEVEL)
+ * 
+ * @param   void *          The address of the memory area to free
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void
+ */
+void memdebug_fences_free( void * ptr, const char * file, const int line, const char * func )
+{
+    memdebug_light_free( MEMDEBUG_LEVEL_FENCES, ptr, file, line, func );
+}
+
+/* Checks if the alloca function is available */
+#ifdef _ALLOCA_H_
+
+/* Checks if we are using GCC 3 or greater */
+#if defined( __GNUC__ ) && __GNUC__ >= 3
+
+/**
+ * Allocates some memory in the stack
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_builtin_alloca( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )__builtin_alloca( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to __builtin_alloca() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+#else 
+
+/**
+ * Allocates some memory in the stack
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_alloca( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )alloca( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to alloca() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ALLOCA );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+#endif
+#endif
+
+/* Checks if the Objective-C garbage collector is present */
+#if defined( OBJC_WITH_GC ) && OBJC_WITH_GC
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_gc_malloc( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return GC_malloc( size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )GC_malloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to GC_malloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_gc_malloc_atomic( size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return GC_malloc_atomic( size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )GC_malloc_atomic( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to GC_malloc_atomic() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Allocates some memory
+ * 
+ * @param   size_t          The number of time to allocate the memory size
+ * @param   size_t          The memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the allocated memory area
+ */
+void * memdebug_gc_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    size_t size;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return GC_calloc( size1, size2 );
+    }
+    
+    /* Checks if the size overflows, including the fences */
+    if( memdebug_calloc_size( size1, size2, &size ) == MEMDEBUG_FALSE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The size of the call to GC_calloc() overflows (%lu * %lu bytes)",
+            file,
+            line,
+            func,
+            ( unsigned long int )size1,
+            ( unsigned long int )size2
+        );
+        
+        errno = ENOMEM;
+        
+        return NULL;
+    }
+    
+    /* Allocates memory */
+    /* The memory is zeroed by GC_calloc, so large areas keep the zero pages of the system - Only the fences are written */
+    if( NULL == ( ptr = ( void * )GC_calloc( 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to GC_calloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+/**
+ * Reallocates a memory area
+ * 
+ * @param   void *          The address of the original memory area
+ * @param   size_t          The new memory size to allocate
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          A pointer to the reallocated memory area
+ */
+void * memdebug_gc_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr_new;
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return GC_realloc( ptr, size );
+    }
+    
+    /* Reallocating a NULL pointer is the same as allocating */
+    if( ptr == NULL )
+    {
+        return memdebug_gc_malloc( size, file, line, func );
+    }
+    
+    /* The memory record object must stay valid until it is updated (the pool moves when it grows, and the other threads may reuse the address once it is reallocated) */
+    MEMDEBUG_LOCK;
+    
+    object = NULL;
+    
+    /* Checks the memory record object before the memory area is moved (areas not recorded because of the sampling are reallocated as is) */
+    if( memdebug_is_tracked( ptr ) == MEMDEBUG_TRUE && NULL == ( object = memdebug_check_object( ptr, "reallocate", file, line, func ) ) )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return NULL;
+    }
+    
+    /* Rellocates memory */
+    if( NULL == ( ptr_new = ( void * )GC_realloc( ( memdebug_fence * )ptr - 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to GC_realloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return ptr_new;
+    }
+    else
+    {
+        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
+        
+        /* Updates the memory record object */
+        if( object != NULL )
+        {
+            memdebug_update_object( object, ptr_new, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC );
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Returns the address of the reallocated area */
+    return ptr_new;
+}
+
+#endif
+
+#ifdef _MALLOC_MALLOC_H_
+
+void * memdebug_malloc_zone_malloc( malloc_zone_t * zone, size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return malloc_zone_malloc( zone, size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )malloc_zone_malloc( zone, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc_zone_malloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+void * memdebug_malloc_zone_calloc( malloc_zone_t * zone, size_t size1, size_t size2, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    size_t size;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return malloc_zone_calloc( zone, size1, size2 );
+    }
+    
+    /* Checks if the size overflows, including the fences */
+    if( memdebug_calloc_size( size1, size2, &size ) == MEMDEBUG_FALSE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The size of the call to malloc_zone_calloc() overflows (%lu * %lu bytes)",
+            file,
+            line,
+            func,
+            ( unsigned long int )size1,
+            ( unsigned long int )size2
+        );
+        
+        errno = ENOMEM;
+        
+        return NULL;
+    }
+    
+    /* Allocates memory */
+    /* The memory is zeroed by malloc_zone_calloc, so large areas keep the zero pages of the system - Only the fences are written */
+    if( NULL == ( ptr = ( void * )malloc_zone_calloc( zone, 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc_zone_calloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+void * memdebug_malloc_zone_valloc( malloc_zone_t * zone, size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return malloc_zone_valloc( zone, size );
+    }
+    
+    /* Allocates memory */
+    if( NULL == ( ptr = ( void * )malloc_zone_valloc( zone, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc_zone_valloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+    }
+    else
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        
+        /* Creates a new memory record object for the allocated area */
+        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC );
+    }
+    
+    /* Returns the address of the allocated area */
+    return ptr;
+}
+
+void memdebug_malloc_zone_free( malloc_zone_t * zone, void * ptr, const char * file, const int line, const char * func )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        malloc_zone_free( zone, ptr );
+        return;
+    }
+    
+    /* Freeing a NULL pointer does nothing */
+    if( ptr == NULL )
+    {
+        return;
+    }
+    
+    /* Marks the object as freed (invalid pointers and double frees are not released) */
+    if( memdebug_is_tracked( ptr ) == MEMDEBUG_TRUE && NULL == memdebug_free_object( ptr, file, line, func ) )
+    {
+        return;
+    }
+    
+    /* Frees the memory area */
+    malloc_zone_free( zone, ( memdebug_fence * )ptr - 1 );
+}
+
+void * memdebug_malloc_zone_realloc( malloc_zone_t * zone, void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    void * ptr_new;
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return malloc_zone_realloc( zone, ptr, size );
+    }
+    
+    /* Reallocating a NULL pointer is the same as allocating */
+    if( ptr == NULL )
+    {
+        return memdebug_malloc_zone_malloc( zone, size, file, line, func );
+    }
+    
+    /* The memory record object must stay valid until it is updated (the pool moves when it grows, and the other threads may reuse the address once it is reallocated) */
+    MEMDEBUG_LOCK;
+    
+    object = NULL;
+    
+    /* Checks the memory record object before the memory area is moved (areas not recorded because of the sampling are reallocated as is) */
+    if( memdebug_is_tracked( ptr ) == MEMDEBUG_TRUE && NULL == ( object = memdebug_check_object( ptr, "reallocate", file, line, func ) ) )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return NULL;
+    }
+    
+    /* Rellocates memory */
+    if( NULL == ( ptr_new = ( void * )malloc_zone_realloc( zone, ( memdebug_fence * )ptr - 1, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to malloc_zone_realloc() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( errno )
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return ptr_new;
+    }
+    else
+    {
+        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
+        
+        /* Updates the memory record object */
+        if( object != NULL )
+        {
+            memdebug_update_object( object, ptr_new, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC );
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    /* Returns the address of the reallocated area */
+    return ptr_new;
+}
+
+#endif
+
+/**
+ * Creates an instrumented arena
+ * 
+ * The allocations carved by a custom region allocator are declared with
+ * memdebug_arena_alloc(), and are recorded with their own allocation type
+ * (MEMDEBUG_ALLOC_TYPE_ARENA_ALLOC). The arena memory itself is allocated
+ * and checked for leaks as usual.
+ * 
+ * @param   const char *        The name of the arena (must remain valid)
+ * @param   int                 Whether the allocations of the arena have fences (see MEMDEBUG_ARENA_SIZE)
+ * @return  unsigned long int   The arena identifier
+ */
+unsigned long int memdebug_arena_create( const char * name, int fences )
+{
+    struct memdebug_arena * arena;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    /* Allocates the index of the active arena memory records */
+    if( memdebug_arenas.index.slots == NULL )
+    {
+        if( NULL == ( memdebug_arenas.index.slots = ( unsigned long int * )memdebug_meta_alloc( MEMDEBUG_INDEX_SIZE * sizeof( unsigned long int ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot allocate the arena index. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        memdebug_arenas.index.capacity = MEMDEBUG_INDEX_SIZE;
+        memdebug_arenas.index.count    = 0;
+    }
+    
+    if( NULL == ( memdebug_arenas.arenas = ( struct memdebug_arena * )memdebug_meta_realloc( memdebug_arenas.arenas, ( memdebug_arenas.count + 1 ) * sizeof( struct memdebug_arena ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate the arena. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    arena = &memdebug_arenas.arenas[ memdebug_arenas.count++ ];
+    
+    memset( arena, 0, sizeof( struct memdebug_arena ) );
+    
+    arena->name   = ( name == NULL ) ? "<unknown>" : name;
+    arena->fences = ( fences ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    
+    MEMDEBUG_UNLOCK;
+    
+    return memdebug_arenas.count;
+}
+
+/**
+ * Records an allocation made from an instrumented arena
+ * 
+ * If the arena has fences, the memory area must have been carved with
+ * MEMDEBUG_ARENA_SIZE( size ), and the returned address must be used instead
+ * of the given one.
+ * 
+ * @param   unsigned long int   The arena identifier, as returned by memdebug_arena_create()
+ * @param   void *              The address of the memory area, carved from the arena
+ * @param   size_t              The size of the allocation
+ * @param   const char *        The file in which the call was made
+ * @param   const int           The line of the file in which the call was made
+ * @param   const char *        The name of the function in which the call was made
+ * @return  void *              The address of the allocation
+ */
+void * memdebug_arena_alloc( unsigned long int arena, void * ptr, size_t size, const char * file, const int line, const char * func )
+{
+    struct memdebug_object * object;
+    
+    if( ptr == NULL )
+    {
+        return NULL;
+    }
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    /* Checks the arena identifier */
+    if( arena == 0 || arena > memdebug_arenas.count )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_INVALID_POINTER,
+            "Trying to allocate from a non-existing arena (arena: %lu)",
+            file,
+            line,
+            func,
+            arena
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return ptr;
+    }
+    
+    /* Room is kept for the leading fence */
+    if( memdebug_arenas.arenas[ arena - 1 ].fences == MEMDEBUG_TRUE )
+    {
+        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+    }
+    
+    /* The arena may reuse the address of a memory area after a reset, or without freeing it */
+    if( NULL != ( object = memdebug_index_find( &memdebug_arenas.index, ptr ) ) )
+    {
+        if( object->generation != memdebug_arenas.arenas[ object->arena - 1 ].generation )
+        {
+            memdebug_arena_retire( object );
+        }
+        else
+        {
+            memdebug_warning
+            (
+                MEMDEBUG_ERROR_INVALID_POINTER,
+                "The arena returned a memory area which was not freed (pointer address: %p)",
+                file,
+                line,
+                func,
+                ptr
+            );
+            
+            memdebug_arena_release( object, file, line, func );
+        }
+    }
+    
+    object = memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_ARENA_ALLOC );
+    
+    object->arena      = arena;
+    object->generation = memdebug_arenas.arenas[ arena - 1 ].generation;
+    
+    memdebug_index_insert( &memdebug_arenas.index, object );
+    
+    if( memdebug_arenas.arenas[ arena - 1 ].fences == MEMDEBUG_TRUE )
+    {
+        memdebug_write_fence( object );
+    }
+    
+    memdebug_arenas.arenas[ arena - 1 ].num_active++;
+    memdebug_arenas.arenas[ arena - 1 ].memory_active += size;
+    
+    MEMDEBUG_UNLOCK;
+    
+    return ptr;
+}
+
+/**
+ * Records the deallocation of an allocation made from an instrumented arena
+ * 
+ * @param   unsigned long int   The arena identifier, as returned by memdebug_arena_create()
+ * @param   void *              The address of the allocation, as returned by memdebug_arena_alloc()
+ * @param   const char *        The file in which the call was made
+ * @param   const int           The line of the file in which the call was made
+ * @param   const char *        The name of the function in which the call was made
+ * @return  void
+ */
+void memdebug_arena_free( unsigned long int arena, void * ptr, const char * file, const int line, const char * func )
+{
+    unsigned long int i;
+    struct memdebug_object * object;
+    
+    if( ptr == NULL )
+    {
+        return;
+    }
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    object = memdebug_index_find( &memdebug_arenas.index, ptr );
+    
+    /* The memory area may have been released by a reset of its arena */
+    if( object != NULL && object->generation != memdebug_arenas.arenas[ object->arena - 1 ].generation )
+    {
+        memdebug_arena_retire( object );
+        
+        object = NULL;
+    }
+    
+    if( object == NULL )
+    {
+        /* Freed memory records are only searched when an error is reported */
+        for( i = memdebug_trace->num_objects; i > 0; i-- )
+        {
+            if( memdebug_trace->objects[ i - 1 ].ptr == ptr && memdebug_trace->objects[ i - 1 ].arena == arena )
+            {
+                break;
+            }
+        }
+        
+        object = ( i > 0 ) ? &memdebug_trace->objects[ i - 1 ] : memdebug_archive_find( ptr, arena );
+        
+        if( object != NULL )
+        {
+            memdebug_warning
+            (
+                MEMDEBUG_ERROR_DOUBLE_FREE,
+                "Trying to free a freed arena object (pointer address: %p - freed at %s:%i)",
+                file,
+                line,
+                func,
+                ptr,
+                object->free_file,
+                object->free_line
+            );
+        }
+        else
+        {
+            memdebug_warning
+            (
+                MEMDEBUG_ERROR_INVALID_POINTER,
+                "Trying to free a non-existing arena object (pointer address: %p)",
+                file,
+                line,
+                func,
+                ptr
+            );
+        }
+        
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    /* Checks the memory area belongs to the arena */
+    if( object->arena != arena )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_INVALID_POINTER,
+            "Trying to free an object of another arena (pointer address: %p - arena: %s)",
+            file,
+            line,
+            func,
+            ptr,
+            memdebug_arenas.arenas[ object->arena - 1 ].name
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    if( memdebug_arenas.arenas[ arena - 1 ].fences == MEMDEBUG_TRUE && memdebug_check_fence( object ) == MEMDEBUG_FALSE )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_OVERFLOW,
+            "A buffer overflow was detected (pointer address: %p)",
+            file,
+            line,
+            func,
+            ptr
+        );
+    }
+    
+    memdebug_arena_release( object, file, line, func );
+    
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    /* Stores the address of the caller function */
+    object->free_func_addr = __builtin_return_address( 0 );
+    
+    #endif
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Resets an instrumented arena, releasing all of its allocations
+ * 
+ * The reset is made in constant time: the generation of the arena is
+ * incremented, and the counters are updated with the totals of the arena.
+ * The memory records of the previous generations are retired lazily, when
+ * their address is reused or before a report.
+ * 
+ * @param   unsigned long int   The arena identifier, as returned by memdebug_arena_create()
+ * @param   const char *        The file in which the call was made
+ * @param   const int           The line of the file in which the call was made
+ * @param   const char *        The name of the function in which the call was made
+ * @return  void
+ */
+void memdebug_arena_reset( unsigned long int arena, const char * file, const int line, const char * func )
+{
+    struct memdebug_arena * entry;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    /* Checks the arena identifier */
+    if( arena == 0 || arena > memdebug_arenas.count )
+    {
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_INVALID_POINTER,
+            "Trying to reset a non-existing arena (arena: %lu)",
+            file,
+            line,
+            func,
+            arena
+        );
+        
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    entry = &memdebug_arenas.arenas[ arena - 1 ];
+    
+    /* The active memory decreases */
+    memdebug_peak_release();
+    
+    entry->generation++;
+    entry->reset_seq  = memdebug_trace->sequence++;
+    entry->reset_file = file;
+    entry->reset_line = line;
+    entry->reset_func = func;
+    
+    /* The memory records of the previous generation are now free */
+    memdebug_arenas.stale         += entry->num_active;
+    memdebug_trace->num_active    -= entry->num_active;
+    memdebug_trace->num_free      += entry->num_active;
+    memdebug_trace->memory_active -= entry->memory_active;
+    
+    entry->num_active    = 0;
+    entry->memory_active = 0;
+    
+    memdebug_stats_update();
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Marks an active arena memory record object as free
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @param   const char *                The file in which the deallocation was made
+ * @param   const int                   The line of the file in which the deallocation was made
+ * @param   const char *                The name of the function in which the deallocation was made
+ * @return  void
+ */
+static void memdebug_arena_release( struct memdebug_object * object, const char * file, const int line, const char * func )
+{
+    memdebug_peak_release();
+    
+    object->free      = MEMDEBUG_TRUE;
+    object->free_file = file;
+    object->free_line = line;
+    object->free_func = func;
+    object->free_seq  = memdebug_trace->sequence++;
+    
+    memdebug_index_remove( &memdebug_arenas.index, object->ptr );
+    memdebug_site_remove( object->site, object->size );
+    
+    memdebug_sites.sites[ object->site ].lifetimes[ memdebug_log2( memdebug_ticks() - object->alloc_time ) ]++;
+    
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+    
+    memdebug_trace->num_active--;
+    memdebug_trace->num_free++;
+    memdebug_trace->memory_active -= object->size;
+    
+    memdebug_arenas.arenas[ object->arena - 1 ].num_active--;
+    memdebug_arenas.arenas[ object->arena - 1 ].memory_active -= object->size;
+    
+    memdebug_stats_update();
+}
+
+/**
+ * Retires an arena memory record object released by a reset of its arena
+ * 
+ * The global counters were already updated by memdebug_arena_reset().
+ * 
+ * @param   struct memdebug_object *    The memory record object, of a previous generation of its arena
+ * @return  void
+ */
+static void memdebug_arena_retire( struct memdebug_object * object )
+{
+    struct memdebug_arena * arena;
+    
+    arena = &memdebug_arenas.arenas[ object->arena - 1 ];
+    
+    /* Records left by several resets get the location of the last one */
+    object->free      = MEMDEBUG_TRUE;
+    object->free_file = arena->reset_file;
+    object->free_line = arena->reset_line;
+    object->free_func = arena->reset_func;
+    object->free_seq  = arena->reset_seq;
+    
+    /* Checks if we are using GCC */
+    #ifdef __GNUC__
+    
+    object->free_func_addr = NULL;
+    
+    #endif
+    
+    memdebug_index_remove( &memdebug_arenas.index, object->ptr );
+    memdebug_site_remove( object->site, object->size );
+    
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+    
+    memdebug_arenas.stale--;
+}
+
+/**
+ * Retires all the arena memory record objects released by resets
+ * 
+ * Called before the reports, so the allocation sites and the memory records
+ * reflect the resets.
+ * 
+ * @return  void
+ */
+static void memdebug_arena_retire_all( void )
+{
+    unsigned long int slot;
+    struct memdebug_object * object;
+    
+    slot = 0;
+    
+    while( memdebug_arenas.stale > 0 && slot < memdebug_arenas.index.capacity )
+    {
+        if( memdebug_arenas.index.slots[ slot ] != 0 )
+        {
+            object = &memdebug_trace->objects[ memdebug_arenas.index.slots[ slot ] - 1 ];
+            
+            if( object->generation != memdebug_arenas.arenas[ object->arena - 1 ].generation )
+            {
+                memdebug_arena_retire( object );
+                
+                /* The removal may have moved a following entry to this slot */
+                continue;
+            }
+        }
+        
+        slot++;
+    }
+}
+
+/**
+ * Maps memory
+ * 
+ * Mappings have no fences, as they are page-aligned. They are not checked
+ * for leaks, and are reported separately from the heap memory.
+ * 
+ * @param   void *          The requested address (or NULL)
+ * @param   size_t          The length of the mapping
+ * @param   int             The memory protection (PROT_XXX)
+ * @param   int             The mapping flags (MAP_XXX)
+ * @param   int             The file descriptor of the mapped file (or -1)
+ * @param   off_t           The offset in the mapped file
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  void *          The address of the mapping, or MAP_FAILED
+ */
+void * memdebug_mmap( void * addr, size_t length, int prot, int flags, int fd, off_t offset, const char * file, const int line, const char * func )
+{
+    int error;
+    void * ptr;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    ptr = mmap( addr, length, prot, flags, fd, offset );
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return ptr;
+    }
+    
+    if( ptr == MAP_FAILED )
+    {
+        error = errno;
+        
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to mmap() failed. Reason: %s",
+            file,
+            line,
+            func,
+            strerror( error )
+        );
+        
+        errno = error;
+        
+        return ptr;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    /* A fixed mapping replaces the existing ones */
+    if( flags & MAP_FIXED )
+    {
+        memdebug_mapping_unmap( ( char * )ptr, ( char * )ptr + MEMDEBUG_PAGE_ROUND( length ), file, line, func );
+    }
+    
+    memdebug_new_object( ptr, length, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_MMAP );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return ptr;
+}
+
+/**
+ * Unmaps memory
+ * 
+ * The range may cover several mappings, or only a part of one: a mapping
+ * unmapped in its middle is split in two memory records.
+ * 
+ * @param   void *          The address of the range to unmap
+ * @param   size_t          The length of the range to unmap
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @return  int             0, or -1 on failure (errno is set)
+ */
+int memdebug_munmap( void * addr, size_t length, const char * file, const int line, const char * func )
+{
+    int result;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    result = munmap( addr, length );
+    
+    /* Checks if MEMDebug is disabled, or if the call failed (nothing was unmapped) */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE || result != 0 )
+    {
+        return result;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_mapping_unmap( ( char * )addr, ( char * )addr + MEMDEBUG_PAGE_ROUND( length ), file, line, func );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return result;
+}
+
+/* Checks if the mremap function is available (Linux) */
+#ifdef MREMAP_MAYMOVE
+
+/**
+ * Remaps memory
+ * 
+ * A resized mapping keeps its memory record, which is accounted at the new
+ * site, like a reallocation. Other ranges are unmapped, and the new mapping
+ * is recorded.
+ * 
+ * @param   void *          The address of the mapping
+ * @param   size_t          The current length of the mapping
+ * @param   size_t          The new length of the mapping
+ * @param   const char *    The file in which the call was made
+ * @param   const int       The line of the file in which the call was made
+ * @param   const char *    The name of the function in which the call was made
+ * @param   int             The remapping flags (MREMAP_XXX), followed by the new address with MREMAP_FIXED
+ * @return  void *          The new address of the mapping, or MAP_FAILED
+ */
+void * memdebug_mremap( void * addr, size_t old_size, size_t new_size, const char * file, const int line, const char * func, int flags, ... )
+{
+    int error;
+    void * ptr;
+    void * new_address;
+    va_list args;
+    unsigned long int i;
+    struct memdebug_object * object;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    new_address = NULL;
+    
+    /* Checks if the new address is given */
+    #ifdef MREMAP_FIXED
+    
+    if( flags & MREMAP_FIXED )
+    {
+        va_start( args, flags );
+        
+        new_address = va_arg( args, void * );
+        
+        va_end( args );
+    }
+    
+    #endif
+    
+    ptr = mremap( addr, old_size, new_size, flags, new_address );
+    
+    /* Checks if MEMDebug is disabled */
+    if( memdebug_config.enabled == MEMDEBUG_FALSE )
+    {
+        return ptr;
+    }
+    
+    if( ptr == MAP_FAILED )
+    {
+        error = errno;
+        
+        memdebug_warning
+        (
+            MEMDEBUG_ERROR_ALLOC_FAILURE,
+            "The call to mremap() failed. Reason: %s",
             file,
             line,
             func,
-            ptr
+            strerror( error )
+        );
+        
+        errno = error;
+        
+        return ptr;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    /* A fixed remapping replaces the existing mappings */
+    if( ptr != addr )
+    {
+        memdebug_mapping_unmap( ( char * )ptr, ( char * )ptr + MEMDEBUG_PAGE_ROUND( new_size ), file, line, func );
+    }
+    
+    /* Finds the mapping, if the whole of it was remapped */
+    for( i = 0, object = NULL; i < memdebug_mappings.count; i++ )
+    {
+        object = &memdebug_trace->objects[ memdebug_mappings.records[ i ] ];
+        
+        if( object->ptr == addr && MEMDEBUG_PAGE_ROUND( object->size ) == MEMDEBUG_PAGE_ROUND( old_size ) )
+        {
+            break;
+        }
+        
+        object = NULL;
+    }
+    
+    if( object != NULL )
+    {
+        memdebug_peak_release();
+        
+        /* The address and the size may have changed */
+        memdebug_mapping_resize( object, ptr, new_size );
+        
+        /* A remapping is accounted as a deallocation and a new allocation, at the new site */
+        memdebug_site_remove( object->site, object->size );
+        
+        object->site       = memdebug_site_get( file, line, func, MEMDEBUG_CALLER );
+        object->alloc_time = memdebug_ticks();
+        object->alloc_file = file;
+        object->alloc_line = line;
+        object->alloc_func = func;
+        
+        memdebug_site_add( object->site, object->size );
+        
+        memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+        memdebug_histograms.live[ memdebug_type_index( MEMDEBUG_ALLOC_TYPE_MREMAP ) ][ memdebug_log2( object->size ) ]++;
+        memdebug_histograms.total[ memdebug_type_index( MEMDEBUG_ALLOC_TYPE_MREMAP ) ][ memdebug_log2( object->size ) ]++;
+        
+        object->alloc_type = MEMDEBUG_ALLOC_TYPE_MREMAP;
+        
+        /* Checks if we are using GCC */
+        #ifdef __GNUC__
+        
+        /* Stores the address of the caller function */
+        object->alloc_func_addr = __builtin_return_address( 0 );
+        
+        #endif
+        
+        memdebug_peak_check();
+        memdebug_stats_update();
+    }
+    else
+    {
+        /* Unknown or partially remapped mapping */
+        memdebug_mapping_unmap( ( char * )addr, ( char * )addr + MEMDEBUG_PAGE_ROUND( old_size ), file, line, func );
+        memdebug_new_object( ptr, new_size, file, line, func, MEMDEBUG_CALLER, MEMDEBUG_ALLOC_TYPE_MREMAP );
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    return ptr;
+}
+
+#endif
+
+/**
+ * Adds a new memory record object to the active memory mappings
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  void
+ */
+static void memdebug_mapping_add( struct memdebug_object * object )
+{
+    /* Checks if the records array is full */
+    if( memdebug_mappings.count == memdebug_mappings.capacity )
+    {
+        memdebug_mappings.capacity = ( memdebug_mappings.capacity == 0 ) ? MEMDEBUG_POOL_SIZE : memdebug_mappings.capacity * 2;
+        
+        if( NULL == ( memdebug_mappings.records = ( unsigned long int * )memdebug_meta_realloc( memdebug_mappings.records, memdebug_mappings.capacity * sizeof( unsigned long int ) ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot allocate the mappings. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+    }
+    
+    memdebug_mappings.records[ memdebug_mappings.count++ ] = ( unsigned long int )( object - memdebug_trace->objects );
+    memdebug_mappings.memory_total                        += object->size;
+    memdebug_mappings.memory_active                       += object->size;
+    
+    if( memdebug_mappings.memory_active > memdebug_mappings.memory_peak )
+    {
+        memdebug_mappings.memory_peak = memdebug_mappings.memory_active;
+    }
+}
+
+/**
+ * Changes the address and the size of an active mapping memory record object
+ * 
+ * The allocation site is not changed.
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @param   void *                      The new address of the mapping
+ * @param   size_t                      The new size of the mapping
+ * @return  void
+ */
+static void memdebug_mapping_resize( struct memdebug_object * object, void * ptr, size_t size )
+{
+    memdebug_peak_touch( object->site );
+    
+    memdebug_sites.sites[ object->site ].live_size -= object->size;
+    memdebug_sites.sites[ object->site ].live_size += size;
+    
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+    memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( size ) ]++;
+    
+    memdebug_trace->memory_active -= object->size;
+    memdebug_trace->memory_active += size;
+    memdebug_mappings.memory_active -= object->size;
+    memdebug_mappings.memory_active += size;
+    
+    /* Only the growth is new mapped memory */
+    if( size > object->size )
+    {
+        memdebug_trace->memory_total   += size - object->size;
+        memdebug_mappings.memory_total += size - object->size;
+    }
+    
+    if( memdebug_mappings.memory_active > memdebug_mappings.memory_peak )
+    {
+        memdebug_mappings.memory_peak = memdebug_mappings.memory_active;
+    }
+    
+    object->ptr  = ptr;
+    object->size = size;
+}
+
+/**
+ * Updates the active memory mappings after a range was unmapped
+ * 
+ * Mappings covered by the range are freed. Mappings partially covered are
+ * shrunk, or split in two memory records if the range is in their middle.
+ * 
+ * @param   char *          The start of the unmapped range
+ * @param   char *          The end of the unmapped range (page-aligned)
+ * @param   const char *    The file in which the deallocation was made
+ * @param   const int       The line of the file in which the deallocation was made
+ * @param   const char *    The name of the function in which the deallocation was made
+ * @return  void
+ */
+static void memdebug_mapping_unmap( char * start, char * end, const char * file, const int line, const char * func )
+{
+    unsigned long int i;
+    unsigned long long alloc_time;
+    char * mapping_start;
+    char * mapping_end;
+    size_t head;
+    size_t tail;
+    struct memdebug_object * object;
+    
+    i = 0;
+    
+    while( i < memdebug_mappings.count )
+    {
+        object        = &memdebug_trace->objects[ memdebug_mappings.records[ i ] ];
+        mapping_start = ( char * )object->ptr;
+        mapping_end   = mapping_start + MEMDEBUG_PAGE_ROUND( object->size );
+        
+        /* Checks if the mapping overlaps the range */
+        if( end <= mapping_start || start >= mapping_end )
+        {
+            i++;
+            
+            continue;
+        }
+        
+        /* The parts of the mapping before and after the range */
+        head = ( start > mapping_start ) ? ( size_t )( start - mapping_start ) : 0;
+        tail = ( end < mapping_start + object->size ) ? ( size_t )( mapping_start + object->size - end ) : 0;
+        
+        /* The active memory decreases */
+        memdebug_peak_release();
+        
+        if( head == 0 && tail == 0 )
+        {
+            /* The whole mapping was unmapped */
+            object->free      = MEMDEBUG_TRUE;
+            object->free_file = file;
+            object->free_line = line;
+            object->free_func = func;
+            object->free_seq  = memdebug_trace->sequence++;
+            
+            memdebug_site_remove( object->site, object->size );
+            
+            memdebug_sites.sites[ object->site ].lifetimes[ memdebug_log2( memdebug_ticks() - object->alloc_time ) ]++;
+            
+            memdebug_histograms.live[ memdebug_type_index( object->alloc_type ) ][ memdebug_log2( object->size ) ]--;
+            
+            /* Checks if we are using GCC */
+            #ifdef __GNUC__
+            
+            object->free_func_addr = NULL;
+            
+            #endif
+            
+            memdebug_trace->num_active--;
+            memdebug_trace->num_free++;
+            memdebug_trace->memory_active   -= object->size;
+            memdebug_mappings.memory_active -= object->size;
+            
+            /* The last mapping takes its place */
+            memdebug_mappings.records[ i ] = memdebug_mappings.records[ --memdebug_mappings.count ];
+        }
+        else if( tail == 0 )
+        {
+            memdebug_mapping_resize( object, object->ptr, head );
+            
+            i++;
+        }
+        else if( head == 0 )
+        {
+            memdebug_mapping_resize( object, end, tail );
+            
+            i++;
+        }
+        else
+        {
+            alloc_time = object->alloc_time;
+            
+            memdebug_mapping_resize( object, object->ptr, head );
+            
+            /* The tail is recorded as a new mapping, made at the same site (the pool may move, and its records be renumbered) */
+            object = memdebug_new_object( end, tail, object->alloc_file, object->alloc_line, object->alloc_func, memdebug_sites.sites[ object->site ].caller, object->alloc_type );
+            
+            /* Its lifetime starts with the mapping, but its sequence number is kept, as the pool is ordered by sequence */
+            object->alloc_time = alloc_time;
+            
+            /* Not a new allocation */
+            memdebug_trace->memory_total   -= tail;
+            memdebug_mappings.memory_total -= tail;
+            
+            i++;
+        }
+        
+        memdebug_stats_update();
+    }
+}
+
+/**
+ * Archives the oldest freed memory records, when the metadata exceeds its budget (meta_limit option)
+ * 
+ * The oldest half of the freed memory records of the pool are packed in
+ * the archive, and the remaining ones are moved down, in the same order.
+ * The memory record numbers held by the indexes, the quarantine and the
+ * mappings are renumbered. Quarantined memory records are kept, as their
+ * memory areas are not released yet. Nothing is done unless at least one
+ * record out of MEMDEBUG_ARCHIVE_RATIO is freed, so the cost of the scan
+ * stays proportional to the number of archived records.
+ * 
+ * @return  void
+ */
+static void memdebug_archive_records( void )
+{
+    unsigned long int i;
+    unsigned long int j;
+    unsigned long int num_free;
+    unsigned long int num_archived;
+    unsigned long int * records;
+    struct memdebug_object * object;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    num_free = memdebug_trace->num_objects - memdebug_trace->num_active;
+    
+    if( num_free == 0 || num_free < memdebug_trace->num_objects / MEMDEBUG_ARCHIVE_RATIO )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    /* The new memory record numbers, plus one (0 for the archived records) */
+    if( NULL == ( records = ( unsigned long int * )memdebug_meta_alloc( memdebug_trace->num_objects * sizeof( unsigned long int ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the archive. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Marks the quarantined memory records, which are kept */
+    for( i = 0; i < memdebug_quarantine.count; i++ )
+    {
+        records[ memdebug_quarantine.records[ ( memdebug_quarantine.head + i ) % memdebug_quarantine.capacity ] ] = 1;
+    }
+    
+    for( i = 0, j = 0, num_archived = 0; i < memdebug_trace->num_objects; i++ )
+    {
+        object = &memdebug_trace->objects[ i ];
+        
+        if( num_archived < ( num_free + 1 ) / 2 && object->free == MEMDEBUG_TRUE && records[ i ] == 0 )
+        {
+            memdebug_archive_add( object );
+            memdebug_meta_free( object->realloc_sizes );
+            
+            num_archived++;
+            
+            continue;
+        }
+        
+        if( j != i )
+        {
+            memcpy( &memdebug_trace->objects[ j ], object, sizeof( struct memdebug_object ) );
+        }
+        
+        records[ i ] = ++j;
+    }
+    
+    memset( &memdebug_trace->objects[ j ], 0, ( memdebug_trace->num_objects - j ) * sizeof( struct memdebug_object ) );
+    
+    memdebug_trace->num_objects = j;
+    
+    /* Renumbers the memory records - The slots of the indexes depend on the addresses only */
+    for( i = 0; i < memdebug_active_index.capacity; i++ )
+    {
+        if( memdebug_active_index.slots[ i ] != 0 )
+        {
+            memdebug_active_index.slots[ i ] = records[ memdebug_active_index.slots[ i ] - 1 ];
+        }
+    }
+    
+    for( i = 0; i < memdebug_arenas.index.capacity; i++ )
+    {
+        if( memdebug_arenas.index.slots[ i ] != 0 )
+        {
+            memdebug_arenas.index.slots[ i ] = records[ memdebug_arenas.index.slots[ i ] - 1 ];
+        }
+    }
+    
+    for( i = 0; i < memdebug_quarantine.count; i++ )
+    {
+        j = ( memdebug_quarantine.head + i ) % memdebug_quarantine.capacity;
+        
+        memdebug_quarantine.records[ j ] = records[ memdebug_quarantine.records[ j ] ] - 1;
+    }
+    
+    for( i = 0; i < memdebug_mappings.count; i++ )
+    {
+        memdebug_mappings.records[ i ] = records[ memdebug_mappings.records[ i ] ] - 1;
+    }
+    
+    memdebug_meta_free( records );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Drops the oldest archived memory records, while the metadata exceeds its budget (meta_limit option)
+ * 
+ * The oldest half of the archive is dropped at a time, and the remaining
+ * records are moved to a smaller buffer, so the memory is released. The
+ * dropped records are only counted.
+ * 
+ * @param   size_t  The growth of the metadata about to be made, in bytes
+ * @return  void
+ */
+static void memdebug_archive_trim( size_t growth )
+{
+    unsigned long int i;
+    unsigned long int num_dropped;
+    unsigned char * data;
+    struct memdebug_object object;
+    struct memdebug_archive_cursor cursor;
+    
+    while( memdebug_archive.count > 0 && memdebug_meta.used + growth > memdebug_config.meta_limit )
+    {
+        memdebug_archive_rewind( &cursor );
+        
+        num_dropped = ( memdebug_archive.count + 1 ) / 2;
+        
+        for( i = 0; i < num_dropped; i++ )
+        {
+            memdebug_archive_next( &cursor, &object );
+        }
+        
+        memdebug_archive.count     -= num_dropped;
+        memdebug_archive.dropped   += num_dropped;
+        memdebug_archive.size      -= cursor.offset;
+        memdebug_archive.first_ptr  = cursor.ptr;
+        memdebug_archive.first_seq  = cursor.seq;
+        
+        /* The next records are delta-encoded from the last archived one, which is kept */
+        if( memdebug_archive.count == 0 )
+        {
+            memdebug_meta_free( memdebug_archive.data );
+            
+            memdebug_archive.data     = NULL;
+            memdebug_archive.capacity = 0;
+            
+            break;
+        }
+        
+        memdebug_archive.capacity = memdebug_archive.size + MEMDEBUG_ARCHIVE_SIZE;
+        
+        if( NULL == ( data = ( unsigned char * )memdebug_meta_alloc( memdebug_archive.capacity ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot allocate the archive. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        memcpy( data, memdebug_archive.data + cursor.offset, memdebug_archive.size );
+        memdebug_meta_free( memdebug_archive.data );
+        
+        memdebug_archive.data = data;
+    }
+}
+
+/**
+ * Initializes a cursor at the first archived memory record
+ * 
+ * @param   struct memdebug_archive_cursor *    The position in the archive
+ * @return  void
+ */
+static void memdebug_archive_rewind( struct memdebug_archive_cursor * cursor )
+{
+    cursor->offset = 0;
+    cursor->ptr    = memdebug_archive.first_ptr;
+    cursor->seq    = memdebug_archive.first_seq;
+}
+
+/**
+ * Packs a freed memory record at the end of the archive
+ * 
+ * Each record is a list of variable-length integers (7 bits per byte, the
+ * high bit marking a following byte): the allocation type number (shifted
+ * left, with a flag for the reallocation and arena fields), the address
+ * and the allocation sequence number as signed deltas from the previous
+ * record, the size, the numbers of the allocation and deallocation call
+ * sites, the number of operations between the allocation and the
+ * deallocation, and, if flagged, the arena and the reallocation counters.
+ * A record usually takes 10 to 15 bytes.
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  void
+ */
+static void memdebug_archive_add( struct memdebug_object * object )
+{
+    size_t delta;
+    memdebug_bool extra;
+    
+    extra = ( object->arena != 0 || object->realloc_count != 0 ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    
+    memdebug_archive_put( ( ( size_t )memdebug_type_index( object->alloc_type ) << 1 ) | ( size_t )extra );
+    
+    /* Signed deltas, with the sign in the lowest bit (zigzag encoding) */
+    delta = ( size_t )object->ptr - memdebug_archive.last_ptr;
+    
+    memdebug_archive_put( ( delta & ~( ( size_t )-1 >> 1 ) ) ? ( ~delta << 1 ) | 1 : delta << 1 );
+    memdebug_archive_put( object->size );
+    memdebug_archive_put( memdebug_archive_site( object->alloc_file, object->alloc_line, object->alloc_func ) );
+    memdebug_archive_put( memdebug_archive_site( object->free_file, object->free_line, object->free_func ) );
+    
+    delta = ( size_t )( object->alloc_seq - memdebug_archive.last_seq );
+    
+    memdebug_archive_put( ( delta & ~( ( size_t )-1 >> 1 ) ) ? ( ~delta << 1 ) | 1 : delta << 1 );
+    memdebug_archive_put( object->free_seq - object->alloc_seq );
+    
+    if( extra == MEMDEBUG_TRUE )
+    {
+        memdebug_archive_put( object->arena );
+        memdebug_archive_put( object->realloc_count );
+        memdebug_archive_put( object->realloc_copied );
+    }
+    
+    memdebug_archive.last_ptr = ( size_t )object->ptr;
+    memdebug_archive.last_seq = object->alloc_seq;
+    
+    memdebug_archive.count++;
+}
+
+/**
+ * Writes a variable-length integer at the end of the archive
+ * 
+ * @param   size_t  The value
+ * @return  void
+ */
+static void memdebug_archive_put( size_t value )
+{
+    /* A value takes at most 10 bytes */
+    if( memdebug_archive.size + 10 > memdebug_archive.capacity )
+    {
+        memdebug_archive.capacity = ( memdebug_archive.capacity == 0 ) ? MEMDEBUG_ARCHIVE_SIZE : memdebug_archive.capacity * 2;
+        
+        if( NULL == ( memdebug_archive.data = ( unsigned char * )memdebug_meta_realloc( memdebug_archive.data, memdebug_archive.capacity ) ) )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the archive. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+    }
+    
+    while( value >= 0x80 )
+    {
+        memdebug_archive.data[ memdebug_archive.size++ ] = ( unsigned char )( value | 0x80 );
+        
+        value >>= 7;
+    }
+    
+    memdebug_archive.data[ memdebug_archive.size++ ] = ( unsigned char )value;
+}
+
+/**
+ * Reads a variable-length integer from the archive
+ * 
+ * @param   struct memdebug_archive_cursor *    The position in the archive
+ * @return  size_t                              The value
+ */
+static size_t memdebug_archive_get( struct memdebug_archive_cursor * cursor )
+{
+    size_t value;
+    unsigned int shift;
+    
+    for( value = 0, shift = 0; cursor->offset < memdebug_archive.size; shift += 7 )
+    {
+        value |= ( size_t )( memdebug_archive.data[ cursor->offset ] & 0x7F ) << shift;
+        
+        if( !( memdebug_archive.data[ cursor->offset++ ] & 0x80 ) )
+        {
+            break;
+        }
+    }
+    
+    return value;
+}
+
+/**
+ * Gets the number of a call site of the archive, creating it if needed
+ * 
+ * @param   const char *        The name of the file of the call
+ * @param   const int           The line of the file of the call
+ * @param   const char *        The name of the function of the call
+ * @return  unsigned long int   The call site number
+ */
+static unsigned long int memdebug_archive_site( const char * file, const int line, const char * func )
+{
+    unsigned long int i;
+    unsigned long int slot;
+    struct memdebug_archive_site * site;
+    
+    if( memdebug_archive.slots_capacity > 0 )
+    {
+        slot = memdebug_site_hash( file, line, func, memdebug_archive.slots_capacity );
+        
+        while( memdebug_archive.slots[ slot ] != 0 )
+        {
+            site = &memdebug_archive.sites[ memdebug_archive.slots[ slot ] - 1 ];
+            
+            if( site->file == file && site->line == line && site->func == func )
+            {
+                return memdebug_archive.slots[ slot ] - 1;
+            }
+            
+            slot = ( slot + 1 ) & ( memdebug_archive.slots_capacity - 1 );
+        }
+    }
+    
+    /* New call site - Keeps the load factor of the table under 50% */
+    if( memdebug_archive.num_sites == memdebug_archive.sites_size )
+    {
+        memdebug_meta_free( memdebug_archive.slots );
+        
+        memdebug_archive.slots_capacity = ( memdebug_archive.slots_capacity == 0 ) ? MEMDEBUG_SITES_SIZE : memdebug_archive.slots_capacity * 2;
+        memdebug_archive.sites_size     = memdebug_archive.slots_capacity / 2;
+        
+        if
+        (
+               NULL == ( memdebug_archive.slots = ( unsigned long int * )memdebug_meta_alloc( memdebug_archive.slots_capacity * sizeof( unsigned long int ) ) )
+            || NULL == ( memdebug_archive.sites = ( struct memdebug_archive_site * )memdebug_meta_realloc( memdebug_archive.sites, memdebug_archive.sites_size * sizeof( struct memdebug_archive_site ) ) )
+        )
+        {
+            memdebug_fatal
+            (
+                "MEMDebug error: cannot reallocate the call sites of the archive. Reason: %s\n",
+                strerror( errno )
+            );
+        }
+        
+        /* Rehashes the existing call sites */
+        for( i = 0; i < memdebug_archive.num_sites; i++ )
+        {
+            site = &memdebug_archive.sites[ i ];
+            slot = memdebug_site_hash( site->file, site->line, site->func, memdebug_archive.slots_capacity );
+            
+            while( memdebug_archive.slots[ slot ] != 0 )
+            {
+                slot = ( slot + 1 ) & ( memdebug_archive.slots_capacity - 1 );
+            }
+            
+            memdebug_archive.slots[ slot ] = i + 1;
+        }
+    }
+    
+    slot = memdebug_site_hash( file, line, func, memdebug_archive.slots_capacity );
+    
+    while( memdebug_archive.slots[ slot ] != 0 )
+    {
+        slot = ( slot + 1 ) & ( memdebug_archive.slots_capacity - 1 );
+    }
+    
+    site = &memdebug_archive.sites[ memdebug_archive.num_sites ];
+    
+    site->file = file;
+    site->line = line;
+    site->func = func;
+    
+    memdebug_archive.slots[ slot ] = ++memdebug_archive.num_sites;
+    
+    return memdebug_archive.num_sites - 1;
+}
+
+/**
+ * Unpacks the next memory record of the archive
+ * 
+ * The archive is read sequentially, from a cursor initialized to zero, as
+ * the addresses and sequence numbers are delta-encoded. The addresses of
+ * the functions and the history of the sizes are not archived.
+ * 
+ * @param   struct memdebug_archive_cursor *    The position in the archive
+ * @param   struct memdebug_object *            The memory record object to fill
+ * @return  memdebug_bool                       MEMDEBUG_FALSE at the end of the archive
+ */
+static memdebug_bool memdebug_archive_next( struct memdebug_archive_cursor * cursor, struct memdebug_object * object )
+{
+    size_t header;
+    size_t delta;
+    struct memdebug_archive_site * site;
+    
+    if( cursor->offset >= memdebug_archive.size )
+    {
+        return MEMDEBUG_FALSE;
+    }
+    
+    memset( object, 0, sizeof( struct memdebug_object ) );
+    
+    header = memdebug_archive_get( cursor );
+    delta  = memdebug_archive_get( cursor );
+    
+    cursor->ptr += ( delta & 1 ) ? ~( delta >> 1 ) : delta >> 1;
+    
+    object->free       = MEMDEBUG_TRUE;
+    object->alloc_type = ( memdebug_alloc_type )( 1UL << ( header >> 1 ) );
+    object->ptr        = ( void * )cursor->ptr;
+    object->size       = memdebug_archive_get( cursor );
+    
+    site = &memdebug_archive.sites[ memdebug_archive_get( cursor ) ];
+    
+    object->alloc_file = site->file;
+    object->alloc_line = site->line;
+    object->alloc_func = site->func;
+    
+    site = &memdebug_archive.sites[ memdebug_archive_get( cursor ) ];
+    
+    object->free_file = site->file;
+    object->free_line = site->line;
+    object->free_func = site->func;
+    
+    delta = memdebug_archive_get( cursor );
+    
+    cursor->seq += ( unsigned long int )( ( delta & 1 ) ? ~( delta >> 1 ) : delta >> 1 );
+    
+    object->alloc_seq = cursor->seq;
+    object->free_seq  = cursor->seq + ( unsigned long int )memdebug_archive_get( cursor );
+    
+    if( header & 1 )
+    {
+        object->arena          = ( unsigned long int )memdebug_archive_get( cursor );
+        object->realloc_count  = ( unsigned long int )memdebug_archive_get( cursor );
+        object->realloc_copied = memdebug_archive_get( cursor );
+    }
+    
+    return MEMDEBUG_TRUE;
+}
+
+/**
+ * Finds the most recent archived memory record of an address
+ * 
+ * The whole archive is unpacked, so this is only used when an error is
+ * about to be reported (double free or invalid pointer).
+ * 
+ * @param   void *                      The address of the memory area
+ * @param   unsigned long int           The arena of the memory area, or 0 for the memory areas released by free
+ * @return  struct memdebug_object *    The memory record object (valid until the next call), or NULL if the address is not archived
+ */
+static struct memdebug_object * memdebug_archive_find( void * ptr, unsigned long int arena )
+{
+    memdebug_bool found;
+    struct memdebug_object object;
+    struct memdebug_archive_cursor cursor;
+    
+    memdebug_archive_rewind( &cursor );
+    
+    found = MEMDEBUG_FALSE;
+    
+    while( memdebug_archive_next( &cursor, &object ) == MEMDEBUG_TRUE )
+    {
+        if( object.ptr != ptr || object.arena != arena || ( arena == 0 && object.alloc_type & MEMDEBUG_ALLOC_TYPE_UNFENCED ) )
+        {
+            continue;
+        }
+        
+        memcpy( &memdebug_archive_object, &object, sizeof( struct memdebug_object ) );
+        
+        found = MEMDEBUG_TRUE;
+    }
+    
+    return ( found == MEMDEBUG_TRUE ) ? &memdebug_archive_object : NULL;
+}
+
+/**
+ * Prints the archived memory records (see memdebug_print_objects() and memdebug_print_free())
+ * 
+ * @return  void
+ */
+static void memdebug_print_archive( void )
+{
+    unsigned long int record;
+    struct memdebug_object object;
+    struct memdebug_archive_cursor cursor;
+    
+    memdebug_archive_rewind( &cursor );
+    
+    for( record = memdebug_archive.dropped + 1; memdebug_archive_next( &cursor, &object ) == MEMDEBUG_TRUE; record++ )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# \n"
+            "# - Memory record:           #%lu (archived)\n",
+            record
+        );
+        memdebug_print_object( &object );
+    }
+}
+
+/**
+ * Initializes a buffered output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   int                         The file descriptor the data will be written to
+ * @return  void
+ */
+static void memdebug_writer_init( struct memdebug_writer * writer, int fd )
+{
+    writer->fd     = fd;
+    writer->length = 0;
+}
+
+/**
+ * Writes the buffered data of an output writer to its file descriptor
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @return  void
+ */
+static void memdebug_writer_flush( struct memdebug_writer * writer )
+{
+    size_t  written;
+    ssize_t result;
+    
+    written = 0;
+    
+    /* Writes the whole buffer, handling partial writes and interruptions */
+    while( written < writer->length )
+    {
+        result = write( writer->fd, writer->data + written, writer->length - written );
+        
+        if( result < 0 )
+        {
+            if( errno == EINTR )
+            {
+                continue;
+            }
+            
+            /* Output error - The buffered data is lost */
+            break;
+        }
+        
+        written += ( size_t )result;
+    }
+    
+    writer->length = 0;
+}
+
+/**
+ * Reserves room in the buffer of an output writer, flushing it if needed
+ * 
+ * The reserved bytes are accounted as written, so the caller must fill them.
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   size_t                      The number of bytes to reserve (must not exceed MEMDEBUG_WRITER_SIZE)
+ * @return  char *                      The address of the reserved bytes
+ */
+static char * memdebug_writer_reserve( struct memdebug_writer * writer, size_t length )
+{
+    char * ptr;
+    
+    /* Checks if there's enough room left in the buffer */
+    if( writer->length + length > MEMDEBUG_WRITER_SIZE )
+    {
+        memdebug_writer_flush( writer );
+    }
+    
+    ptr             = writer->data + writer->length;
+    writer->length += length;
+    
+    return ptr;
+}
+
+/**
+ * Appends data to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   const char *                The data to append
+ * @param   size_t                      The length of the data
+ * @return  void
+ */
+static void memdebug_writer_append( struct memdebug_writer * writer, const char * str, size_t length )
+{
+    size_t chunk;
+    
+    while( length > 0 )
+    {
+        chunk = ( length > MEMDEBUG_WRITER_SIZE ) ? MEMDEBUG_WRITER_SIZE : length;
+        
+        memcpy( memdebug_writer_reserve( writer, chunk ), str, chunk );
+        
+        str    += chunk;
+        length -= chunk;
+    }
+}
+
+/**
+ * Appends the decimal representation of an unsigned integer to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   unsigned long int           The value
+ * @return  void
+ */
+static void memdebug_writer_append_ulong( struct memdebug_writer * writer, unsigned long int value )
+{
+    char   digits[ 24 ];
+    char * ptr;
+    
+    ptr = digits + sizeof( digits );
+    
+    do
+    {
+        *( --ptr ) = ( char )( '0' + ( value % 10 ) );
+        value     /= 10;
+    }
+    while( value > 0 );
+    
+    memdebug_writer_append( writer, ptr, ( size_t )( digits + sizeof( digits ) - ptr ) );
+}
+
+/**
+ * Appends the hexadecimal representation of a pointer to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   const void *                The pointer
+ * @return  void
+ */
+static void memdebug_writer_append_pointer( struct memdebug_writer * writer, const void * ptr )
+{
+    char        digits[ 24 ];
+    char      * digit;
+    size_t      value;
+    
+    value = ( size_t )ptr;
+    digit = digits + sizeof( digits );
+    
+    do
+    {
+        *( --digit ) = memdebug_hex_digits[ value & 0x0F ];
+        value      >>= 4;
+    }
+    while( value > 0 );
+    
+    *( --digit ) = 'x';
+    *( --digit ) = '0';
+    
+    memdebug_writer_append( writer, digit, ( size_t )( digits + sizeof( digits ) - digit ) );
+}
+
+/**
+ * Appends a number in lowercase hexadecimal (with a 0x prefix) to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   size_t                      The number
+ * @return  void
+ */
+static void memdebug_writer_append_hex( struct memdebug_writer * writer, size_t value )
+{
+    char        digits[ 24 ];
+    char      * digit;
+    
+    digit = digits + sizeof( digits );
+    
+    do
+    {
+        *( --digit ) = "0123456789abcdef"[ value & 0x0F ];
+        value      >>= 4;
+    }
+    while( value > 0 );
+    
+    *( --digit ) = 'x';
+    *( --digit ) = '0';
+    
+    memdebug_writer_append( writer, digit, ( size_t )( digits + sizeof( digits ) - digit ) );
+}
+
+/**
+ * Appends a JSON string literal to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   const char *                The string (NULL is written as null)
+ * @return  void
+ */
+static void memdebug_writer_append_json_string( struct memdebug_writer * writer, const char * str )
+{
+    const char  * start;
+    char        * escape;
+    unsigned char c;
+    
+    if( str == NULL )
+    {
+        MEMDEBUG_WRITER_LITERAL( writer, "null" );
+        return;
+    }
+    
+    MEMDEBUG_WRITER_LITERAL( writer, "\"" );
+    
+    start = str;
+    
+    for( ; *( str ) != 0; str++ )
+    {
+        c = ( unsigned char )*( str );
+        
+        /* Characters not needing an escape sequence are copied in runs */
+        if( c >= 0x20 && c != '"' && c != '\\' )
+        {
+            continue;
+        }
+        
+        memdebug_writer_append( writer, start, ( size_t )( str - start ) );
+        
+        escape      = memdebug_writer_reserve( writer, 6 );
+        escape[ 0 ] = '\\';
+        escape[ 1 ] = 'u';
+        escape[ 2 ] = '0';
+        escape[ 3 ] = '0';
+        escape[ 4 ] = memdebug_hex_digits[ c >> 4 ];
+        escape[ 5 ] = memdebug_hex_digits[ c & 0x0F ];
+        start       = str + 1;
+    }
+    
+    memdebug_writer_append( writer, start, ( size_t )( str - start ) );
+    MEMDEBUG_WRITER_LITERAL( writer, "\"" );
+}
+
+/**
+ * Appends a CSV field to the buffer of an output writer
+ * 
+ * The field is quoted only if it contains a separator, a quote or a line break.
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   const char *                The string (NULL is written as an empty field)
+ * @return  void
+ */
+static void memdebug_writer_append_csv_string( struct memdebug_writer * writer, const char * str )
+{
+    const char * quote;
+    
+    if( str == NULL )
+    {
+        return;
+    }
+    
+    if( strpbrk( str, ",\"\r\n" ) == NULL )
+    {
+        memdebug_writer_append( writer, str, strlen( str ) );
+        return;
+    }
+    
+    MEMDEBUG_WRITER_LITERAL( writer, "\"" );
+    
+    /* Quotes are escaped by doubling them */
+    while( NULL != ( quote = strchr( str, '"' ) ) )
+    {
+        memdebug_writer_append( writer, str, ( size_t )( quote - str ) + 1 );
+        MEMDEBUG_WRITER_LITERAL( writer, "\"" );
+        
+        str = quote + 1;
+    }
+    
+    memdebug_writer_append( writer, str, strlen( str ) );
+    MEMDEBUG_WRITER_LITERAL( writer, "\"" );
+}
+
+/**
+ * Formats a line of the memory data dump
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   const unsigned char *       The data of the line
+ * @param   size_t                      The byte offset of the line
+ * @param   size_t                      The number of bytes in the line (at most MEMDEBUG_DUMP_BYTES)
+ * @return  void
+ */
+static void memdebug_dump_line( struct memdebug_writer * writer, const unsigned char * data, size_t offset, size_t length )
+{
+    char * line;
+    char * hex;
+    char * ascii;
+    size_t i;
+    unsigned char c;
+    
+    line = memdebug_writer_reserve( writer, MEMDEBUG_DUMP_LINE_SIZE );
+    
+    /* Byte offset (10 decimal digits) */
+    memcpy( line, "#   ", 4 );
+    
+    for( i = 14; i > 4; i-- )
+    {
+        line[ i - 1 ] = ( char )( '0' + ( offset % 10 ) );
+        offset       /= 10;
+    }
+    
+    line[ 14 ] = ':';
+    line[ 15 ] = ' ';
+    hex        = line + 16;
+    ascii      = hex + ( 3 * MEMDEBUG_DUMP_BYTES ) + 2;
+    
+    /* Hexadecimal and ASCII representations */
+    for( i = 0; i < length; i++ )
+    {
+        c          = data[ i ];
+        hex[ 0 ]   = memdebug_hex_digits[ c >> 4 ];
+        hex[ 1 ]   = memdebug_hex_digits[ c & 0x0F ];
+        hex[ 2 ]   = ' ';
+        hex       += 3;
+        ascii[ i ] = ( c >= 0x20 && c < 0x7F ) ? ( char )c : '.';
+    }
+    
+    /* No data to display - Pad */
+    memset( hex, ' ', 3 * ( MEMDEBUG_DUMP_BYTES - length ) );
+    
+    /* Separator */
+    hex         = line + 16 + ( 3 * MEMDEBUG_DUMP_BYTES );
+    hex[ 0 ]    = '|';
+    hex[ 1 ]    = ' ';
+    
+    /* New line for the next offset */
+    ascii[ length ] = '\n';
+    
+    /* Gives back the unused part of the reservation */
+    writer->length -= MEMDEBUG_DUMP_BYTES - length;
+}
+
+/**
+ * Displays an hexadecimal and ASCII representation of a memory record object
+ * 
+ * The dump is formatted in a buffer and written with a few system calls.
+ * It may be truncated (see memdebug_set_dump_options()), and repeated
+ * identical lines may be collapsed into a single '*' line.
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  void
+ */
+static void memdebug_dump( struct memdebug_object * object )
+{
+    size_t i;
+    size_t length;
+    size_t head_end;
+    size_t tail_start;
+    unsigned char * read_ptr;
+    memdebug_bool repeated;
+    char skipped[ 64 ];
+    
+    /* Gets a pointer to read the memory area of the object */
+    read_ptr = ( unsigned char * )object->ptr;
+    
+    /* Computes the displayed parts, rounded to complete lines */
+    head_end   = object->size;
+    tail_start = object->size;
+    
+    if( ( memdebug_dump_head > 0 || memdebug_dump_tail > 0 ) && memdebug_dump_head + memdebug_dump_tail < object->size )
+    {
+        head_end   = ( ( memdebug_dump_head + MEMDEBUG_DUMP_BYTES - 1 ) / MEMDEBUG_DUMP_BYTES ) * MEMDEBUG_DUMP_BYTES;
+        tail_start = ( ( object->size - memdebug_dump_tail ) / MEMDEBUG_DUMP_BYTES ) * MEMDEBUG_DUMP_BYTES;
+        
+        if( head_end >= tail_start )
+        {
+            head_end   = object->size;
+            tail_start = object->size;
+        }
+    }
+    
+    /* The output stream may contain pending data, which must come first */
+    fflush( memdebug_output );
+    memdebug_writer_init( &memdebug_dump_writer, fileno( memdebug_output ) );
+    
+    repeated = MEMDEBUG_FALSE;
+    
+    /* Reads the memory area */
+    for( i = 0; i < object->size; i += MEMDEBUG_DUMP_BYTES )
+    {
+        /* Checks if we are entering the truncated part */
+        if( i == head_end && tail_start > head_end )
+        {
+            sprintf
+            (
+                skipped,
+                "#   [... %lu bytes skipped ...]\n",
+                ( unsigned long int )( tail_start - head_end )
+            );
+            memdebug_writer_append( &memdebug_dump_writer, skipped, strlen( skipped ) );
+            
+            i        = tail_start;
+            repeated = MEMDEBUG_FALSE;
+            
+            if( i >= object->size )
+            {
+                break;
+            }
+        }
+        
+        length = ( object->size - i < MEMDEBUG_DUMP_BYTES ) ? object->size - i : MEMDEBUG_DUMP_BYTES;
+        
+        /* Checks if the line is the same as the previous one */
+        if
+        (
+               memdebug_dump_collapse == MEMDEBUG_TRUE
+            && i > 0
+            && i != tail_start
+            && length == MEMDEBUG_DUMP_BYTES
+            && memcmp( read_ptr + i, read_ptr + i - MEMDEBUG_DUMP_BYTES, MEMDEBUG_DUMP_BYTES ) == 0
+        )
+        {
+            /* Only the first repetition is marked */
+            if( repeated == MEMDEBUG_FALSE )
+            {
+                MEMDEBUG_WRITER_LITERAL( &memdebug_dump_writer, "#   *\n" );
+                
+                repeated = MEMDEBUG_TRUE;
+            }
+            
+            continue;
+        }
+        
+        repeated = MEMDEBUG_FALSE;
+        
+        memdebug_dump_line( &memdebug_dump_writer, read_ptr + i, i, length );
+    }
+    
+    memdebug_writer_flush( &memdebug_dump_writer );
+}
+
+/* Checks if we can have a backtrace */
+#ifdef MEMDEBUG_HAVE_EXECINFO_H
+
+/**
+ * Displays the backtrace (function call stack)
+ * 
+ * @return  void
+ */
+void memdebug_backtrace( unsigned int skip_levels )
+{
+    size_t size;
+    size_t i;
+    size_t j;
+    void ** trace;
+    char ** symbols;
+    char * symbol;
+    unsigned long int frame_num;
+    
+    /* Allocates enough memory for the backtrace informations */
+    if( NULL == ( trace = ( void ** )memdebug_meta_alloc( ( MEMDEBUG_BACKTRACE_SIZE + skip_levels ) * sizeof( void * ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the backtrace. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Gets the backtrace */
+    size    = backtrace( trace, MEMDEBUG_BACKTRACE_SIZE + skip_levels );
+    
+    /* Gets the symbols for the backtrace */
+    symbols = backtrace_symbols( trace, size );
+    
+    /* Header */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Backtrace\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+    );
+    
+    /* Number of stack frames */
+    fprintf
+    (
+        memdebug_output,
+        "# Displaying %lu stack frames:\n"
+        "# \n",
+        ( unsigned long int )size - skip_levels
+    );
+    
+    /* Process each frame */
+    for( i = skip_levels; i < size; i++ )
+    {
+        /* Current symbol */
+        symbol = symbols[ i ];
+        
+        /* Process each character of the symbol string */
+        for( j = 0; j < strlen( symbol ); j++ )
+        {
+            /* Checks if the frame number was passed, as we are going to rewrite it */
+            if( symbol[ j ] != ' ' && ( symbol[ j ] < 48 || symbol[ j ] > 57 ) )
+            {
+                break;
+            }
+            
+            /* Still on the frame number - Increments the pointer so we don't print it */
+            symbol++;
+        }
+        
+        /* Frame number of the symbol */
+        frame_num = ( unsigned long int )i - skip_levels;
+        
+        /* Checks the frame number, in order to get a clean outpout */
+        if( frame_num < 10 )
+        {
+            fprintf
+            (
+                memdebug_output,
+                "#     %lu:    %s\n",
+                frame_num,
+                ++symbol
+            );
+        }
+        else if( frame_num < 100 )
+        {
+            fprintf
+            (
+                memdebug_output,
+                "#     %lu:   %s\n",
+                frame_num,
+                ++symbol
+            );
+        }
+        else if( frame_num < 1000 )
+        {
+            fprintf
+            (
+                memdebug_output,
+                "#     %lu:  %s\n",
+                frame_num,
+                ++symbol
+            );
+        }
+        else if( frame_num < 10000 )
+        {
+            fprintf
+            (
+                memdebug_output,
+                "#     %lu: %s\n",
+                frame_num,
+                ++symbol
+            );
+        }
+        else
+        {
+            fprintf
+            (
+                memdebug_output,
+                "#     %lu:%s\n",
+                frame_num,
+                ++symbol
+            );
+        }
+    }
+    
+    /* Horizontal ruler */
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    /* Frees the allocated memory for the backtrace and the backtrace symbols */
+    memdebug_meta_free( trace );
+    free( symbols );
+}
+
+#endif
+
+/**
+ * Asks for a debug command
+ * 
+ * @return void
+ */
+static void memdebug_ask_debug_cmd( void )
+{
+    char c;
+    static unsigned int skip_levels = 3;
+    
+    fprintf
+    (
+       memdebug_output,
+       "# \n"
+       "# Your choices are:\n"
+       "# \n"
+       "#     - c : Default: continue the program execution\n"
+       "#     - q : Abort the program execution\n"
+       "#     - s : Display the status of the memory allocations\n"
+   );
+    
+    /* Checks if we can have a backtrace */
+    #ifdef MEMDEBUG_HAVE_EXECINFO_H
+    fprintf
+    (
+        memdebug_output,
+        "#     - t : Display the backtrace (function call stack)\n"
+    );
+    #endif
+    
+    fprintf
+    (
+        memdebug_output,
+        "#     - p : Display all memory records (active and free)\n"
+        "#     - a : Display only the active memory records\n"
+        "#     - f : Display only the freed memory records\n"
+        "# \n"
+        MEMDEBUG_HR
+        "\n"
+        "Choice: "
+    );
+    
+    /* Reads a character from STDIN to know what to do */
+    fflush( stdin );
+    c = getchar();
+    
+    /* Checks if the user choosed a command */
+    if( c == '\n' )
+    {
+        /* Default - continues the program execution */
+        return;
+    }
+    
+    /* Don't not about the next characters */
+    while( getchar() != '\n' ) {}
+    
+    /* Checks if the user answer */
+    if( c == 's' || c == 'S' )
+    {
+        /* Prints the memory allocation status */
+        fprintf( memdebug_output, "\n" );
+        memdebug_print_status();
+        
+    }
+    
+    /* Checks if we can have a backtrace */
+    #ifdef MEMDEBUG_HAVE_EXECINFO_H
+    
+    else if( c == 't' || c == 'T' )
+    {
+        /* Prints the function call stack */
+        fprintf( memdebug_output, "\n" );
+        memdebug_backtrace( skip_levels );
+    }
+    
+    #endif
+    
+    else if( c == 'p' || c == 'P' )
+    {
+        /* Prints all allocated objects */
+        fprintf( memdebug_output, "\n" );
+        memdebug_print_objects();
+    }
+    else if( c == 'a' || c == 'A' )
+    {
+        /* Prints all active objects */
+        fprintf( memdebug_output, "\n" );
+        memdebug_print_active();
+    }
+    else if( c == 'f' || c == 'F' )
+    {
+        /* Prints all freed objects */
+        fprintf( memdebug_output, "\n" );
+        memdebug_print_free();
+    }
+    else if( c == 'q' || c == 'Q' )
+    {
+        /* Aborts the program execution */
+        fprintf
+        (
+            memdebug_output,
+            "\n"
+            "Program execution stopped\n"
+        );
+        exit( EXIT_FAILURE );
+    }
+    else
+    {
+        /* Default - continues the program execution */
+        return;
+    }
+    
+    skip_levels++;
+    
+    /* Asks for a command again */
+    memdebug_ask_debug_cmd();
+}
+
+/**
+ * Handles signals (SIGSEGV and SIGBUS)
+ * 
+ * @param   int     The ID of the signal
+ * @return  void
+ */
+static void memdebug_sig_handler( int id )
+{
+    int action;
+    
+    action = memdebug_config.actions[ MEMDEBUG_ERROR_SIGNAL ];
+    
+    /* Checks the signal ID */
+    if( id == SIGSEGV || id == SIGBUS )
+    {
+        /* Nothing to report - The default handling of the signal applies */
+        if( action == MEMDEBUG_ACTION_CONTINUE )
+        {
+            signal( id, SIG_DFL );
+            raise( id );
+            return;
+        }
+        
+        if( id == SIGSEGV )
+        {
+            /* Segmentation fault */
+            fprintf
+            (
+                memdebug_output,
+                MEMDEBUG_HR
+                "# MEMDebug: SIGSEGV\n"
+                MEMDEBUG_REV
+                MEMDEBUG_HR
+                "# \n"
+                "# A segmentation fault was detected.\n"
+            );
+        }
+        else
+        {
+            /* Bus error */
+            fprintf
+            (
+                memdebug_output,
+                MEMDEBUG_HR
+                "# MEMDebug: SIGBUS\n"
+                MEMDEBUG_REV
+                MEMDEBUG_HR
+                "# \n"
+                "# A bus error was detected.\n"
+                "Choice: "
+            );
+        }
+        
+        /* Asks for a debug command */
+        if( action == MEMDEBUG_ACTION_ASK )
+        {
+            memdebug_ask_debug_cmd();
+        }
+        
+        /* Checks the signal ID */
+        if( id == SIGSEGV )
+        {
+            /* Segmentation fault */
+            fprintf
+            (
+                memdebug_output,
+                "\n"
+                "SIGSEGV - Segmentation fault\n"
+                "Program execution stopped\n"
+            );
+        }
+        else
+        {
+            /* Bus error */
+            fprintf
+            (
+                memdebug_output,
+                "\n"
+                "SIGBUS - Bus error\n"
+                "Program execution stopped\n"
+            );
+        }
+        
+        fflush( memdebug_output );
+        
+        /* Checks if a core dump is requested */
+        if( action == MEMDEBUG_ACTION_CORE )
+        {
+            signal( id, SIG_DFL );
+            raise( id );
+        }
+        
+        /* Aborts the program execution */
+        exit( EXIT_FAILURE );
+    }
+}
+
+/**
+ * Issues a warning
+ * 
+ * The action taken depends on the error class (see the MEMDEBUG_OPTIONS
+ * environment variable). By default, a debug command is asked.
+ * 
+ * @param   int             The error class (MEMDEBUG_ERROR_XXX)
+ * @param   const char *    The warning message
+ * @param   const char *    The file concerned by the warning
+ * @param   const int       The line number concerned by the warning
+ * @param   const char *    The function concerned by the warning
+ * @param   ...             The parameters for the warning message, if any
+ * @return  void
+ */
+static void memdebug_warning( int error, const char * str, const char * file, const int line, const char * func, ... )
+{
+    va_list ap;
+    int     action;
+    unsigned long long start;
+    
+    action = memdebug_config.actions[ error ];
+    
+    /* Nothing to report */
+    if( action == MEMDEBUG_ACTION_CONTINUE )
+    {
+        return;
+    }
+    
+    /* The listener must not write in the middle of the warning */
+    MEMDEBUG_LOCK;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    /* Gets the variable arguments */
+    va_start( ap, func );
+    
+    /* Issues the warning message */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug: WARNING\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# "
+    );
+    vfprintf( memdebug_output, str, ap );
+    fprintf
+    (
+        memdebug_output,
+        "\n"
+        "# \n"
+        "# Function:    %s()\n"
+        "# File:        %s\n"
+        "# Line:        %i\n",
+        func,
+        file,
+        line
+    );
+    
+    /* Cleanup */
+    va_end( ap );
+    
+    /* The time waiting for a debug command is not measured */
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_REPORTS, start );
+    
+    /* Checks the action to take */
+    switch( action )
+    {
+        /* Asks for a debug command */
+        case MEMDEBUG_ACTION_ASK:
+            
+            memdebug_ask_debug_cmd();
+            break;
+        
+        /* Aborts the program execution */
+        case MEMDEBUG_ACTION_ABORT:
+            
+            fprintf
+            (
+                memdebug_output,
+                "# \n"
+                MEMDEBUG_HR
+                "\n"
+                "Program execution stopped\n"
+            );
+            exit( EXIT_FAILURE );
+        
+        /* Aborts the program execution, with a core dump */
+        case MEMDEBUG_ACTION_CORE:
+            
+            fprintf
+            (
+                memdebug_output,
+                "# \n"
+                MEMDEBUG_HR
+            );
+            fflush( memdebug_output );
+            abort();
+        
+        /* Logs the warning only */
+        default:
+            
+            fprintf
+            (
+                memdebug_output,
+                "# \n"
+                MEMDEBUG_HR
+            );
+            fflush( memdebug_output );
+            break;
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Prints informations about an allocated object
+ * 
+ * @param   struct memdebug_object *    The allocated object
+ * @return  void
+ */
+static void memdebug_print_object( struct memdebug_object * object )
+{
+    /* Pointer address and size */
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        "# - Address:                 %p\n"
+        "# - Size:                    %lu\n",
+        object->ptr,
+        ( unsigned long int )object->size
+    );
+    
+    /* Allocation type */
+    fprintf( memdebug_output, "# - Allocation type:         %s\n", memdebug_alloc_type_name( object->alloc_type ) );
+    
+    /* Reallocation chain */
+    if( object->realloc_count > 0 )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# - Reallocations:           %lu (%lu bytes copied)\n"
+            "# - Sizes:                   ",
+            object->realloc_count,
+            ( unsigned long int )object->realloc_copied
+        );
+        
+        /* The history of the sizes is not archived */
+        if( object->realloc_sizes != NULL )
+        {
+            memdebug_print_realloc_sizes( object );
+        }
+        else
+        {
+            fprintf( memdebug_output, "-\n" );
+        }
+    }
+    
+    /* Allocation nformations */
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        "# - Allocated in function:   %s()"
+        #ifdef __GNUC__
+        " - %p"
+        #endif
+        "\n"
+        "# - Allocated in file:       %s\n"
+        "# - Allocated at line:       %i\n"
+        "# \n",
+        object->alloc_func,
+        #ifdef __GNUC__
+        object->alloc_func_addr,
+        #endif
+        object->alloc_file,
+        object->alloc_line
+    );
+    
+    /* Checks if the object was freed */
+    if( object->free == MEMDEBUG_TRUE )
+    {
+        /* Checks if the object is automatically freed */
+        if( object->alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA || object->alloc_type & MEMDEBUG_ALLOC_TYPE_OBJC_GC )
+        {
+            /* Free informations not available */
+            fprintf
+            (
+                memdebug_output,
+                "# - Freed:                   auto\n"
+                "# \n"
+            );
+        }
+        else
+        {
+            /* Free informations */
+            fprintf
+            (
+                memdebug_output,
+                "# - Freed:                   yes\n"
+                "# - Freed in function:       %s()"
+                #ifdef __GNUC__
+                " - %p"
+                #endif
+                "\n"
+                "# - Freed in file:           %s\n"
+                "# - Freed at line:           %i\n"
+                "# \n",
+                object->free_func,
+                #ifdef __GNUC__
+                object->free_func_addr,
+                #endif
+                object->free_file,
+                object->free_line
+            );
+        }
+    }
+    else
+    {
+        /* No free information */
+        fprintf
+        (
+            memdebug_output,
+            "# - Freed:                   no\n"
+            "# \n"
+            "# - Memory dump:\n"
+            "# \n"
+        );
+        
+        /* Dumps the actual data */
+        memdebug_dump( object );
+        fprintf( memdebug_output, "# \n" );
+    }
+    
+    /* Prints a separator */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+    );
+}
+
+/**
+ * Gets the displayable name of an allocation type
+ * 
+ * @param   memdebug_alloc_type     The allocation type (MEMDEBUG_ALLOC_TYPE_XXX)
+ * @return  const char *            The name of the allocation type
+ */
+static const char * memdebug_alloc_type_name( memdebug_alloc_type alloc_type )
+{
+    /* Checks the allocation type */
+    switch( alloc_type )
+    {
+        case MEMDEBUG_ALLOC_TYPE_MALLOC:                return "malloc";
+        case MEMDEBUG_ALLOC_TYPE_VALLOC:                return "valloc";
+        case MEMDEBUG_ALLOC_TYPE_CALLOC:                return "calloc";
+        case MEMDEBUG_ALLOC_TYPE_REALLOC:               return "realloc";
+        case MEMDEBUG_ALLOC_TYPE_ALLOCA_FUNC:           return "alloca";
+        case MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN:        return "alloca (built-in)";
+        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC:        return "malloc (GC)";
+        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC: return "atomic malloc (GC)";
+        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC:        return "calloc (GC)";
+        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC:       return "realloc (GC)";
+        case MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC:           return "zone malloc";
+        case MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC:           return "zone calloc";
+        case MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC:           return "zone valloc";
+        case MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC:          return "zone realloc";
+        case MEMDEBUG_ALLOC_TYPE_ARENA_ALLOC:           return "arena";
+        case MEMDEBUG_ALLOC_TYPE_MMAP:                  return "mmap";
+        case MEMDEBUG_ALLOC_TYPE_MREMAP:                return "mremap";
+        default:                                        return "<unknown>";
+    }
+}
+
+/**
+ * Gets the state of a memory record object ("active", "free" or "auto")
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  const char *                The state of the memory record object
+ */
+static const char * memdebug_object_state( struct memdebug_object * object )
+{
+    if( object->free == MEMDEBUG_FALSE )
+    {
+        return "active";
+    }
+    
+    /* Checks if the object is automatically freed */
+    if( object->alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA || object->alloc_type & MEMDEBUG_ALLOC_TYPE_OBJC_GC )
+    {
+        return "auto";
+    }
+    
+    return "free";
+}
+
+/**
+ * Prints the non-empty size classes of each allocation type
+ * 
+ * @return  void
+ */
+static void memdebug_print_histograms( void )
+{
+    unsigned int type;
+    unsigned int size_class;
+    
+    for( type = 0; type < MEMDEBUG_ALLOC_TYPES; type++ )
+    {
+        for( size_class = 0; size_class < MEMDEBUG_SIZE_CLASSES; size_class++ )
+        {
+            /* Partially unmapped mappings may be active in a class with no allocation */
+            if( memdebug_histograms.total[ type ][ size_class ] == 0 && memdebug_histograms.live[ type ][ size_class ] == 0 )
+            {
+                continue;
+            }
+            
+            fprintf
+            (
+                memdebug_output,
+                "# - %-20s %10lu - %-10lu bytes:  %lu active, %lu total\n",
+                memdebug_alloc_type_name( 1UL << type ),
+                ( size_class == 0 ) ? 0UL : 1UL << size_class,
+                ( size_class == MEMDEBUG_SIZE_CLASSES - 1 ) ? ( unsigned long int )-1 : ( 1UL << ( size_class + 1 ) ) - 1,
+                memdebug_histograms.live[ type ][ size_class ],
+                memdebug_histograms.total[ type ][ size_class ]
+            );
+        }
+    }
+}
+
+/**
+ * Prints the status of the memory allocations
+ * 
+ * @return  void
+ */
+void memdebug_print_status( void )
+{
+    char num_peak_time[ 32 ];
+    char memory_peak_time[ 32 ];
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    memdebug_sampling_flush();
+    
+    /* Prints the allocation status */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Status\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+    );
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        "# - Total allocated objects:               %lu\n"
+        "# - Number of non-freed objects:           %lu\n"
+        "# - Number of freed objects:               %lu\n"
+        "# - Number of automatically-freed objects: %lu\n"
+        "# - Number of non-sampled allocations:     %lu\n"
+        "# - Number of allocations over the budget: %lu\n",
+        memdebug_trace->num_objects + memdebug_archive.count + memdebug_archive.dropped,
+        memdebug_trace->num_active,
+        memdebug_trace->num_free,
+        memdebug_trace->num_auto,
+        memdebug_trace->num_untracked,
+        memdebug_trace->num_over_limit
+    );
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        "# - Total memory:                          %lu\n"
+        "# - Active memory:                         %lu\n"
+        "# - Active heap memory:                    %lu\n"
+        "# - Active mapped memory:                  %lu in %lu mappings (total: %lu, peak: %lu)\n"
+        "# - Quarantined memory:                    %lu\n"
+        "# \n"
+        "# - Metadata memory:                       %lu bytes in %lu blocks (%lu bytes requested)\n"
+        "# - Metadata mappings:                     %lu bytes in %lu mappings (peak: %lu bytes)\n"
+        "# - Archived freed objects:                %lu in %lu bytes (%lu call sites, %lu dropped)\n"
+        "# \n",
+        ( unsigned long int )memdebug_trace->memory_total,
+        ( unsigned long int )memdebug_trace->memory_active,
+        ( unsigned long int )( memdebug_trace->memory_active - memdebug_mappings.memory_active ),
+        ( unsigned long int )memdebug_mappings.memory_active,
+        memdebug_mappings.count,
+        ( unsigned long int )memdebug_mappings.memory_total,
+        ( unsigned long int )memdebug_mappings.memory_peak,
+        ( unsigned long int )memdebug_quarantine.size,
+        ( unsigned long int )memdebug_meta.used,
+        memdebug_meta.blocks,
+        ( unsigned long int )memdebug_meta.requested,
+        ( unsigned long int )memdebug_meta.mapped,
+        memdebug_meta.mappings,
+        ( unsigned long int )memdebug_meta.mapped_peak,
+        memdebug_archive.count,
+        ( unsigned long int )memdebug_archive.size,
+        memdebug_archive.num_sites,
+        memdebug_archive.dropped
+    );
+    
+    /* Allocations made by the files compiled with a lower feature level (see MEMDEBUG_LEVEL) */
+    if( memdebug_counters.allocs != 0 || memdebug_counters.reallocs != 0 )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# - Allocations without records:           %lu (%lu reallocations, %lu frees, %lu bytes)\n"
+            "# \n",
+            memdebug_counters.allocs,
+            memdebug_counters.reallocs,
+            memdebug_counters.frees,
+            memdebug_counters.bytes
+        );
+    }
+    
+    if( memdebug_capturer.writer != NULL )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# - Captured operations:                   %lu (%lu threads)\n"
+            "# \n",
+            memdebug_capturer.count,
+            memdebug_capturer.num_threads
+        );
+    }
+    
+    memdebug_format_time( &memdebug_trace->num_peak_time, num_peak_time, sizeof( num_peak_time ) );
+    memdebug_format_time( &memdebug_trace->memory_peak_time, memory_peak_time, sizeof( memory_peak_time ) );
+    
+    fprintf
+    (
+        memdebug_output,
+        "# - Peak number of non-freed objects:      %lu (%s)\n"
+        "# - Peak active memory:                    %lu (%s)\n"
+        "# \n",
+        memdebug_trace->num_peak,
+        num_peak_time,
+        ( unsigned long int )memdebug_trace->memory_peak,
+        memory_peak_time
+    );
+    
+    memdebug_print_histograms();
+    memdebug_print_self_stats();
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Gets the size-class histograms of the allocations
+ * 
+ * The size class N of the histograms holds the sizes from 2^N to
+ * 2^(N+1) - 1 (the class 0 also holds the empty allocations).
+ * 
+ * @param   unsigned long int   The allocation types to include (a combination of MEMDEBUG_ALLOC_TYPE_XXX)
+ * @param   unsigned long int * An array of MEMDEBUG_SIZE_CLASSES counters for the active allocations, or NULL
+ * @param   unsigned long int * An array of MEMDEBUG_SIZE_CLASSES counters for all the allocations, or NULL
+ * @return  void
+ */
+void memdebug_histogram( unsigned long int alloc_types, unsigned long int * live, unsigned long int * total )
+{
+    unsigned int type;
+    unsigned int size_class;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    for( size_class = 0; size_class < MEMDEBUG_SIZE_CLASSES; size_class++ )
+    {
+        if( live != NULL )
+        {
+            live[ size_class ] = 0;
+        }
+        
+        if( total != NULL )
+        {
+            total[ size_class ] = 0;
+        }
+        
+        for( type = 0; type < MEMDEBUG_ALLOC_TYPES; type++ )
+        {
+            if( !( alloc_types & ( 1UL << type ) ) )
+            {
+                continue;
+            }
+            
+            if( live != NULL )
+            {
+                live[ size_class ] += memdebug_histograms.live[ type ][ size_class ];
+            }
+            
+            if( total != NULL )
+            {
+                total[ size_class ] += memdebug_histograms.total[ type ][ size_class ];
+            }
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Prints informations about the allocated objects (active and free)
+ * 
+ * @return  void
+ */
+void memdebug_print_objects( void )
+{
+    unsigned long int i;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* The report may be written by a child process */
+    if( memdebug_report_fork() == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    /* Header */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Allocated objects\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+    );
+    
+    /* Checks if objects were allocated */
+    if( memdebug_trace->num_objects + memdebug_archive.count + memdebug_archive.dropped == 0 )
+    {
+        /* No allocated objects */
+        fprintf
+        (
+            memdebug_output,
+            "# No objects were allocated\n"
+            MEMDEBUG_HR
+        );
+    }
+    else
+    {
+        /* The archived objects come first */
+        memdebug_print_archive();
+        
+        /* Process each allocated object */
+        for( i = 0; i < memdebug_trace->num_objects; i++ )
+        {
+            /* Prints information about the current object */
+            fprintf
+            (
+                memdebug_output,
+                "# \n"
+                "# - Memory record:           #%lu\n",
+                memdebug_archive.dropped + memdebug_archive.count + i + 1
+            );
+            memdebug_print_object( &memdebug_trace->objects[ i ] );
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    memdebug_report_end();
+}
+
+/**
+ * Prints informations about the freed objects
+ * 
+ * @return  void
+ */
+void memdebug_print_free( void )
+{
+    unsigned long int i;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* The report may be written by a child process */
+    if( memdebug_report_fork() == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    /* Header */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Freed objects\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+    );
+    
+    /* Checks if objects were freed */
+    if( memdebug_trace->num_free == 0 )
+    {
+        /* No freed object */
+        fprintf
+        (
+            memdebug_output,
+            "# No objects were freed\n"
+            MEMDEBUG_HR
+        );
+    }
+    else
+    {
+        /* The archived objects come first */
+        memdebug_print_archive();
+        
+        /* Process each allocated object */
+        for( i = 0; i < memdebug_trace->num_objects; i++ )
+        {
+            /* Checks if the current object was freed */
+            if( memdebug_trace->objects[ i ].free == MEMDEBUG_TRUE )
+            {
+                /* Prints information about the current object */
+                fprintf
+                (
+                    memdebug_output,
+                    "# \n"
+                    "# - Memory record:           #%lu\n",
+                    memdebug_archive.dropped + memdebug_archive.count + i + 1
+                );
+                memdebug_print_object( &memdebug_trace->objects[ i ] );
+            }
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    memdebug_report_end();
+}
+
+/**
+ * Prints informations about the active objects
+ * 
+ * @return  void
+ */
+void memdebug_print_active( void )
+{
+    unsigned long int i;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* The report may be written by a child process */
+    if( memdebug_report_fork() == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    /* Header */
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Active objects\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+    );
+    
+    /* Checks if objects are active */
+    if( memdebug_trace->num_active == 0 )
+    {
+        /* No active object */
+        fprintf
+        (
+            memdebug_output,
+            "# No objects are currently active\n"
+            MEMDEBUG_HR
+        );
+    }
+    else
+    {
+        /* Process each allocated object */
+        for( i = 0; i < memdebug_trace->num_objects; i++ )
+        { 
+            /* Checks if the current object is active */
+            if( memdebug_trace->objects[ i ].free == MEMDEBUG_FALSE )
+            {
+                /* Prints information about the current object */
+                fprintf
+                (
+                    memdebug_output,
+                    "# \n"
+                    "# - Memory record:           #%lu\n",
+                    memdebug_archive.dropped + memdebug_archive.count + i + 1
+                );
+                memdebug_print_object( &memdebug_trace->objects[ i ] );
+            }
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    memdebug_report_end();
+}
+
+/**
+ * Writes a memory record object to the buffer of an output writer
+ * 
+ * @param   struct memdebug_writer *    The writer
+ * @param   struct memdebug_object *    The memory record object
+ * @param   unsigned long int           The number of the memory record
+ * @param   int                         The export format (MEMDEBUG_EXPORT_JSON or MEMDEBUG_EXPORT_CSV)
+ * @return  void
+ */
+static void memdebug_export_object( struct memdebug_writer * writer, struct memdebug_object * object, unsigned long int record, int format )
+{
+    memdebug_bool freed;
+    const char  * type;
+    const char  * state;
+    
+    type  = memdebug_alloc_type_name( object->alloc_type );
+    state = memdebug_object_state( object );
+    freed = ( object->free == MEMDEBUG_TRUE && state[ 0 ] == 'f' ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+    
+    if( format == MEMDEBUG_EXPORT_CSV )
+    {
+        memdebug_writer_append_ulong( writer, record );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_pointer( writer, object->ptr );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_ulong( writer, ( unsigned long int )object->size );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_csv_string( writer, type );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_csv_string( writer, state );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_csv_string( writer, object->alloc_func );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_csv_string( writer, object->alloc_file );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        memdebug_writer_append_ulong( writer, ( unsigned long int )object->alloc_line );
+        MEMDEBUG_WRITER_LITERAL( writer, "," );
+        
+        if( freed == MEMDEBUG_TRUE )
+        {
+            memdebug_writer_append_csv_string( writer, object->free_func );
+            MEMDEBUG_WRITER_LITERAL( writer, "," );
+            memdebug_writer_append_csv_string( writer, object->free_file );
+            MEMDEBUG_WRITER_LITERAL( writer, "," );
+            memdebug_writer_append_ulong( writer, ( unsigned long int )object->free_line );
+        }
+        else
+        {
+            MEMDEBUG_WRITER_LITERAL( writer, ",," );
+        }
+        
+        MEMDEBUG_WRITER_LITERAL( writer, "\n" );
+        
+        return;
+    }
+    
+    MEMDEBUG_WRITER_LITERAL( writer, "{\"record\":" );
+    memdebug_writer_append_ulong( writer, record );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"address\":\"" );
+    memdebug_writer_append_pointer( writer, object->ptr );
+    MEMDEBUG_WRITER_LITERAL( writer, "\",\"size\":" );
+    memdebug_writer_append_ulong( writer, ( unsigned long int )object->size );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"type\":" );
+    memdebug_writer_append_json_string( writer, type );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"state\":" );
+    memdebug_writer_append_json_string( writer, state );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"alloc_func\":" );
+    memdebug_writer_append_json_string( writer, object->alloc_func );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"alloc_file\":" );
+    memdebug_writer_append_json_string( writer, object->alloc_file );
+    MEMDEBUG_WRITER_LITERAL( writer, ",\"alloc_line\":" );
+    memdebug_writer_append_ulong( writer, ( unsigned long int )object->alloc_line );
+    
+    if( freed == MEMDEBUG_TRUE )
+    {
+        MEMDEBUG_WRITER_LITERAL( writer, ",\"free_func\":" );
+        memdebug_writer_append_json_string( writer, object->free_func );
+        MEMDEBUG_WRITER_LITERAL( writer, ",\"free_file\":" );
+        memdebug_writer_append_json_string( writer, object->free_file );
+        MEMDEBUG_WRITER_LITERAL( writer, ",\"free_line\":" );
+        memdebug_writer_append_ulong( writer, ( unsigned long int )object->free_line );
+    }
+    else
+    {
+        MEMDEBUG_WRITER_LITERAL( writer, ",\"free_func\":null,\"free_file\":null,\"free_line\":null" );
+    }
+    
+    MEMDEBUG_WRITER_LITERAL( writer, "}\n" );
+}
+
+/**
+ * Exports the memory records to a file descriptor, as JSON Lines or CSV
+ * 
+ * JSON Lines output contains one object per memory record. CSV output
+ * starts with a header line naming the columns.
+ * 
+ * @param   int                 The file descriptor to write to
+ * @param   int                 The export format (MEMDEBUG_EXPORT_JSON or MEMDEBUG_EXPORT_CSV)
+ * @param   int                 The records to export (MEMDEBUG_EXPORT_ALL, MEMDEBUG_EXPORT_ACTIVE or MEMDEBUG_EXPORT_FREE)
+ * @return  unsigned long int   The number of exported memory records
+ */
+unsigned long int memdebug_export( int fd, int format, int filter )
+{
+    unsigned long int i;
+    unsigned long int count;
+    struct memdebug_object * object;
+    struct memdebug_object archived;
+    struct memdebug_archive_cursor cursor;
+    unsigned long long start;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    MEMDEBUG_SELF_START( start );
+    
+    memdebug_arena_retire_all();
+    
+    memdebug_writer_init( &memdebug_export_writer, fd );
+    
+    if( format == MEMDEBUG_EXPORT_CSV )
+    {
+        MEMDEBUG_WRITER_LITERAL
+        (
+            &memdebug_export_writer,
+            "record,address,size,type,state,alloc_func,alloc_file,alloc_line,free_func,free_file,free_line\n"
+        );
+    }
+    
+    count = 0;
+    
+    /* The archived objects come first */
+    if( filter != MEMDEBUG_EXPORT_ACTIVE )
+    {
+        memdebug_archive_rewind( &cursor );
+        
+        while( memdebug_archive_next( &cursor, &archived ) == MEMDEBUG_TRUE )
+        {
+            memdebug_export_object( &memdebug_export_writer, &archived, memdebug_archive.dropped + ++count, format );
+        }
+    }
+    
+    /* Process each allocated object */
+    for( i = 0; i < memdebug_trace->num_objects; i++ )
+    {
+        object = &memdebug_trace->objects[ i ];
+        
+        /* Checks if the object matches the filter */
+        if
+        (
+               ( filter == MEMDEBUG_EXPORT_ACTIVE && object->free == MEMDEBUG_TRUE )
+            || ( filter == MEMDEBUG_EXPORT_FREE   && object->free == MEMDEBUG_FALSE )
+        )
+        {
+            continue;
+        }
+        
+        memdebug_export_object( &memdebug_export_writer, object, memdebug_archive.dropped + memdebug_archive.count + i + 1, format );
+        count++;
+    }
+    
+    memdebug_writer_flush( &memdebug_export_writer );
+    
+    MEMDEBUG_SELF_END( MEMDEBUG_SELF_REPORTS, start );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return count;
+}
+
+/**
+ * Gets the number of allocated objects (active and freed)
+ * 
+ * @return  unsigned long int   The number of allocated objects
+ */
+unsigned long int memdebug_num_objects( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Returns the number of allocated objects, archived and dropped ones included */
+    return memdebug_trace->num_objects + memdebug_archive.count + memdebug_archive.dropped;
+}
+
+/**
+ * Gets the number of freed objects
+ * 
+ * @return  unsigned long int   The number of freed objects
+ */
+unsigned long int memdebug_num_free( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Returns the number of freed objects */
+    return memdebug_trace->num_free;
+}
+
+/**
+ * Gets the number of active objects
+ * 
+ * @return  unsigned long int   The number of active objects
+ */
+unsigned long int memdebug_num_active( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Returns the number of active objects */
+    return memdebug_trace->num_active;
+}
+
+/**
+ * Sets the options of the memory data dumps
+ * 
+ * When the size of a memory record exceeds the sum of the two limits, only
+ * the leading and trailing bytes are displayed. A value of 0 for both limits
+ * displays the whole memory area.
+ * 
+ * @param   size_t  The number of leading bytes to display
+ * @param   size_t  The number of trailing bytes to display
+ * @param   int     Whether repeated identical lines are collapsed
+ * @return  void
+ */
+void memdebug_set_dump_options( size_t head, size_t tail, int collapse )
+{
+    memdebug_dump_head     = head;
+    memdebug_dump_tail     = tail;
+    memdebug_dump_collapse = ( collapse ) ? MEMDEBUG_TRUE : MEMDEBUG_FALSE;
+}
+
+/**
+ * Takes a snapshot of the memory allocations
+ * 
+ * A snapshot is only the current sequence number of the allocations, so
+ * taking one has no cost. Use memdebug_snapshot_diff() to report the
+ * allocations made between two snapshots.
+ * 
+ * @return  unsigned long int   The snapshot
+ */
+unsigned long int memdebug_snapshot( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    return memdebug_trace->sequence;
+}
+
+/**
+ * Compares two sites by allocated memory (largest first), for qsort()
+ * 
+ * @param   const void *    The first site
+ * @param   const void *    The second site
+ * @return  int             The comparison result
+ */
+static int memdebug_site_stats_compare( const void * a, const void * b )
+{
+    const struct memdebug_site_stats * site1;
+    const struct memdebug_site_stats * site2;
+    
+    site1 = ( const struct memdebug_site_stats * )a;
+    site2 = ( const struct memdebug_site_stats * )b;
+    
+    if( site1->size != site2->size )
+    {
+        return ( site1->size > site2->size ) ? -1 : 1;
+    }
+    
+    if( site1->count != site2->count )
+    {
+        return ( site1->count > site2->count ) ? -1 : 1;
+    }
+    
+    return 0;
+}
+
+/**
+ * Prints the allocations made between two snapshots and not freed before the second one, grouped by allocation site
+ * 
+ * @param   unsigned long int   The first snapshot
+ * @param   unsigned long int   The second snapshot
+ * @return  unsigned long int   The number of non-freed allocations
+ */
+unsigned long int memdebug_snapshot_diff( unsigned long int a, unsigned long int b )
+{
+    unsigned long int low;
+    unsigned long int high;
+    unsigned long int mid;
+    unsigned long int i;
+    unsigned long int count;
+    unsigned long int num_sites;
+    unsigned long int capacity;
+    unsigned long int slot;
+    size_t size;
+    size_t hash;
+    struct memdebug_object * object;
+    struct memdebug_site_stats * sites;
+    struct memdebug_site_stats * site;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    if( a > b )
+    {
+        mid = a;
+        a   = b;
+        b   = mid;
+    }
+    
+    /* The records are ordered by sequence number - Finds the first one of the first snapshot */
+    low  = 0;
+    high = memdebug_trace->num_objects;
+    
+    while( low < high )
+    {
+        mid = low + ( high - low ) / 2;
+        
+        if( memdebug_trace->objects[ mid ].alloc_seq < a )
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    
+    /* Sites are grouped in an open addressing table, with at most one site per record */
+    capacity = 16;
+    
+    while( capacity < ( memdebug_trace->num_objects - low ) * 2 )
+    {
+        capacity *= 2;
+    }
+    
+    if( NULL == ( sites = ( struct memdebug_site_stats * )memdebug_meta_alloc( capacity * sizeof( struct memdebug_site_stats ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    count     = 0;
+    size      = 0;
+    num_sites = 0;
+    
+    for( i = low; i < memdebug_trace->num_objects; i++ )
+    {
+        object = &memdebug_trace->objects[ i ];
+        
+        if( object->alloc_seq >= b )
+        {
+            break;
+        }
+        
+        /* Skips the objects freed before the second snapshot */
+        if( object->free == MEMDEBUG_TRUE && object->free_seq < b )
+        {
+            continue;
+        }
+        
+        hash = ( ( size_t )object->alloc_file ^ ( ( size_t )object->alloc_func << 1 ) ) * ( size_t )0x9E3779B97F4A7C15ULL + ( size_t )object->alloc_line;
+        slot = ( unsigned long int )( hash ^ ( hash >> 29 ) ) & ( capacity - 1 );
+        
+        while( sites[ slot ].count > 0 )
+        {
+            site = &sites[ slot ];
+            
+            if( site->file == object->alloc_file && site->line == object->alloc_line && site->func == object->alloc_func )
+            {
+                break;
+            }
+            
+            slot = ( slot + 1 ) & ( capacity - 1 );
+        }
+        
+        site = &sites[ slot ];
+        
+        if( site->count == 0 )
+        {
+            site->file = object->alloc_file;
+            site->line = object->alloc_line;
+            site->func = object->alloc_func;
+            
+            num_sites++;
+        }
+        
+        site->count++;
+        site->size += object->size;
+        
+        count++;
+        size += object->size;
+    }
+    
+    /* Packs and sorts the sites */
+    for( i = 0, slot = 0; slot < capacity; slot++ )
+    {
+        if( sites[ slot ].count > 0 )
+        {
+            sites[ i++ ] = sites[ slot ];
+        }
+    }
+    
+    qsort( sites, num_sites, sizeof( struct memdebug_site_stats ), memdebug_site_stats_compare );
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Snapshot difference\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Snapshots:                             %lu -> %lu\n"
+        "# - Number of non-freed objects:           %lu\n"
+        "# - Non-freed memory:                      %lu\n"
+        "# \n",
+        a,
+        b,
+        count,
+        ( unsigned long int )size
+    );
+    
+    for( i = 0; i < num_sites; i++ )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# - %lu bytes in %lu objects, allocated in %s() - %s:%i\n",
+            ( unsigned long int )sites[ i ].size,
+            sites[ i ].count,
+            sites[ i ].func,
+            sites[ i ].file,
+            sites[ i ].line
+        );
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    memdebug_meta_free( sites );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return count;
+}
+
+/**
+ * Writes the counters of the allocation sites, in the pprof heap profile format
+ * 
+ * Each allocation site is written as a single frame stack, using the address
+ * of the code which made its first allocation. The memory map of the process
+ * follows, when available, so pprof can symbolize the addresses with the
+ * program binary.
+ * 
+ * @param   int                 The file descriptor
+ * @return  unsigned long int   The number of allocation sites
+ */
+unsigned long int memdebug_write_profile( int fd )
+{
+    unsigned long int i;
+    unsigned long int live_count;
+    unsigned long int total_count;
+    size_t live_size;
+    size_t total_size;
+    ssize_t length;
+    int maps;
+    struct memdebug_site * site;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    live_count  = 0;
+    total_count = 0;
+    live_size   = 0;
+    total_size  = 0;
+    
+    for( i = 0; i < memdebug_sites.count; i++ )
+    {
+        live_count  += memdebug_sites.sites[ i ].live_count;
+        total_count += memdebug_sites.sites[ i ].total_count;
+        live_size   += memdebug_sites.sites[ i ].live_size;
+        total_size  += memdebug_sites.sites[ i ].total_size;
+    }
+    
+    memdebug_writer_init( &memdebug_export_writer, fd );
+    
+    /* heap profile: <in-use objects>: <in-use bytes> [<allocated objects>: <allocated bytes>] @ heapprofile */
+    MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, "heap profile: " );
+    memdebug_writer_append_ulong( &memdebug_export_writer, live_count );
+    MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, ": " );
+    memdebug_writer_append_ulong( &memdebug_export_writer, ( unsigned long int )live_size );
+    MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, " [" );
+    memdebug_writer_append_ulong( &memdebug_export_writer, total_count );
+    MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, ": " );
+    memdebug_writer_append_ulong( &memdebug_export_writer, ( unsigned long int )total_size );
+    MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, "] @ heapprofile\n" );
+    
+    for( i = 0; i < memdebug_sites.count; i++ )
+    {
+        site = &memdebug_sites.sites[ i ];
+        
+        memdebug_writer_append_ulong( &memdebug_export_writer, site->live_count );
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, ": " );
+        memdebug_writer_append_ulong( &memdebug_export_writer, ( unsigned long int )site->live_size );
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, " [" );
+        memdebug_writer_append_ulong( &memdebug_export_writer, site->total_count );
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, ": " );
+        memdebug_writer_append_ulong( &memdebug_export_writer, ( unsigned long int )site->total_size );
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, "] @ " );
+        
+        /* Without the address of the calling code, the site number is used */
+        memdebug_writer_append_hex( &memdebug_export_writer, ( site->caller != NULL ) ? ( size_t )site->caller : ( size_t )( i + 1 ) );
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, "\n" );
+    }
+    
+    /* Copies the memory map of the process */
+    if( -1 != ( maps = open( "/proc/self/maps", O_RDONLY ) ) )
+    {
+        MEMDEBUG_WRITER_LITERAL( &memdebug_export_writer, "\nMAPPED_LIBRARIES:\n" );
+        
+        do
+        {
+            length = read( maps, memdebug_writer_reserve( &memdebug_export_writer, 4096 ), 4096 );
+            
+            /* Gives back the unused part of the reserved bytes */
+            memdebug_export_writer.length -= ( length > 0 ) ? ( size_t )( 4096 - length ) : 4096;
+        }
+        while( length > 0 || ( length == -1 && errno == EINTR ) );
+        
+        close( maps );
+    }
+    
+    memdebug_writer_flush( &memdebug_export_writer );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return memdebug_sites.count;
+}
+
+/**
+ * Prints the counters of the allocation sites with the most active memory
+ * 
+ * @param   unsigned long int   The maximum number of allocation sites to print (0 means no limit)
+ * @return  void
+ */
+static void memdebug_print_top_sites( unsigned long int max )
+{
+    unsigned long int i;
+    struct memdebug_site * site;
+    struct memdebug_site_stats * sites;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    if( NULL == ( sites = ( struct memdebug_site_stats * )memdebug_meta_alloc( ( memdebug_sites.count + 1 ) * sizeof( struct memdebug_site_stats ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Sorts the allocation sites by active memory */
+    for( i = 0; i < memdebug_sites.count; i++ )
+    {
+        sites[ i ].site  = i;
+        sites[ i ].count = memdebug_sites.sites[ i ].live_count;
+        sites[ i ].size  = memdebug_sites.sites[ i ].live_size;
+    }
+    
+    qsort( sites, memdebug_sites.count, sizeof( struct memdebug_site_stats ), memdebug_site_stats_compare );
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Allocation sites\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Number of allocation sites:            %lu\n"
+        "# \n",
+        memdebug_sites.count
+    );
+    
+    for( i = 0; i < memdebug_sites.count && ( max == 0 || i < max ); i++ )
+    {
+        site = &memdebug_sites.sites[ sites[ i ].site ];
+        
+        fprintf
+        (
+            memdebug_output,
+            "# - %s() - %s:%i\n"
+            "#     - Active:                            %lu bytes in %lu objects\n"
+            "#     - Total:                             %lu bytes in %lu objects\n"
+            "#     - Peak:                              %lu bytes\n",
+            site->func,
+            site->file,
+            site->line,
+            ( unsigned long int )site->live_size,
+            site->live_count,
+            ( unsigned long int )site->total_size,
+            site->total_count,
+            ( unsigned long int )site->peak_size
+        );
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    memdebug_meta_free( sites );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Prints the counters of the allocation sites, by active memory
+ * 
+ * @return  void
+ */
+void memdebug_print_sites( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    memdebug_print_top_sites( 0 );
+}
+
+/**
+ * Prints the active memory of each allocation site, as saved at the peak of the active memory
+ * 
+ * The snapshots are taken with the peak_snapshot option of the
+ * MEMDEBUG_OPTIONS environment variable.
+ * 
+ * @return  void
+ */
+void memdebug_print_peak( void )
+{
+    unsigned long int i;
+    unsigned long int count;
+    struct memdebug_site_stats * sites;
+    char time[ 32 ];
+    char peak_time[ 32 ];
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    /* The active memory may still be at its last peak */
+    if( memdebug_peak.pending == MEMDEBUG_TRUE && memdebug_trace->memory_active == memdebug_trace->memory_peak )
+    {
+        memdebug_peak.pending = MEMDEBUG_FALSE;
+        
+        memdebug_peak_save();
+    }
+    
+    memdebug_format_time( &memdebug_trace->memory_peak_time, peak_time, sizeof( peak_time ) );
+    memdebug_format_time( &memdebug_peak.time, time, sizeof( time ) );
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Peak snapshot\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Peak active memory:                    %lu (%s)\n"
+        "# - Snapshot active memory:                %lu (%s)\n"
+        "# - Snapshot number of non-freed objects:  %lu\n"
+        "# \n",
+        ( unsigned long int )memdebug_trace->memory_peak,
+        peak_time,
+        ( unsigned long int )memdebug_peak.memory_active,
+        time,
+        memdebug_peak.num_active
+    );
+    
+    if( memdebug_peak.taken == MEMDEBUG_FALSE )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# No peak snapshot was taken (see the peak_snapshot option)\n"
+            "# \n"
+        );
+    }
+    
+    /* The saved sites are sorted only when printed */
+    sites = ( struct memdebug_site_stats * )memdebug_meta_alloc( ( memdebug_sites.count + 1 ) * sizeof( struct memdebug_site_stats ) );
+    count = 0;
+    
+    for( i = 0; i < memdebug_sites.count; i++ )
+    {
+        if( memdebug_sites.sites[ i ].snapshot_count == 0 )
+        {
+            continue;
+        }
+        
+        sites[ count ].file  = memdebug_sites.sites[ i ].file;
+        sites[ count ].line  = memdebug_sites.sites[ i ].line;
+        sites[ count ].func  = memdebug_sites.sites[ i ].func;
+        sites[ count ].count = memdebug_sites.sites[ i ].snapshot_count;
+        sites[ count ].size  = memdebug_sites.sites[ i ].snapshot_size;
+        
+        count++;
+    }
+    
+    qsort( sites, count, sizeof( struct memdebug_site_stats ), memdebug_site_stats_compare );
+    
+    for( i = 0; i < count; i++ )
+    {
+        fprintf
+        (
+            memdebug_output,
+            "# - %lu bytes in %lu objects, allocated in %s() - %s:%i\n",
+            ( unsigned long int )sites[ i ].size,
+            sites[ i ].count,
+            sites[ i ].func,
+            sites[ i ].file,
+            sites[ i ].line
+        );
+    }
+    
+    memdebug_meta_free( sites );
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Gets the number of freed allocations of a site with a measured lifetime
+ * 
+ * The allocations moved to another site by a reallocation, and the ones
+ * released by the garbage collector or at the end of a function (alloca),
+ * have no lifetime, and are not counted.
+ * 
+ * @param   struct memdebug_site *  The allocation site
+ * @return  unsigned long int       The number of freed allocations
+ */
+static unsigned long int memdebug_site_freed( struct memdebug_site * site )
+{
+    unsigned int lifetime_class;
+    unsigned long int freed;
+    
+    for( freed = 0, lifetime_class = 0; lifetime_class < MEMDEBUG_LIFETIME_CLASSES; lifetime_class++ )
+    {
+        freed += site->lifetimes[ lifetime_class ];
+    }
+    
+    return freed;
+}
+
+/**
+ * Gets the median lifetime class of the freed allocations of a site
+ * 
+ * @param   struct memdebug_site *  The allocation site
+ * @return  unsigned int            The lifetime class
+ */
+static unsigned int memdebug_site_median_lifetime( struct memdebug_site * site )
+{
+    unsigned int lifetime_class;
+    unsigned long int count;
+    unsigned long int freed;
+    
+    freed = memdebug_site_freed( site );
+    
+    for( count = 0, lifetime_class = 0; lifetime_class < MEMDEBUG_LIFETIME_CLASSES - 1; lifetime_class++ )
+    {
+        count += site->lifetimes[ lifetime_class ];
+        
+        if( count * 2 >= freed )
+        {
+            break;
+        }
+    }
+    
+    return lifetime_class;
+}
+
+/**
+ * Compares two allocation sites by median lifetime (shortest first), for qsort()
+ * 
+ * The allocation sites are given as memdebug_site_stats structures, holding
+ * the median lifetime class in the size field. Sites with the same median
+ * are kept in order of appearance.
+ * 
+ * @param   const void *    The first site
+ * @param   const void *    The second site
+ * @return  int             The comparison result
+ */
+static int memdebug_site_lifetime_compare( const void * a, const void * b )
+{
+    const struct memdebug_site_stats * site1;
+    const struct memdebug_site_stats * site2;
+    
+    site1 = ( const struct memdebug_site_stats * )a;
+    site2 = ( const struct memdebug_site_stats * )b;
+    
+    if( site1->size != site2->size )
+    {
+        return ( site1->size < site2->size ) ? -1 : 1;
+    }
+    
+    return ( site1->site < site2->site ) ? -1 : ( site1->site > site2->site );
+}
+
+/**
+ * Prints the lifetime histograms of the freed allocations of each site, by median lifetime
+ * 
+ * Sites freeing their allocations within microseconds are candidates for
+ * stack buffers or pooling.
+ * 
+ * @return  void
+ */
+void memdebug_print_lifetimes( void )
+{
+    unsigned long int i;
+    unsigned long int num_sites;
+    unsigned int lifetime_class;
+    double tick_ns;
+    char min[ 32 ];
+    char max[ 32 ];
+    struct memdebug_site * site;
+    struct memdebug_site_stats * sites;
+    
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    tick_ns = memdebug_tick_ns();
+    
+    if( NULL == ( sites = ( struct memdebug_site_stats * )memdebug_meta_alloc( ( memdebug_sites.count + 1 ) * sizeof( struct memdebug_site_stats ) ) ) )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Sorts the sites with freed allocations */
+    for( i = 0, num_sites = 0; i < memdebug_sites.count; i++ )
+    {
+        if( memdebug_site_freed( &memdebug_sites.sites[ i ] ) == 0 )
+        {
+            continue;
+        }
+        
+        sites[ num_sites ].site  = i;
+        sites[ num_sites ].count = memdebug_site_freed( &memdebug_sites.sites[ i ] );
+        sites[ num_sites ].size  = memdebug_site_median_lifetime( &memdebug_sites.sites[ i ] );
+        
+        num_sites++;
+    }
+    
+    qsort( sites, num_sites, sizeof( struct memdebug_site_stats ), memdebug_site_lifetime_compare );
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Allocation lifetimes\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Number of allocation sites with freed objects: %lu\n"
+        "# \n",
+        num_sites
+    );
+    
+    for( i = 0; i < num_sites; i++ )
+    {
+        site = &memdebug_sites.sites[ sites[ i ].site ];
+        
+        memdebug_format_duration( ( sites[ i ].size == 0 ) ? 0 : ( double )( 1ULL << sites[ i ].size ) * tick_ns, min, sizeof( min ) );
+        memdebug_format_duration( ( double )( 1ULL << sites[ i ].size ) * 2 * tick_ns, max, sizeof( max ) );
+        
+        fprintf
+        (
+            memdebug_output,
+            "# - %s() - %s:%i\n"
+            "#     - Freed objects:                     %lu\n"
+            "#     - Median lifetime:                   %s - %s\n",
+            site->func,
+            site->file,
+            site->line,
+            memdebug_site_freed( site ),
+            min,
+            max
+        );
+        
+        for( lifetime_class = 0; lifetime_class < MEMDEBUG_LIFETIME_CLASSES; lifetime_class++ )
+        {
+            if( site->lifetimes[ lifetime_class ] == 0 )
+            {
+                continue;
+            }
+            
+            memdebug_format_duration( ( lifetime_class == 0 ) ? 0 : ( double )( 1ULL << lifetime_class ) * tick_ns, min, sizeof( min ) );
+            memdebug_format_duration( ( double )( 1ULL << lifetime_class ) * 2 * tick_ns, max, sizeof( max ) );
+            
+            fprintf
+            (
+                memdebug_output,
+                "#         %10s - %-10s             %lu\n",
+                min,
+                max,
+                site->lifetimes[ lifetime_class ]
+            );
+        }
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    memdebug_meta_free( sites );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Prints the reallocation churn of each allocation site, by bytes copied
+ * 
+ * Sites growing their memory areas by small increments copy a quadratic
+ * number of bytes, and should reserve the suggested size beforehand.
+ * 
+ * @return  void
+ */
+void memdebug_print_reallocs( void )
+{
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    memdebug_print_realloc_sites( 0 );
+}
+
+/**
+ * Prints the reallocation counters of the allocation sites with the most bytes copied
+ * 
+ * The chains of the active memory areas are counted with the freed ones,
+ * and the longest chain last reallocated at each site is shown as an
+ * example of its growth pattern. The suggested reserve size fits
+ * MEMDEBUG_REALLOC_RESERVE percent of the chains.
+ * 
+ * @param   unsigned long int   The maximum number of allocation sites to print (0 means no limit)
+ * @return  void
+ */
+static void memdebug_print_realloc_sites( unsigned long int max )
+{
+    unsigned long int i;
+    unsigned long int num_sites;
+    unsigned long int num_chains;
+    unsigned long int count;
+    unsigned long int rank;
+    unsigned int size_class;
+    size_t reserve;
+    struct memdebug_site * site;
+    struct memdebug_object * object;
+    struct memdebug_object * example;
+    struct memdebug_site_stats * sites;
+    unsigned long int * ranks;
+    unsigned long int * examples;
+    unsigned long int * chains;
+    
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    if
+    (
+           NULL == ( sites    = ( struct memdebug_site_stats * )memdebug_meta_alloc( ( memdebug_sites.count + 1 ) * sizeof( struct memdebug_site_stats ) ) )
+        || NULL == ( ranks    = ( unsigned long int * )memdebug_meta_alloc( ( memdebug_sites.count + 1 ) * sizeof( unsigned long int ) ) )
+    )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* Sorts the sites with reallocations by bytes copied */
+    for( i = 0, num_sites = 0; i < memdebug_sites.count; i++ )
+    {
+        if( memdebug_sites.sites[ i ].realloc_count == 0 )
+        {
+            continue;
+        }
+        
+        sites[ num_sites ].site  = i;
+        sites[ num_sites ].count = memdebug_sites.sites[ i ].realloc_count;
+        sites[ num_sites ].size  = memdebug_sites.sites[ i ].realloc_copied;
+        
+        num_sites++;
+    }
+    
+    qsort( sites, num_sites, sizeof( struct memdebug_site_stats ), memdebug_site_stats_compare );
+    
+    if
+    (
+           NULL == ( examples = ( unsigned long int * )memdebug_meta_alloc( ( num_sites + 1 ) * sizeof( unsigned long int ) ) )
+        || NULL == ( chains   = ( unsigned long int * )memdebug_meta_alloc( ( num_sites + 1 ) * MEMDEBUG_SIZE_CLASSES * sizeof( unsigned long int ) ) )
+    )
+    {
+        memdebug_fatal
+        (
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
+            strerror( errno )
+        );
+    }
+    
+    /* The final sizes of the freed chains, plus the current sizes of the active ones */
+    for( i = 0; i < num_sites; i++ )
+    {
+        ranks[ sites[ i ].site ] = i + 1;
+        
+        memcpy( &chains[ i * MEMDEBUG_SIZE_CLASSES ], memdebug_sites.sites[ sites[ i ].site ].realloc_sizes, MEMDEBUG_SIZE_CLASSES * sizeof( unsigned long int ) );
+    }
+    
+    for( i = 0; i < memdebug_trace->num_objects; i++ )
+    {
+        object = &memdebug_trace->objects[ i ];
+        
+        if( object->realloc_count == 0 || ranks[ object->site ] == 0 )
+        {
+            continue;
+        }
+        
+        rank = ranks[ object->site ] - 1;
+        
+        if( object->free == MEMDEBUG_FALSE )
+        {
+            chains[ rank * MEMDEBUG_SIZE_CLASSES + memdebug_log2( object->size ) ]++;
+        }
+        
+        if( examples[ rank ] == 0 || object->realloc_count > memdebug_trace->objects[ examples[ rank ] - 1 ].realloc_count )
+        {
+            examples[ rank ] = i + 1;
+        }
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Reallocations\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Number of allocation sites with reallocations: %lu\n"
+        "# \n",
+        num_sites
+    );
+    
+    for( i = 0; i < num_sites && ( max == 0 || i < max ); i++ )
+    {
+        site = &memdebug_sites.sites[ sites[ i ].site ];
+        
+        /* Smallest size class fitting MEMDEBUG_REALLOC_RESERVE percent of the chains */
+        for( num_chains = 0, size_class = 0; size_class < MEMDEBUG_SIZE_CLASSES; size_class++ )
+        {
+            num_chains += chains[ i * MEMDEBUG_SIZE_CLASSES + size_class ];
+        }
+        
+        for( count = 0, size_class = 0; size_class < MEMDEBUG_SIZE_CLASSES - 1; size_class++ )
+        {
+            count += chains[ i * MEMDEBUG_SIZE_CLASSES + size_class ];
+            
+            if( count * 100 >= num_chains * MEMDEBUG_REALLOC_RESERVE )
+            {
+                break;
+            }
+        }
+        
+        reserve = ( size_class < MEMDEBUG_SIZE_CLASSES - 1 ) ? ( size_t )1 << ( size_class + 1 ) : site->realloc_max;
+        reserve = ( reserve > site->realloc_max ) ? site->realloc_max : reserve;
+        
+        fprintf
+        (
+            memdebug_output,
+            "# - %s() - %s:%i\n"
+            "#     - Reallocations:                     %lu (%lu moved)\n"
+            "#     - Bytes copied:                      %lu\n"
+            "#     - Chains:                            %lu\n"
+            "#     - Suggested reserve:                 %lu bytes\n",
+            site->func,
+            site->file,
+            site->line,
+            site->realloc_count,
+            site->realloc_moves,
+            ( unsigned long int )site->realloc_copied,
+            num_chains,
+            ( unsigned long int )reserve
         );
+        
+        if( examples[ i ] != 0 )
+        {
+            example = &memdebug_trace->objects[ examples[ i ] - 1 ];
+            
+            fprintf
+            (
+                memdebug_output,
+                "#     - Longest chain:                     %lu reallocations, %s growth\n"
+                "#         ",
+                example->realloc_count,
+                memdebug_realloc_growth( example )
+            );
+            memdebug_print_realloc_sizes( example );
+        }
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    memdebug_meta_free( chains );
+    memdebug_meta_free( examples );
+    memdebug_meta_free( ranks );
+    memdebug_meta_free( sites );
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Prints the history of the sizes of a reallocated memory area, followed by a new line
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  void
+ */
+static void memdebug_print_realloc_sizes( struct memdebug_object * object )
+{
+    unsigned long int i;
+    unsigned long int num_sizes;
+    
+    num_sizes = ( object->realloc_count < MEMDEBUG_REALLOC_HISTORY ) ? object->realloc_count + 1 : MEMDEBUG_REALLOC_HISTORY;
+    
+    for( i = 0; i < num_sizes; i++ )
+    {
+        fprintf( memdebug_output, ( i == 0 ) ? "%lu" : " -> %lu", ( unsigned long int )object->realloc_sizes[ i ] );
+    }
+    
+    fprintf( memdebug_output, ( object->realloc_count + 1 > num_sizes ) ? " -> ...\n" : "\n" );
+}
+
+/**
+ * Gets the growth pattern of a reallocated memory area, from the history of its sizes
+ * 
+ * Growing by less than a quarter of the size at each reallocation copies
+ * a quadratic number of bytes.
+ * 
+ * @param   struct memdebug_object *    The memory record object
+ * @return  const char *                The name of the growth pattern
+ */
+static const char * memdebug_realloc_growth( struct memdebug_object * object )
+{
+    unsigned long int i;
+    unsigned long int num_sizes;
+    unsigned long int num_steps;
+    unsigned long int num_small;
+    
+    num_sizes = ( object->realloc_count < MEMDEBUG_REALLOC_HISTORY ) ? object->realloc_count + 1 : MEMDEBUG_REALLOC_HISTORY;
+    
+    for( i = 1, num_steps = 0, num_small = 0; i < num_sizes; i++ )
+    {
+        if( object->realloc_sizes[ i ] <= object->realloc_sizes[ i - 1 ] )
+        {
+            continue;
+        }
+        
+        num_steps++;
+        
+        if( object->realloc_sizes[ i ] - object->realloc_sizes[ i - 1 ] < object->realloc_sizes[ i - 1 ] / 4 )
+        {
+            num_small++;
+        }
+    }
+    
+    if( num_steps == 0 )
+    {
+        return "no";
+    }
+    
+    return ( num_small * 2 > num_steps ) ? "linear (quadratic copying)" : "geometric";
+}
+
+/**
+ * Checks the leaks when the program exits (leak_check option)
+ * 
+ * @return  void
+ */
+static void memdebug_leak_atexit( void )
+{
+    memdebug_check_leaks();
+}
+
+/**
+ * Compares two active memory areas by address, for qsort()
+ * 
+ * @param   const void *    The first memory area
+ * @param   const void *    The second memory area
+ * @return  int             The comparison result
+ */
+static int memdebug_leak_block_compare( const void * a, const void * b )
+{
+    const struct memdebug_leak_block * block1;
+    const struct memdebug_leak_block * block2;
+    
+    block1 = ( const struct memdebug_leak_block * )a;
+    block2 = ( const struct memdebug_leak_block * )b;
+    
+    return ( block1->start < block2->start ) ? -1 : ( block1->start > block2->start );
+}
+
+/**
+ * Finds the active memory area a value points to, in the interval index
+ * 
+ * Pointers to the inside of a memory area are accepted, as well as the
+ * pointers to the end of it.
+ * 
+ * @param   const char *        The value
+ * @return  unsigned long int   The position of the memory area in the blocks array, or the number of memory areas if not found
+ */
+static unsigned long int memdebug_leak_find( const char * value )
+{
+    unsigned long int low;
+    unsigned long int high;
+    unsigned long int mid;
+    
+    /* Quick rejection of the values outside of the heap */
+    if( memdebug_leaks.count == 0 || value < memdebug_leaks.blocks[ 0 ].start || value > memdebug_leaks.blocks[ memdebug_leaks.count - 1 ].end )
+    {
+        return memdebug_leaks.count;
     }
     
-    /* Checks if the memory area was already freed */
-    if( object->free == MEMDEBUG_TRUE )
+    /* Finds the last memory area starting at or before the value */
+    low  = 0;
+    high = memdebug_leaks.count;
+    
+    while( low < high )
     {
-        memdebug_warning
-        (
-            "Trying to reallocate a freed object (pointer address: %p)",
-            file,
-            line,
-            func,
-            ptr
-        );
+        mid = low + ( high - low ) / 2;
+        
+        if( memdebug_leaks.blocks[ mid ].start <= value )
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
     }
     
-    if( memdebug_check_fence( object ) == MEMDEBUG_FALSE )
+    if( low == 0 || value > memdebug_leaks.blocks[ low - 1 ].end )
     {
-        memdebug_warning
-        (
-            "A buffer overflow was detected (pointer address: %p)",
-            file,
-            line,
-            func,
-            ptr
-        );
+        return memdebug_leaks.count;
     }
     
-    /* Updates the memory record informations */
-    object->ptr        = ptr_new;
-    object->alloc_file = file;
-    object->alloc_line = line;
-    object->alloc_func = func;
-    object->alloc_type = alloc_type;
+    return low - 1;
+}
+
+/**
+ * Pushes a memory area to scan on the stack of a worker, or on the overflow stack
+ * 
+ * @param   struct memdebug_leak_worker *   The worker
+ * @param   unsigned long int               The position of the memory area in the blocks array
+ * @return  void
+ */
+static void memdebug_leak_push( struct memdebug_leak_worker * worker, unsigned long int block )
+{
+    /* Counted before it can be popped by another worker */
+    __sync_fetch_and_add( &memdebug_leaks.pending, 1 );
+    
+    pthread_mutex_lock( &worker->lock );
+    
+    if( worker->depth < MEMDEBUG_LEAK_STACK_SIZE )
+    {
+        worker->stack[ worker->depth++ ] = block;
+        
+        pthread_mutex_unlock( &worker->lock );
+        
+        return;
+    }
+    
+    pthread_mutex_unlock( &worker->lock );
+    
+    /* As each memory area is pushed only once, the overflow stack cannot overflow */
+    pthread_mutex_lock( &memdebug_leaks.overflow_lock );
+    
+    memdebug_leaks.overflow[ memdebug_leaks.overflow_depth++ ] = block;
+    
+    pthread_mutex_unlock( &memdebug_leaks.overflow_lock );
+}
+
+/**
+ * Pops a memory area to scan, from the stack of a worker, from the overflow stack, or from another worker
+ * 
+ * @param   struct memdebug_leak_worker *   The worker
+ * @param   unsigned long int *             The position of the memory area in the blocks array
+ * @return  memdebug_bool                   Whether a memory area was found
+ */
+static memdebug_bool memdebug_leak_pop( struct memdebug_leak_worker * worker, unsigned long int * block )
+{
+    do
+    {
+        pthread_mutex_lock( &worker->lock );
+        
+        if( worker->depth > 0 )
+        {
+            *( block ) = worker->stack[ --worker->depth ];
+            
+            pthread_mutex_unlock( &worker->lock );
+            
+            return MEMDEBUG_TRUE;
+        }
+        
+        pthread_mutex_unlock( &worker->lock );
+        
+        if( memdebug_leaks.overflow_depth > 0 )
+        {
+            pthread_mutex_lock( &memdebug_leaks.overflow_lock );
+            
+            if( memdebug_leaks.overflow_depth > 0 )
+            {
+                *( block ) = memdebug_leaks.overflow[ --memdebug_leaks.overflow_depth ];
+                
+                pthread_mutex_unlock( &memdebug_leaks.overflow_lock );
+                
+                return MEMDEBUG_TRUE;
+            }
+            
+            pthread_mutex_unlock( &memdebug_leaks.overflow_lock );
+        }
+    }
+    while( memdebug_leak_steal( worker ) == MEMDEBUG_TRUE );
+    
+    return MEMDEBUG_FALSE;
+}
+
+/**
+ * Steals half of the stack of another worker, for an idle worker
+ * 
+ * The oldest memory areas are stolen, as they are the most likely to lead
+ * to large parts of the heap.
+ * 
+ * @param   struct memdebug_leak_worker *   The idle worker
+ * @return  memdebug_bool                   Whether memory areas were stolen
+ */
+static memdebug_bool memdebug_leak_steal( struct memdebug_leak_worker * worker )
+{
+    unsigned int i;
+    unsigned long int count;
+    struct memdebug_leak_worker * victim;
+    
+    for( i = 1; i < memdebug_leaks.num_workers; i++ )
+    {
+        victim = &memdebug_leaks.workers[ ( ( unsigned int )( worker - memdebug_leaks.workers ) + i ) % memdebug_leaks.num_workers ];
+        
+        if( victim->depth == 0 )
+        {
+            continue;
+        }
+        
+        pthread_mutex_lock( &victim->lock );
+        
+        /* Two idle workers may steal from each other - Never waits while holding a lock */
+        if( victim->depth == 0 || pthread_mutex_trylock( &worker->lock ) != 0 )
+        {
+            pthread_mutex_unlock( &victim->lock );
+            continue;
+        }
+        
+        count = ( victim->depth + 1 ) / 2;
+        
+        memcpy( worker->stack + worker->depth, victim->stack, count * sizeof( unsigned long int ) );
+        memmove( victim->stack, victim->stack + count, ( victim->depth - count ) * sizeof( unsigned long int ) );
+        
+        worker->depth += count;
+        victim->depth -= count;
+        
+        pthread_mutex_unlock( &worker->lock );
+        pthread_mutex_unlock( &victim->lock );
+        
+        return MEMDEBUG_TRUE;
+    }
+    
+    return MEMDEBUG_FALSE;
+}
+
+/**
+ * Scans a memory range for pointers to the active memory areas
+ * 
+ * Every aligned word is considered as a possible pointer (conservative
+ * scan). The memory areas found are marked in the bitmap of the reachable
+ * memory areas, and the ones which were not already marked are pushed on
+ * the stack of the worker, so their own contents will be scanned.
+ * 
+ * @param   struct memdebug_leak_worker *   The worker
+ * @param   const char *                    The start of the range
+ * @param   const char *                    The end of the range
+ * @return  void
+ */
+static void memdebug_leak_scan( struct memdebug_leak_worker * worker, const char * start, const char * end )
+{
+    const char * value;
+    unsigned long int block;
+    unsigned long int bit;
+    unsigned long int * word;
+    
+    /* Aligns the start of the range on a pointer */
+    start += ( sizeof( void * ) - ( ( size_t )start % sizeof( void * ) ) ) % sizeof( void * );
+    
+    for( ; start + sizeof( void * ) <= end; start += sizeof( void * ) )
+    {
+        memcpy( &value, start, sizeof( void * ) );
+        
+        if( ( block = memdebug_leak_find( value ) ) == memdebug_leaks.count )
+        {
+            continue;
+        }
+        
+        word = &memdebug_leaks.reachable[ block / MEMDEBUG_LEAK_BITS ];
+        bit  = 1UL << ( block % MEMDEBUG_LEAK_BITS );
+        
+        /* The atomic operation decides which worker scans the memory area */
+        if( !( *( word ) & bit ) && !( __sync_fetch_and_or( word, bit ) & bit ) )
+        {
+            memdebug_leak_push( worker, block );
+        }
+    }
+}
+
+/**
+ * Scans memory areas until all the reachable ones are marked
+ * 
+ * @param   struct memdebug_leak_worker *   The worker
+ * @return  void
+ */
+static void memdebug_leak_work( struct memdebug_leak_worker * worker )
+{
+    unsigned long int block;
+    
+    while( memdebug_leaks.pending > 0 )
+    {
+        if( memdebug_leak_pop( worker, &block ) == MEMDEBUG_FALSE )
+        {
+            /* Other workers are still scanning, and may push more memory areas */
+            sched_yield();
+            continue;
+        }
+        
+        memdebug_leak_scan( worker, memdebug_leaks.blocks[ block ].start, memdebug_leaks.blocks[ block ].end );
+        
+        worker->scanned++;
+        
+        __sync_fetch_and_sub( &memdebug_leaks.pending, 1 );
+    }
+}
+
+/**
+ * Main function of the worker threads of the leak scanner
+ * 
+ * @param   void *  The worker
+ * @return  void *  NULL
+ */
+static void * memdebug_leak_worker_main( void * data )
+{
+    struct memdebug_leak_worker * worker;
+    
+    worker = ( struct memdebug_leak_worker * )data;
+    
+    /* Checks if the leak scanner can stop the other threads */
+    #ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+    
+    worker->tid = syscall( SYS_gettid );
+    
+    #endif
+    
+    __sync_fetch_and_add( &memdebug_leaks.ready, 1 );
+    
+    /* Waits for the roots to be scanned */
+    while( memdebug_leaks.phase == MEMDEBUG_LEAK_PHASE_WAIT )
+    {
+        sched_yield();
+    }
+    
+    memdebug_leak_work( worker );
+    
+    return NULL;
+}
+
+/**
+ * Scans a stack, from a stack pointer to the end of its memory mapping
+ * 
+ * @param   const char *    The stack pointer
+ * @return  void
+ */
+static void memdebug_leak_scan_stack( const char * sp )
+{
+    const char * line;
+    unsigned long start;
+    unsigned long end;
+    
+    for( line = memdebug_leaks.maps; line != NULL && *( line ) != 0; line = strchr( line, '\n' ) )
+    {
+        if( *( line ) == '\n' )
+        {
+            line++;
+        }
+        
+        if( sscanf( line, "%lx-%lx", &start, &end ) == 2 && ( unsigned long )sp >= start && ( unsigned long )sp < end )
+        {
+            memdebug_leak_scan( &memdebug_leaks.workers[ 0 ], sp, ( const char * )end );
+            return;
+        }
+    }
+}
+
+/**
+ * Marks the reachable and the indirectly leaked memory areas
+ * 
+ * The worker threads are started first, then the other threads are stopped
+ * while the roots (data segments and stacks) are scanned by the calling
+ * thread, and while the reachable memory areas are scanned by all the
+ * workers. The registers of the stopped threads are saved on their stacks
+ * by the signal handler. The registers of the calling thread are saved on
+ * its stack before the call.
+ * 
+ * @return  void
+ */
+static void memdebug_leak_mark( void )
+{
+    unsigned int i;
+    unsigned long int stopped;
+    unsigned long long start;
+    const char * sp;
+    
+    /* Everything is allocated before the threads are stopped, as they may hold the allocator locks */
+    memdebug_leaks.num_roots = 0;
+    memdebug_leaks.ready     = 0;
+    memdebug_leaks.phase     = MEMDEBUG_LEAK_PHASE_WAIT;
+    stopped                  = 0;
+    
+    /* Checks if the leak scanner can find the data segments */
+    #ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+    
+    dl_iterate_phdr( memdebug_leak_add_segments, NULL );
+    
+    #endif
+    
+    for( i = 1; i < memdebug_leaks.num_workers; i++ )
+    {
+        if( pthread_create( &memdebug_leaks.workers[ i ].thread, NULL, memdebug_leak_worker_main, &memdebug_leaks.workers[ i ] ) != 0 )
+        {
+            break;
+        }
+    }
+    
+    memdebug_leaks.num_workers = i;
+    
+    /* The worker threads must not be stopped */
+    while( memdebug_leaks.ready < ( int )memdebug_leaks.num_workers - 1 )
+    {
+        sched_yield();
+    }
+    
+    /* Checks if the leak scanner can stop the other threads */
+    #ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+    
+    stopped = memdebug_leak_stop_threads();
+    
+    memdebug_leak_read_maps();
+    
+    #endif
+    
+    start = memdebug_ticks();
+    
+    /* Roots */
+    for( i = 0; i < stopped; i++ )
+    {
+        memdebug_leak_scan_stack( ( const char * )memdebug_leaks.stacks[ i ] );
+    }
+    
+    sp = ( const char * )&sp;
+    
+    memdebug_leak_scan_stack( sp );
+    
+    for( i = 0; i < memdebug_leaks.num_roots; i++ )
+    {
+        memdebug_leak_scan( &memdebug_leaks.workers[ 0 ], memdebug_leaks.roots[ i ].start, memdebug_leaks.roots[ i ].end );
+    }
+    
+    /* Reachable memory areas */
+    memdebug_leaks.phase = MEMDEBUG_LEAK_PHASE_MARK;
+    
+    memdebug_leak_work( &memdebug_leaks.workers[ 0 ] );
+    
+    memdebug_leaks.mark_ticks = memdebug_ticks() - start;
+    
+    for( i = 1; i < memdebug_leaks.num_workers; i++ )
+    {
+        pthread_join( memdebug_leaks.workers[ i ].thread, NULL );
+    }
+    
+    /* Leaked memory areas may be freed by the program once it is resumed */
+    memdebug_leak_mark_indirect();
+    
+    /* Checks if the leak scanner can stop the other threads */
+    #ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+    
+    memdebug_leak_resume_threads();
+    
+    #endif
+}
+
+/**
+ * Marks the leaked memory areas referenced by other leaked memory areas (indirect leaks)
+ * 
+ * One level is enough, as every leaked memory area is scanned. A memory
+ * area referencing itself is not an indirect leak.
+ * 
+ * @return  void
+ */
+static void memdebug_leak_mark_indirect( void )
+{
+    unsigned long int i;
+    unsigned long int block;
+    const char * start;
+    const char * value;
+    
+    for( i = 0; i < memdebug_leaks.count; i++ )
+    {
+        if( MEMDEBUG_LEAK_TEST( memdebug_leaks.reachable, i ) )
+        {
+            continue;
+        }
+        
+        start = memdebug_leaks.blocks[ i ].start;
+        start += ( sizeof( void * ) - ( ( size_t )start % sizeof( void * ) ) ) % sizeof( void * );
+        
+        for( ; start + sizeof( void * ) <= memdebug_leaks.blocks[ i ].end; start += sizeof( void * ) )
+        {
+            memcpy( &value, start, sizeof( void * ) );
+            
+            if( ( block = memdebug_leak_find( value ) ) == memdebug_leaks.count || block == i || MEMDEBUG_LEAK_TEST( memdebug_leaks.reachable, block ) )
+            {
+                continue;
+            }
+            
+            memdebug_leaks.indirect[ block / MEMDEBUG_LEAK_BITS ] |= 1UL << ( block % MEMDEBUG_LEAK_BITS );
+        }
+    }
+}
+
+/* Checks if the leak scanner can find the data segments and stop the other threads */
+#ifdef MEMDEBUG_HAVE_LEAK_SCANNER
+
+/**
+ * Adds the writable segments of a loaded object (data and bss) to the roots of the leak scanner
+ * 
+ * @param   struct dl_phdr_info *   The loaded object
+ * @param   size_t                  The size of the loaded object structure
+ * @param   void *                  Unused
+ * @return  int                     0, to continue with the next loaded object
+ */
+static int memdebug_leak_add_segments( struct dl_phdr_info * info, size_t size, void * data )
+{
+    int i;
+    struct memdebug_leak_range * range;
     
-    /* Updates the pool memory size and usage */
-    memdebug_trace->memory_total  -= object->size;
-    memdebug_trace->memory_active -= object->size;
-    memdebug_trace->memory_total  += size;
-    memdebug_trace->memory_active += size;
+    ( void )size;
+    ( void )data;
     
-    /* Updates the size of the memory record */
-    object->size = size;
+    for( i = 0; i < info->dlpi_phnum; i++ )
+    {
+        if( info->dlpi_phdr[ i ].p_type != PT_LOAD || !( info->dlpi_phdr[ i ].p_flags & PF_W ) )
+        {
+            continue;
+        }
+        
+        if( memdebug_leaks.num_roots == memdebug_leaks.size_roots )
+        {
+            memdebug_leaks.size_roots += MEMDEBUG_POOL_SIZE;
+            
+            if( NULL == ( memdebug_leaks.roots = ( struct memdebug_leak_range * )memdebug_meta_realloc( memdebug_leaks.roots, memdebug_leaks.size_roots * sizeof( struct memdebug_leak_range ) ) ) )
+            {
+                memdebug_fatal
+                (
+                    "MEMDebug error: cannot allocate memory for the leak scanner. Reason: %s\n",
+                    strerror( errno )
+                );
+            }
+        }
+        
+        range        = &memdebug_leaks.roots[ memdebug_leaks.num_roots++ ];
+        range->start = ( const char * )( info->dlpi_addr + info->dlpi_phdr[ i ].p_vaddr );
+        range->end   = range->start + info->dlpi_phdr[ i ].p_memsz;
+    }
     
-    /* Checks if we are using GCC */
-    #ifdef __GNUC__
+    return 0;
+}
+
+/**
+ * Reads the memory map of the process, to find the ends of the stacks
+ * 
+ * Only system calls are used, as the other threads may be stopped.
+ * 
+ * @return  void
+ */
+static void memdebug_leak_read_maps( void )
+{
+    int fd;
+    size_t length;
+    ssize_t result;
     
-    /* Stores the address of the caller function */
-    object->alloc_func_addr = __builtin_return_address( 2 );
+    length = 0;
     
-    #endif
+    if( -1 != ( fd = open( "/proc/self/maps", O_RDONLY ) ) )
+    {
+        while( length < memdebug_leaks.maps_size - 1 )
+        {
+            result = read( fd, memdebug_leaks.maps + length, memdebug_leaks.maps_size - 1 - length );
+            
+            if( result > 0 )
+            {
+                length += ( size_t )result;
+            }
+            else if( result == 0 || errno != EINTR )
+            {
+                break;
+            }
+        }
+        
+        close( fd );
+    }
+    
+    memdebug_leaks.maps[ length ] = 0;
 }
 
 /**
- * Marks an existing memory record object as free
+ * Stops the other threads of the process
  * 
- * @param   void *          The address of the memory area corresponding to the memory record object
- * @param   const char *    The file in which the deallocation was made
- * @param   const int       The line of the file in which the deallocation was made
- * @param   const char *    The name of the function in which the deallocation was made
- * @return  void
+ * Each thread is sent a signal, whose handler saves the stack pointer, and
+ * waits until memdebug_leak_resume_threads() is called. The threads created
+ * during the scan, or blocking the signal, are not scanned.
+ * 
+ * @return  unsigned long int   The number of stopped threads
  */
-static void memdebug_free_object( void * ptr, const char * file, const int line, const char * func )
+static unsigned long int memdebug_leak_stop_threads( void )
 {
-    struct memdebug_object * object;
+    DIR * dir;
+    struct dirent * entry;
+    struct sigaction sa;
+    struct timespec delay;
+    pid_t pid;
+    long self;
+    long tid;
+    unsigned long int num_tids;
+    unsigned long int signaled;
+    unsigned long int i;
     
-    /* Checks if the address we are trying to free exists in the pool */
-    if( NULL == ( object = memdebug_get_object( ptr ) ) )
+    pid      = getpid();
+    self     = syscall( SYS_gettid );
+    num_tids = 0;
+    signaled = 0;
+    
+    /* Lists the threads, before any of them is stopped */
+    if( NULL == ( dir = opendir( "/proc/self/task" ) ) )
     {
-        memdebug_warning
-        (
-            "Trying to free a non-existing object (pointer address: %p)",
-            file,
-            line,
-            func,
-            ptr
-        );
+        return 0;
     }
     
-    /* Checks if the memory area was already freed */
-    if( object->free == MEMDEBUG_TRUE )
+    /* The threads of a previous scan which have not handled the signal yet are listed again, if they still exist */
+    memdebug_leaks.num_tids = 0;
+    
+    while( NULL != ( entry = readdir( dir ) ) && num_tids < MEMDEBUG_LEAK_THREADS )
     {
-        memdebug_warning
-        (
-            "Trying to free a freed object (pointer address: %p)",
-            file,
-            line,
-            func,
-            ptr
-        );
+        tid = strtol( entry->d_name, NULL, 10 );
+        
+        /* The worker threads of the leak scanner are not stopped */
+        for( i = 1; i < memdebug_leaks.num_workers && memdebug_leaks.workers[ i ].tid != tid; i++ );
+        
+        if( tid > 0 && tid != self && i >= memdebug_leaks.num_workers )
+        {
+            memdebug_leaks.tids[ num_tids++ ] = tid;
+        }
     }
     
-    if( memdebug_check_fence( object ) == MEMDEBUG_FALSE )
+    closedir( dir );
+    
+    /* Sizes the memory map buffer, which is read once the threads are stopped */
+    memdebug_leaks.maps_size = 65536 + ( num_tids * 1024 );
+    
+    if( NULL == ( memdebug_leaks.maps = ( char * )memdebug_meta_realloc( memdebug_leaks.maps, memdebug_leaks.maps_size ) ) )
     {
-        memdebug_warning
+        memdebug_fatal
         (
-            "A buffer overflow was detected (pointer address: %p)",
-            file,
-            line,
-            func,
-            ptr
+            "MEMDebug error: cannot allocate memory for the leak scanner. Reason: %s\n",
+            strerror( errno )
         );
     }
     
-    /* Udpates the memory record object */
-    object->free      = MEMDEBUG_TRUE;
-    object->free_file = file;
-    object->free_line = line;
-    object->free_func = func;
+    memdebug_leaks.stopped = 0;
+    memdebug_leaks.running = 0;
+    memdebug_leaks.resume  = 0;
     
-    /* Checks if we are using GCC */
-    #ifdef __GNUC__
+    /* The action of the program is saved only once, as the handler may still be installed by a previous scan */
+    if( memdebug_leaks.installed == 0 )
+    {
+        sa.sa_sigaction = memdebug_leak_stop_handler;
+        sa.sa_flags     = SA_RESTART | SA_SIGINFO;
+        sigfillset( &sa.sa_mask );
+        
+        if( sigaction( MEMDEBUG_LEAK_SIGNAL, &sa, &memdebug_leaks.previous_action ) != 0 )
+        {
+            return 0;
+        }
+        
+        memdebug_leaks.installed = 1;
+    }
     
-    /* Stores the address of the caller function */
-    object->free_func_addr = __builtin_return_address( 1 );
+    memdebug_leaks.num_tids = num_tids;
     
-    #endif
+    __sync_synchronize();
     
-    /* Updates the memory usage */
-    memdebug_trace->num_active--;
-    memdebug_trace->num_free++;
-    memdebug_trace->memory_active -= object->size;
+    for( i = 0; i < num_tids; i++ )
+    {
+        if( syscall( SYS_tgkill, pid, memdebug_leaks.tids[ i ], MEMDEBUG_LEAK_SIGNAL ) == 0 )
+        {
+            signaled++;
+        }
+        else
+        {
+            memdebug_leaks.tids[ i ] = 0;
+        }
+    }
+    
+    /* Waits for the threads to stop (a thread may have exited in the meantime) */
+    delay.tv_sec  = 0;
+    delay.tv_nsec = 1000000;
+    
+    for( i = 0; i < MEMDEBUG_LEAK_TIMEOUT && ( unsigned long int )memdebug_leaks.stopped < signaled; i++ )
+    {
+        nanosleep( &delay, NULL );
+    }
+    
+    return ( unsigned long int )memdebug_leaks.stopped;
 }
 
 /**
- * Gets a memory record object from the pool
+ * Resumes the threads stopped by memdebug_leak_stop_threads()
  * 
- * @param   void *                      The address of the memory area corresponding to the memory record object
- * @return  struct memdebug_object *    The memory record object, or NULL if it was not found in the pool
+ * The previous action of the signal is restored once every signaled thread
+ * has handled it, or has exited. A thread blocking the signal could receive
+ * it later, so the handler is otherwise left installed (it returns at once
+ * when no scan is running).
+ * 
+ * @return  void
  */
-static struct memdebug_object * memdebug_get_object( void * ptr )
+static void memdebug_leak_resume_threads( void )
 {
-    unsigned int i;
+    struct timespec delay;
+    pid_t pid;
+    unsigned long int pending;
+    unsigned long int i;
+    unsigned long int j;
     
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    memdebug_leaks.resume = 1;
     
-    /* Tries to find the object in the pool */
-    for( i = 0; i < memdebug_trace->num_objects; i++ )
+    while( memdebug_leaks.running > 0 )
+    {
+        sched_yield();
+    }
+    
+    pid           = getpid();
+    pending       = 0;
+    delay.tv_sec  = 0;
+    delay.tv_nsec = 1000000;
+    
+    for( i = 0; i < MEMDEBUG_LEAK_TIMEOUT; i++ )
     {
-        /* Checks if the given pointer is the same as the one in the memory record object */
-        if( memdebug_trace->objects[ i ].ptr == ptr )
+        pending = 0;
+        
+        for( j = 0; j < memdebug_leaks.num_tids; j++ )
         {
-            /* Yes, returns the memory record object corresponding to the given pointer */
-            return &memdebug_trace->objects[ i ];
+            if( memdebug_leaks.tids[ j ] == 0 )
+            {
+                continue;
+            }
+            
+            /* Checks if the thread still exists */
+            if( syscall( SYS_tgkill, pid, memdebug_leaks.tids[ j ], 0 ) != 0 && errno == ESRCH )
+            {
+                memdebug_leaks.tids[ j ] = 0;
+                
+                continue;
+            }
+            
+            pending++;
+        }
+        
+        if( pending == 0 )
+        {
+            break;
         }
+        
+        nanosleep( &delay, NULL );
     }
     
-    /* No memory record object corresponding to the given pointer */
-    return NULL;
-}
-
-/**
- * 
- */
-static void memdebug_write_fence( struct memdebug_object * object )
-{
-    memdebug_fence * ptr;
+    /* A thread still in the handler must not run the action of the program */
+    while( memdebug_leaks.running > 0 )
+    {
+        sched_yield();
+    }
     
-    ptr      = ( ( memdebug_fence * )object->ptr - 1 );
-    *( ptr ) = MEMDEBUG_FENCE_VAL;
-    ptr      = ( memdebug_fence * )( ( char * )ptr + object->size ) + 1;
-    *( ptr ) = MEMDEBUG_FENCE_VAL;
+    if( pending == 0 )
+    {
+        sigaction( MEMDEBUG_LEAK_SIGNAL, &memdebug_leaks.previous_action, NULL );
+        
+        memdebug_leaks.installed = 0;
+        memdebug_leaks.num_tids  = 0;
+    }
 }
 
 /**
+ * Signal handler used to stop the threads during the leak scan
+ * 
+ * The registers of the interrupted code are saved in the signal frame, on
+ * the stack of the thread, above the stack pointer saved here.
+ * Outside of a scan, the signals not sent by the leak scanner are passed to
+ * the previous handler of the program.
  * 
+ * @param   int         The signal number
+ * @param   siginfo_t * The signal information
+ * @param   void *      The context of the interrupted code
+ * @return  void
  */
-static memdebug_bool memdebug_check_fence( struct memdebug_object * object )
+static void memdebug_leak_stop_handler( int id, siginfo_t * info, void * context )
 {
-    memdebug_fence * ptr;
+    int saved_errno;
+    int slot;
+    long tid;
+    unsigned long int i;
+    memdebug_bool sent;
     
-    ptr  = ( ( memdebug_fence * )object->ptr - 1 );
+    saved_errno = errno;
     
-    if( *( ptr ) != MEMDEBUG_FENCE_VAL )
+    __sync_fetch_and_add( &memdebug_leaks.running, 1 );
+    
+    /* The signal may be handled after the end of the scan, if it was blocked */
+    if( memdebug_leaks.resume == 0 )
     {
-        return MEMDEBUG_FALSE;
+        if( ( slot = __sync_fetch_and_add( &memdebug_leaks.stopped, 1 ) ) < MEMDEBUG_LEAK_THREADS )
+        {
+            memdebug_leaks.stacks[ slot ] = ( void * )&slot;
+        }
+        
+        __sync_synchronize();
+        
+        while( memdebug_leaks.resume == 0 )
+        {
+            sched_yield();
+        }
+        
+        sent = MEMDEBUG_TRUE;
+    }
+    else
+    {
+        sent = MEMDEBUG_FALSE;
     }
     
-    ptr = ( memdebug_fence * )( ( char * )ptr + object->size ) + 1;
+    tid = syscall( SYS_gettid );
     
-    if( *( ptr ) != MEMDEBUG_FENCE_VAL )
+    for( i = 0; i < memdebug_leaks.num_tids; i++ )
     {
-        return MEMDEBUG_FALSE;
+        if( memdebug_leaks.tids[ i ] == tid )
+        {
+            memdebug_leaks.tids[ i ] = 0;
+            sent                     = MEMDEBUG_TRUE;
+        }
     }
     
-    return MEMDEBUG_TRUE;
+    __sync_fetch_and_sub( &memdebug_leaks.running, 1 );
+    
+    errno = saved_errno;
+    
+    if( sent == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    if( memdebug_leaks.previous_action.sa_flags & SA_SIGINFO )
+    {
+        memdebug_leaks.previous_action.sa_sigaction( id, info, context );
+    }
+    else if( memdebug_leaks.previous_action.sa_handler != SIG_DFL && memdebug_leaks.previous_action.sa_handler != SIG_IGN )
+    {
+        memdebug_leaks.previous_action.sa_handler( id );
+    }
 }
 
+#endif
+
 /**
- * Allocates some memory
+ * Prints the leaked memory areas, grouped by allocation site
  * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
+ * @param   unsigned long int   The number of directly leaked memory areas
+ * @param   unsigned long int   The number of indirectly leaked memory areas
+ * @return  void
  */
-void * memdebug_malloc( size_t size, const char * file, const int line, const char * func )
+static void memdebug_leak_report( unsigned long int num_direct, unsigned long int num_indirect )
 {
-    void * ptr;
+    unsigned long int i;
+    unsigned long int j;
+    unsigned long int num_sites;
+    size_t size_direct;
+    size_t size_indirect;
+    char mark_time[ 32 ];
+    struct memdebug_object * object;
+    struct memdebug_site_stats * sites;
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )malloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    memdebug_format_duration( ( double )memdebug_leaks.mark_ticks * memdebug_tick_ns(), mark_time, sizeof( mark_time ) );
+    
+    /* Two counters for each allocation site - Direct leaks, then indirect ones */
+    if( NULL == ( sites = ( struct memdebug_site_stats * )memdebug_meta_alloc( ( ( memdebug_sites.count * 2 ) + 1 ) * sizeof( struct memdebug_site_stats ) ) ) )
     {
-        memdebug_warning
+        memdebug_fatal
         (
-            "The call to malloc() failed. Reason: %s",
-            file,
-            line,
-            func,
+            "MEMDebug error: cannot allocate memory for the report. Reason: %s\n",
             strerror( errno )
         );
     }
-    else
+    
+    size_direct   = 0;
+    size_indirect = 0;
+    
+    for( i = 0; i < memdebug_leaks.count; i++ )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        if( MEMDEBUG_LEAK_TEST( memdebug_leaks.reachable, i ) )
+        {
+            continue;
+        }
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_MALLOC );
+        object = &memdebug_trace->objects[ memdebug_leaks.blocks[ i ].record ];
+        j      = ( !MEMDEBUG_LEAK_TEST( memdebug_leaks.indirect, i ) ) ? object->site : object->site + memdebug_sites.count;
+        
+        sites[ j ].file  = object->alloc_file;
+        sites[ j ].line  = object->alloc_line;
+        sites[ j ].func  = object->alloc_func;
+        sites[ j ].size += object->size;
+        
+        sites[ j ].count++;
+        
+        if( !MEMDEBUG_LEAK_TEST( memdebug_leaks.indirect, i ) )
+        {
+            size_direct += object->size;
+        }
+        else
+        {
+            size_indirect += object->size;
+        }
+    }
+    
+    fprintf
+    (
+        memdebug_output,
+        MEMDEBUG_HR
+        "# MEMDebug - Leaks\n"
+        MEMDEBUG_REV
+        MEMDEBUG_HR
+        "# \n"
+        "# - Number of scanned objects:             %lu\n"
+        "# - Mark phase:                            %s (%u threads)\n"
+        "# - Directly leaked memory:                %lu bytes in %lu objects\n"
+        "# - Indirectly leaked memory:              %lu bytes in %lu objects\n"
+        "# \n",
+        memdebug_leaks.count,
+        mark_time,
+        memdebug_leaks.num_workers,
+        ( unsigned long int )size_direct,
+        num_direct,
+        ( unsigned long int )size_indirect,
+        num_indirect
+    );
+    
+    /* Packs and sorts each half, then prints it */
+    for( j = 0; j < 2; j++ )
+    {
+        for( i = 0, num_sites = 0; i < memdebug_sites.count; i++ )
+        {
+            if( sites[ ( j * memdebug_sites.count ) + i ].count > 0 )
+            {
+                sites[ ( j * memdebug_sites.count ) + num_sites++ ] = sites[ ( j * memdebug_sites.count ) + i ];
+            }
+        }
+        
+        qsort( sites + ( j * memdebug_sites.count ), num_sites, sizeof( struct memdebug_site_stats ), memdebug_site_stats_compare );
+        
+        for( i = 0; i < num_sites; i++ )
+        {
+            fprintf
+            (
+                memdebug_output,
+                "# - %s leak of %lu bytes in %lu objects, allocated in %s() - %s:%i\n",
+                ( j == 0 ) ? "Direct" : "Indirect",
+                ( unsigned long int )sites[ ( j * memdebug_sites.count ) + i ].size,
+                sites[ ( j * memdebug_sites.count ) + i ].count,
+                sites[ ( j * memdebug_sites.count ) + i ].func,
+                sites[ ( j * memdebug_sites.count ) + i ].file,
+                sites[ ( j * memdebug_sites.count ) + i ].line
+            );
+        }
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+        MEMDEBUG_HR
+    );
+    
+    memdebug_meta_free( sites );
 }
 
 /**
- * Allocates some memory
+ * Checks for leaks, by finding the active memory areas which cannot be reached anymore
  * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
+ * The data segments, the stacks and the registers of the threads are
+ * scanned for pointers to the active memory areas (conservative scan), and
+ * then the contents of the reachable memory areas. The other memory areas
+ * are leaked - directly, or indirectly when they are only referenced by
+ * other leaked memory areas.
+ * 
+ * The other threads are stopped during the scan. Pointers stored in memory
+ * not allocated through MEMDebug are not seen, so the memory areas only
+ * referenced from there are reported as leaked.
+ * 
+ * @return  unsigned long int   The number of leaked memory areas (direct and indirect)
  */
-void * memdebug_valloc( size_t size, const char * file, const int line, const char * func )
+unsigned long int memdebug_check_leaks( void )
 {
-    void * ptr;
+    unsigned long int i;
+    unsigned long int slot;
+    unsigned long int num_direct;
+    unsigned long int num_indirect;
+    unsigned long int words;
+    unsigned int workers;
+    jmp_buf registers;
+    struct memdebug_object * object;
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )valloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    /* Checks if the leak scanner can find the roots */
+    #ifndef MEMDEBUG_HAVE_LEAK_SCANNER
+    
+    fprintf( memdebug_output, "MEMDebug: leak checking is not supported on this platform\n" );
+    
+    return 0;
+    
+    #endif
+    
+    /* The memory records must not change during the scan */
+    MEMDEBUG_LOCK;
+    
+    /* Builds the interval index of the active memory areas */
+    memdebug_leaks.count = 0;
+    words                = ( memdebug_active_index.count / MEMDEBUG_LEAK_BITS ) + 1;
+    
+    if
+    (
+           NULL == ( memdebug_leaks.blocks    = ( struct memdebug_leak_block * )memdebug_meta_realloc( memdebug_leaks.blocks, ( memdebug_active_index.count + 1 ) * sizeof( struct memdebug_leak_block ) ) )
+        || NULL == ( memdebug_leaks.overflow  = ( unsigned long int * )memdebug_meta_realloc( memdebug_leaks.overflow, ( memdebug_active_index.count + 1 ) * sizeof( unsigned long int ) ) )
+        || NULL == ( memdebug_leaks.reachable = ( unsigned long int * )memdebug_meta_realloc( memdebug_leaks.reachable, words * sizeof( unsigned long int ) ) )
+        || NULL == ( memdebug_leaks.indirect  = ( unsigned long int * )memdebug_meta_realloc( memdebug_leaks.indirect, words * sizeof( unsigned long int ) ) )
+        || NULL == ( memdebug_leaks.workers   = ( struct memdebug_leak_worker * )memdebug_meta_realloc( memdebug_leaks.workers, memdebug_config.leak_threads * sizeof( struct memdebug_leak_worker ) ) )
+    )
     {
-        memdebug_warning
+        memdebug_fatal
         (
-            "The call to valloc() failed. Reason: %s",
-            file,
-            line,
-            func,
+            "MEMDebug error: cannot allocate memory for the leak scanner. Reason: %s\n",
             strerror( errno )
         );
     }
-    else
+    
+    for( slot = 0; slot < memdebug_active_index.capacity; slot++ )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        if( memdebug_active_index.slots[ slot ] == 0 )
+        {
+            continue;
+        }
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_VALLOC );
+        object = &memdebug_trace->objects[ memdebug_active_index.slots[ slot ] - 1 ];
+        
+        memdebug_leaks.blocks[ memdebug_leaks.count ].start  = ( const char * )object->ptr;
+        memdebug_leaks.blocks[ memdebug_leaks.count ].end    = ( const char * )object->ptr + object->size;
+        memdebug_leaks.blocks[ memdebug_leaks.count ].record = memdebug_active_index.slots[ slot ] - 1;
+        
+        memdebug_leaks.count++;
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-/**
- * Allocates some memory
- * 
- * @param   size_t          The number of time to allocate the memory size
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
- */
-void * memdebug_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
-{
-    void * ptr;
+    qsort( memdebug_leaks.blocks, memdebug_leaks.count, sizeof( struct memdebug_leak_block ), memdebug_leak_block_compare );
+    memset( memdebug_leaks.reachable, 0, words * sizeof( unsigned long int ) );
+    memset( memdebug_leaks.indirect, 0, words * sizeof( unsigned long int ) );
     
-    /* Allocates memory */
-    /* We don't use calloc as we want to add room for the fence */
-    if( NULL == ( ptr = ( void * )malloc( MEMDEBUG_ALLOC_SIZE( size1 * size2 ) ) ) )
+    memdebug_leaks.num_workers    = memdebug_config.leak_threads;
+    memdebug_leaks.overflow_depth = 0;
+    memdebug_leaks.pending        = 0;
+    
+    pthread_mutex_init( &memdebug_leaks.overflow_lock, NULL );
+    
+    for( i = 0; i < memdebug_leaks.num_workers; i++ )
     {
-        memdebug_warning
-        (
-            "The call to calloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
+        pthread_mutex_init( &memdebug_leaks.workers[ i ].lock, NULL );
+        
+        memdebug_leaks.workers[ i ].depth   = 0;
+        memdebug_leaks.workers[ i ].tid     = 0;
+        memdebug_leaks.workers[ i ].scanned = 0;
     }
-    else
+    
+    workers = memdebug_leaks.num_workers;
+    
+    /* Saves the registers of the current thread on its stack */
+    if( setjmp( registers ) == 0 )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        /* Checks if we are using GCC */
+        #ifdef __GNUC__
         
-        /* Sets all bits to 0 */
-        memset( ptr, 0, size1 * size2 );
+        /* Also saves the callee-saved registers that setjmp() may mangle */
+        __builtin_unwind_init();
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size1 * size2, file, line, func, MEMDEBUG_ALLOC_TYPE_CALLOC );
+        #endif
+        
+        memdebug_leak_mark();
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-/**
- * Reallocates a memory area
- * 
- * @param   void *          The address of the original memory area
- * @param   size_t          The new memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the reallocated memory area
- */
-void * memdebug_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
-{
-    void * ptr_new;
-    
-    /* Rellocates memory */
-    if( NULL == ( ptr_new = ( void * )realloc( ptr, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    for( i = 0; i < workers; i++ )
     {
-        memdebug_warning
-        (
-            "The call to realloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
-        return ptr_new;
+        pthread_mutex_destroy( &memdebug_leaks.workers[ i ].lock );
     }
-    else
+    
+    pthread_mutex_destroy( &memdebug_leaks.overflow_lock );
+    
+    num_direct   = 0;
+    num_indirect = 0;
+    
+    for( i = 0; i < memdebug_leaks.count; i++ )
     {
-        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
-        
-        /* Updates the memory record object */
-        memdebug_update_object( ptr, ptr_new, size, file, line, func, MEMDEBUG_ALLOC_TYPE_REALLOC );
+        if( !MEMDEBUG_LEAK_TEST( memdebug_leaks.reachable, i ) )
+        {
+            num_direct   += ( MEMDEBUG_LEAK_TEST( memdebug_leaks.indirect, i ) == 0 );
+            num_indirect += ( MEMDEBUG_LEAK_TEST( memdebug_leaks.indirect, i ) != 0 );
+        }
     }
     
-    /* Returns the address of the reallocated area */
-    return ptr_new;
+    memdebug_leak_report( num_direct, num_indirect );
+    
+    MEMDEBUG_UNLOCK;
+    
+    return num_direct + num_indirect;
 }
 
 /**
- * Frees a memory area
+ * Sets the number of threads used by the mark phase of the leak scanner
  * 
- * @param   void *          The address of the memory area to free
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
+ * @param   unsigned int    The number of threads (including the calling thread)
  * @return  void
  */
-void memdebug_free( void * ptr, const char * file, const int line, const char * func )
+void memdebug_set_leak_threads( unsigned int threads )
 {
-    /* Marks the object as freed */
-    memdebug_free_object( ptr, file, line, func );
-    
-    /* Frees the memory area */
-    free( ( memdebug_fence * )ptr - 1 );
+    memdebug_config.leak_threads = ( threads == 0 ) ? 1 : threads;
 }
 
-/* Checks if the alloca function is available */
-#ifdef _ALLOCA_H_
-
-/* Checks if we are using GCC 3 or greater */
-#if defined( __GNUC__ ) && __GNUC__ >= 3
-
 /**
- * Allocates some memory in the stack
+ * Starts a thread answering commands on a Unix domain socket
  * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
+ * The commands are read one per line, and the answers are written in the
+ * format of the other output functions:
+ * 
+ *  -   status:         the status of the memory allocations
+ *  -   sites [N]:      the N allocation sites with the most active memory (10 by default)
+ *  -   histogram:      the size classes of the allocations
+ *  -   dump <path>:    exports the active memory records to a file, as JSON Lines
+ *  -   help:           the list of the commands
+ * 
+ * The memory records are locked while a command is answered, so the
+ * allocations of the program wait for it.
+ * 
+ * @param   const char *    The path of the socket (an existing socket is replaced)
+ * @return  int             0 on success, -1 on failure (errno is set)
  */
-void * memdebug_builtin_alloca( size_t size, const char * file, const int line, const char * func )
+int memdebug_listen( const char * path )
 {
-    void * ptr;
+    int error;
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )__builtin_alloca( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
+    
+    if( memdebug_listener.running == MEMDEBUG_TRUE )
     {
-        memdebug_warning
-        (
-            "The call to __builtin_alloca() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
+        errno = EBUSY;
+        return -1;
     }
-    else
+    
+    if( path == NULL || strlen( path ) >= sizeof( memdebug_listener.address.sun_path ) )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
-        
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN );
+        errno = ENAMETOOLONG;
+        return -1;
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-#else 
-
-/**
- * Allocates some memory in the stack
- * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
- */
-void * memdebug_alloca( size_t size, const char * file, const int line, const char * func )
-{
-    void * ptr;
+    memset( &memdebug_listener.address, 0, sizeof( struct sockaddr_un ) );
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )alloca( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
-    {
-        memdebug_warning
-        (
-            "The call to alloca() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
-    }
-    else
+    memdebug_listener.address.sun_family = AF_UNIX;
+    
+    strcpy( memdebug_listener.address.sun_path, path );
+    
+    if( ( memdebug_listener.fd = socket( AF_UNIX, SOCK_STREAM, 0 ) ) == -1 )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
-        
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_ALLOCA );
+        return -1;
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-#endif
-#endif
-
-/* Checks if the Objective-C garbage collector is present */
-#if defined( OBJC_WITH_GC ) && OBJC_WITH_GC
-
-/**
- * Allocates some memory
- * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
- */
-void * memdebug_gc_malloc( size_t size, const char * file, const int line, const char * func )
-{
-    void * ptr;
+    unlink( path );
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )GC_malloc( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    if
+    (
+           bind( memdebug_listener.fd, ( struct sockaddr * )&memdebug_listener.address, sizeof( struct sockaddr_un ) ) != 0
+        || listen( memdebug_listener.fd, 4 ) != 0
+    )
     {
-        memdebug_warning
-        (
-            "The call to GC_malloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
+        error = errno;
+        
+        close( memdebug_listener.fd );
+        
+        errno = error;
+        
+        return -1;
     }
-    else
+    
+    /* The listener thread survives the clients closing their connection, as it blocks SIGPIPE */
+    if( ( error = memdebug_create_thread( &memdebug_listener.thread, memdebug_listener_main ) ) != 0 )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        close( memdebug_listener.fd );
+        unlink( path );
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC );
+        errno = error;
+        
+        return -1;
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
+    memdebug_listener.running = MEMDEBUG_TRUE;
+    
+    atexit( memdebug_listener_atexit );
+    
+    return 0;
+}
+
+/**
+ * Removes the socket of the listener when the program exits
+ * 
+ * @return  void
+ */
+static void memdebug_listener_atexit( void )
+{
+    unlink( memdebug_listener.address.sun_path );
 }
 
 /**
- * Allocates some memory
+ * Main function of the listener thread - Serves the clients, one at a time
  * 
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
+ * @param   void *  Unused
+ * @return  void *  NULL
  */
-void * memdebug_gc_malloc_atomic( size_t size, const char * file, const int line, const char * func )
+static void * memdebug_listener_main( void * data )
 {
-    void * ptr;
+    int fd;
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )GC_malloc_atomic( MEMDEBUG_ALLOC_SIZE( size ) ) ) )
-    {
-        memdebug_warning
-        (
-            "The call to GC_malloc_atomic() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
-    }
-    else
+    ( void )data;
+    
+    for( ;; )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        if( ( fd = accept( memdebug_listener.fd, NULL, NULL ) ) == -1 )
+        {
+            if( errno == EINTR || errno == ECONNABORTED )
+            {
+                continue;
+            }
+            
+            break;
+        }
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC );
+        memdebug_listener_serve( fd );
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
+    return NULL;
 }
 
 /**
- * Allocates some memory
+ * Answers the commands of a client, until it closes its connection
  * 
- * @param   size_t          The number of time to allocate the memory size
- * @param   size_t          The memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the allocated memory area
+ * A client which does not read its answers is disconnected after
+ * MEMDEBUG_LISTENER_TIMEOUT seconds.
+ * 
+ * @param   int     The socket of the client
+ * @return  void
  */
-void * memdebug_gc_calloc( size_t size1, size_t size2, const char * file, const int line, const char * func )
+static void memdebug_listener_serve( int fd )
 {
-    void * ptr;
-    
-    /* Allocates memory */
-    /* We don't use GC_calloc as we want to add room for the fence */
-    if( NULL == ( ptr = ( void * )GC_malloc( MEMDEBUG_ALLOC_SIZE( size1 * size2 ) ) ) )
+    FILE * input;
+    char * answer;
+    size_t length;
+    size_t written;
+    ssize_t result;
+    struct timeval timeout;
+    char command[ MEMDEBUG_LISTENER_LINE_SIZE ];
+    
+    timeout.tv_sec  = MEMDEBUG_LISTENER_TIMEOUT;
+    timeout.tv_usec = 0;
+    
+    if
+    (
+           setsockopt( fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof( struct timeval ) ) != 0
+        || NULL == ( input = fdopen( fd, "r" ) )
+    )
     {
-        memdebug_warning
-        (
-            "The call to GC_calloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
+        close( fd );
+        
+        return;
     }
-    else
+    
+    while( fgets( command, sizeof( command ), input ) != NULL )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
+        if( NULL == ( answer = memdebug_listener_command( command, &length ) ) )
+        {
+            continue;
+        }
         
-        /* Sets all bits to 0 */
-        memset( ptr, 0, size1 * size2 );
+        /* The answer is written without the lock, so the program is never blocked by the client */
+        written = 0;
         
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size1 * size2, file, line, func, MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC );
+        while( written < length )
+        {
+            result = write( fd, answer + written, length - written );
+            
+            if( result < 0 )
+            {
+                if( errno == EINTR )
+                {
+                    continue;
+                }
+                
+                break;
+            }
+            
+            written += ( size_t )result;
+        }
+        
+        memdebug_meta_free( answer );
+        
+        if( written < length )
+        {
+            break;
+        }
     }
     
-    /* Returns the address of the allocated area */
-    return ptr;
+    fclose( input );
 }
 
 /**
- * Reallocates a memory area
+ * Answers a command of a client of the listener
  * 
- * @param   void *          The address of the original memory area
- * @param   size_t          The new memory size to allocate
- * @param   const char *    The file in which the call was made
- * @param   const int       The line of the file in which the call was made
- * @param   const char *    The name of the function in which the call was made
- * @return  void *          A pointer to the reallocated memory area
+ * The answer is written to a buffer from the metadata arena while the lock
+ * is held, and the buffer is grown until the whole answer fits.
+ * 
+ * @param   char *      The command (modified)
+ * @param   size_t *    On return, the length of the answer
+ * @return  char *      The answer (to free with memdebug_meta_free()), or NULL if there is nothing to answer
  */
-void * memdebug_gc_realloc( void * ptr, size_t size, const char * file, const int line, const char * func )
+static char * memdebug_listener_command( char * command, size_t * length )
 {
-    void * ptr_new;
+    char * name;
+    char * argument;
+    char * answer;
+    size_t size;
+    long position;
+    FILE * stream;
+    FILE * output;
     
-    /* Rellocates memory */
-    if( NULL == ( ptr_new = ( void * )GC_realloc( ptr, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    name     = strtok( command, " \t\r\n" );
+    argument = strtok( NULL, " \t\r\n" );
+    
+    if( name == NULL )
     {
-        memdebug_warning
-        (
-            "The call to GC_realloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
-        return ptr_new;
+        return NULL;
     }
-    else
+    
+    for( size = MEMDEBUG_LISTENER_ANSWER_SIZE; ; size *= 2 )
     {
-        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
+        answer = ( char * )memdebug_meta_alloc( size );
         
-        /* Updates the memory record object */
-        memdebug_update_object( ptr, ptr_new, size, file, line, func, MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC );
+        if( NULL == ( stream = fmemopen( answer, size, "w" ) ) )
+        {
+            memdebug_meta_free( answer );
+            
+            return NULL;
+        }
+        
+        MEMDEBUG_LOCK;
+        
+        fflush( memdebug_output );
+        
+        output          = memdebug_output;
+        memdebug_output = stream;
+        
+        memdebug_listener_answer( name, argument );
+        
+        memdebug_output = output;
+        
+        MEMDEBUG_UNLOCK;
+        
+        fflush( stream );
+        
+        position = ftell( stream );
+        
+        fclose( stream );
+        
+        /* The last byte is kept for the terminating null character */
+        if( position >= 0 && ( size_t )position < size - 1 )
+        {
+            *( length ) = ( size_t )position;
+            
+            return answer;
+        }
+        
+        memdebug_meta_free( answer );
     }
-    
-    /* Returns the address of the reallocated area */
-    return ptr_new;
 }
 
-#endif
-
-#ifdef _MALLOC_MALLOC_H_
-
-void * memdebug_malloc_zone_malloc( malloc_zone_t * zone, size_t size, const char * file, const int line, const char * func )
+/**
+ * Prints the answer to a command of a client of the listener
+ * 
+ * The lock must be held, as the output functions write to the answer of
+ * the client.
+ * 
+ * @param   const char *    The name of the command
+ * @param   const char *    The argument of the command, or NULL
+ * @return  void
+ */
+static void memdebug_listener_answer( const char * name, const char * argument )
 {
-    void * ptr;
+    int fd;
+    unsigned long int count;
     
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )malloc_zone_malloc( zone, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    if( strcmp( name, "status" ) == 0 )
     {
-        memdebug_warning
-        (
-            "The call to malloc_zone_malloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
+        memdebug_print_status();
     }
-    else
+    else if( strcmp( name, "sites" ) == 0 )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
-        
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC );
+        memdebug_print_top_sites( ( argument == NULL ) ? MEMDEBUG_LISTENER_SITES : strtoul( argument, NULL, 0 ) );
     }
-    
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-void * memdebug_malloc_zone_calloc( malloc_zone_t * zone, size_t size1, size_t size2, const char * file, const int line, const char * func )
-{
-    void * ptr;
-    
-    /* Allocates memory */
-    /* We don't use malloc_zone_calloc as we want to add room for the fence */
-    if( NULL == ( ptr = ( void * )malloc_zone_malloc( zone, MEMDEBUG_ALLOC_SIZE( size1 * size2 ) ) ) )
+    else if( strcmp( name, "reallocs" ) == 0 )
     {
-        memdebug_warning
+        memdebug_print_realloc_sites( ( argument == NULL ) ? MEMDEBUG_LISTENER_SITES : strtoul( argument, NULL, 0 ) );
+    }
+    else if( strcmp( name, "histogram" ) == 0 )
+    {
+        fprintf
         (
-            "The call to malloc_zone_calloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
+            memdebug_output,
+            MEMDEBUG_HR
+            "# MEMDebug - Size classes\n"
+            MEMDEBUG_REV
+            MEMDEBUG_HR
+            "# \n"
+        );
+        memdebug_print_histograms();
+        fprintf
+        (
+            memdebug_output,
+            "# \n"
+            MEMDEBUG_HR
         );
     }
-    else
+    else if( strcmp( name, "dump" ) == 0 && argument != NULL )
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
-        
-        /* Sets all bits to 0 */
-        memset( ptr, 0, size1 * size2 );
-        
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size1 * size2, file, line, func, MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC );
+        if( ( fd = open( argument, O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) == -1 )
+        {
+            fprintf( memdebug_output, "MEMDebug: cannot open the file '%s'. Reason: %s\n", argument, strerror( errno ) );
+        }
+        else
+        {
+            count = memdebug_export( fd, MEMDEBUG_EXPORT_JSON, MEMDEBUG_EXPORT_ACTIVE );
+            
+            close( fd );
+            
+            fprintf( memdebug_output, "MEMDebug: %lu active memory records written to '%s'\n", count, argument );
+        }
     }
-    
-    /* Returns the address of the allocated area */
-    return ptr;
-}
-
-void * memdebug_malloc_zone_valloc( malloc_zone_t * zone, size_t size, const char * file, const int line, const char * func )
-{
-    void * ptr;
-    
-    /* Allocates memory */
-    if( NULL == ( ptr = ( void * )malloc_zone_valloc( zone, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    else if( strcmp( name, "help" ) == 0 )
     {
-        memdebug_warning
+        fprintf
         (
-            "The call to malloc_zone_valloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
+            memdebug_output,
+            "status         Prints the status of the memory allocations\n"
+            "sites [N]      Prints the N allocation sites with the most active memory (default: %i)\n"
+            "reallocs [N]   Prints the N allocation sites with the most bytes copied by reallocations (default: %i)\n"
+            "histogram      Prints the size classes of the allocations\n"
+            "dump <path>    Writes the active memory records to a file, as JSON Lines\n"
+            "help           Prints this help\n",
+            MEMDEBUG_LISTENER_SITES,
+            MEMDEBUG_LISTENER_SITES
         );
     }
     else
     {
-        ptr = ( void * )( ( memdebug_fence * )ptr + 1 );
-        
-        /* Creates a new memory record object for the allocated area */
-        memdebug_new_object( ptr, size, file, line, func, MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC );
+        fprintf( memdebug_output, "MEMDebug: unknown command '%s' (try 'help')\n", name );
     }
-    
-    /* Returns the address of the allocated area */
-    return ptr;
 }
 
-void memdebug_malloc_zone_free( malloc_zone_t * zone, void * ptr, const char * file, const int line, const char * func )
+/**
+ * Publishes the statistics of the memory allocations in a POSIX shared memory object
+ * 
+ * The counters of the memory records are updated after each allocation
+ * or deallocation, and the size classes and the allocation sites with the
+ * most active memory every MEMDEBUG_STATS_REFRESH updates, so the
+ * statistics can be monitored without any other cost for the program (see
+ * the memdebug-top program). The shared memory object is removed when the
+ * program exits.
+ * 
+ * @param   const char *    The name of the shared memory object (like "/foo")
+ * @return  int             0 on success, -1 on failure (errno is set)
+ */
+int memdebug_publish_stats( const char * name )
 {
-    /* Marks the object as freed */
-    memdebug_free_object( ptr, file, line, func );
+    int fd;
+    int error;
+    void * page;
     
-    /* Frees the memory area */
-    malloc_zone_free( zone, ( memdebug_fence * )ptr - 1 );
-}
-
-void * memdebug_malloc_zone_realloc( malloc_zone_t * zone, void * ptr, size_t size, const char * file, const int line, const char * func )
-{
-    void * ptr_new;
+    /* Initialization check */
+    MEMDEBUG_INIT_CHECK;
     
-    /* Rellocates memory */
-    if( NULL == ( ptr_new = ( void * )malloc_zone_realloc( zone, ptr, MEMDEBUG_ALLOC_SIZE( size ) ) ) )
+    if( memdebug_publisher.stats != NULL )
     {
-        memdebug_warning
-        (
-            "The call to malloc_zone_realloc() failed. Reason: %s",
-            file,
-            line,
-            func,
-            strerror( errno )
-        );
-        return ptr_new;
+        errno = EBUSY;
+        return -1;
     }
-    else
+    
+    if( name == NULL || strlen( name ) >= sizeof( memdebug_publisher.name ) )
     {
-        ptr_new = ( void * )( ( memdebug_fence * )ptr_new + 1 );
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    
+    if( ( fd = shm_open( name, O_RDWR | O_CREAT | O_TRUNC, 0644 ) ) == -1 )
+    {
+        return -1;
+    }
+    
+    if
+    (
+           ftruncate( fd, sizeof( struct memdebug_stats ) ) != 0
+        || MAP_FAILED == ( page = mmap( NULL, sizeof( struct memdebug_stats ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 ) )
+    )
+    {
+        error = errno;
         
-        /* Updates the memory record object */
-        memdebug_update_object( ptr, ptr_new, size, file, line, func, MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC );
+        close( fd );
+        shm_unlink( name );
+        
+        errno = error;
+        
+        return -1;
     }
     
-    /* Returns the address of the reallocated area */
-    return ptr_new;
+    close( fd );
+    strcpy( memdebug_publisher.name, name );
+    
+    MEMDEBUG_LOCK;
+    
+    /* The page is complete before the readers can identify it */
+    memdebug_publisher.stats       = ( struct memdebug_stats * )page;
+    memdebug_publisher.stats->size = sizeof( struct memdebug_stats );
+    memdebug_publisher.stats->pid  = ( long )getpid();
+    
+    memdebug_stats_refresh();
+    
+    __sync_synchronize();
+    
+    memdebug_publisher.stats->magic = MEMDEBUG_STATS_MAGIC;
+    
+    MEMDEBUG_UNLOCK;
+    
+    atexit( memdebug_stats_atexit );
+    
+    return 0;
 }
 
-#endif
+/**
+ * Removes the shared memory statistics page when the program exits
+ * 
+ * @return  void
+ */
+static void memdebug_stats_atexit( void )
+{
+    shm_unlink( memdebug_publisher.name );
+}
 
 /**
- * Displays an hexadecimal and ASCII representation of a memory record object
+ * Updates the counters of the shared memory statistics page, after an update of the memory records
+ * 
+ * The lock of the memory records must be held.
  * 
- * @param   struct memdebug_object *    The memory record object
  * @return  void
  */
-static void memdebug_dump( struct memdebug_object * object )
+static void memdebug_stats_update( void )
 {
-    long unsigned int i;
-    long unsigned int j;
-    unsigned char * read_ptr;
-    unsigned char c;
+    struct memdebug_stats * stats;
     
-    /* Gets a pointer to read the memory area of the object */
-    read_ptr = ( unsigned char * )object->ptr;
+    if( NULL == ( stats = memdebug_publisher.stats ) )
+    {
+        return;
+    }
     
-    /* Reads the memory area */
-    for( i = 0; i < object->size; i += MEMDEBUG_DUMP_BYTES )
+    if( ++memdebug_publisher.updates >= MEMDEBUG_STATS_REFRESH )
     {
-        /* Byte offset */
-        printf( "#   %010lu: ", i );
-        
-        /* Prints the hexadecimal representation */
-        for( j = i; j < i + MEMDEBUG_DUMP_BYTES; j++ )
-        {
-            /* Checks if we have data to display */
-            if( j < object->size )
-            {
-                /* Prints the hexadecimal data */
-                printf( "%02X ", ( unsigned char )read_ptr[ j ] );
-            }
-            else
-            {
-                /* No data to display - Pad */
-                printf( "   " );
-            }
-        }
-        
-        /* Separator */
-        printf( "| " );
-        
-        /* Prints the ASCII representation */
-        for( j = i; j < i + MEMDEBUG_DUMP_BYTES; j++ )
-        {
-            /* Reset */
-            c = 0;
-            
-            /* Checks if we have data to display */
-            if( j < object->size )
-            {
-                /* Gets the current character */
-                c = ( unsigned char )read_ptr[ j ];
-                
-                /* Checks if we can print the character */
-                if( ( ( ( c & 0x80 ) == 0 ) && isprint( ( int )c ) ) )
-                {
-                    /* Prints the current character */
-                    printf( "%c", c );
-                    
-                }
-                else
-                {
-                    /* Unprintable character */
-                    printf( "." );
-                }
-            }
-        }
-        
-        /* New line for the next offset */
-        printf( "\n" );
+        memdebug_stats_refresh();
+        return;
     }
+    
+    /* Odd while the page is updated */
+    stats->sequence++;
+    
+    __sync_synchronize();
+    
+    stats->num_objects       = memdebug_trace->num_objects;
+    stats->num_active        = memdebug_trace->num_active;
+    stats->num_free          = memdebug_trace->num_free;
+    stats->num_auto          = memdebug_trace->num_auto;
+    stats->num_untracked     = memdebug_trace->num_untracked;
+    stats->num_peak          = memdebug_trace->num_peak;
+    stats->memory_total      = ( unsigned long int )memdebug_trace->memory_total;
+    stats->memory_active     = ( unsigned long int )memdebug_trace->memory_active;
+    stats->memory_peak       = ( unsigned long int )memdebug_trace->memory_peak;
+    stats->memory_quarantine = ( unsigned long int )memdebug_quarantine.size;
+    
+    __sync_synchronize();
+    
+    stats->sequence++;
 }
 
-/* Checks if we can have a backtrace */
-#ifdef MEMDEBUG_HAVE_EXECINFO_H
-
 /**
- * Displays the backtrace (function call stack)
+ * Refreshes the whole shared memory statistics page
+ * 
+ * The lock of the memory records must be held.
  * 
  * @return  void
  */
-void memdebug_backtrace( unsigned int skip_levels )
+static void memdebug_stats_refresh( void )
 {
-    size_t size;
-    size_t i;
-    size_t j;
-    void ** trace;
-    char ** symbols;
-    char * symbol;
-    unsigned long int frame_num;
-    
-    /* Allocates enough memory for the backtrace informations */
-    if( NULL == ( trace = calloc( MEMDEBUG_BACKTRACE_SIZE + skip_levels, sizeof( void * ) ) ) )
-    {
-        memdebug_fatal
-        (
-            "MEMDebug error: cannot allocate memory for the backtrace. Reason: %s\n",
-            strerror( errno )
-        );
-    }
-    
-    /* Gets the backtrace */
-    size    = backtrace( trace, MEMDEBUG_BACKTRACE_SIZE + skip_levels );
+    unsigned int type;
+    unsigned int size_class;
+    unsigned long int i;
+    unsigned long int j;
+    unsigned long int count;
+    struct memdebug_site * site;
+    struct memdebug_stats * stats;
+    unsigned long int top[ MEMDEBUG_STATS_SITES ];
     
-    /* Gets the symbols for the backtrace */
-    symbols = backtrace_symbols( trace, size );
+    memdebug_arena_retire_all();
     
-    /* Header */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug - Backtrace\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-        "# \n"
-    );
+    stats                      = memdebug_publisher.stats;
+    memdebug_publisher.updates = 0;
     
-    /* Number of stack frames */
-    printf
-    (
-        "# Displaying %lu stack frames:\n"
-        "# \n",
-        ( unsigned long int )size - skip_levels
-    );
+    /* Selects the allocation sites with the most active memory (insertion in a short sorted array) */
+    count = 0;
     
-    /* Process each frame */
-    for( i = skip_levels; i < size; i++ )
+    for( i = 0; i < memdebug_sites.count; i++ )
     {
-        /* Current symbol */
-        symbol = symbols[ i ];
+        if( memdebug_sites.sites[ i ].live_size == 0 )
+        {
+            continue;
+        }
         
-        /* Process each character of the symbol string */
-        for( j = 0; j < strlen( symbol ); j++ )
+        for( j = count; j > 0 && memdebug_sites.sites[ top[ j - 1 ] ].live_size < memdebug_sites.sites[ i ].live_size; j-- )
         {
-            /* Checks if the frame number was passed, as we are going to rewrite it */
-            if( symbol[ j ] != ' ' && ( symbol[ j ] < 48 || symbol[ j ] > 57 ) )
+            if( j < MEMDEBUG_STATS_SITES )
             {
-                break;
+                top[ j ] = top[ j - 1 ];
             }
-            
-            /* Still on the frame number - Increments the pointer so we don't print it */
-            symbol++;
         }
         
-        /* Frame number of the symbol */
-        frame_num = ( unsigned long int )i - skip_levels;
-        
-        /* Checks the frame number, in order to get a clean outpout */
-        if( frame_num < 10 )
-        {
-            printf
-            (
-                "#     %lu:    %s\n",
-                frame_num,
-                ++symbol
-            );
-        }
-        else if( frame_num < 100 )
-        {
-            printf
-            (
-                "#     %lu:   %s\n",
-                frame_num,
-                ++symbol
-            );
-        }
-        else if( frame_num < 1000 )
-        {
-            printf
-            (
-                "#     %lu:  %s\n",
-                frame_num,
-                ++symbol
-            );
-        }
-        else if( frame_num < 10000 )
+        if( j < MEMDEBUG_STATS_SITES )
         {
-            printf
-            (
-                "#     %lu: %s\n",
-                frame_num,
-                ++symbol
-            );
+            top[ j ] = i;
+            count    = ( count < MEMDEBUG_STATS_SITES ) ? count + 1 : count;
         }
-        else
+    }
+    
+    /* Odd while the page is updated */
+    stats->sequence++;
+    
+    __sync_synchronize();
+    
+    for( size_class = 0; size_class < MEMDEBUG_SIZE_CLASSES; size_class++ )
+    {
+        stats->live[ size_class ]  = 0;
+        stats->total[ size_class ] = 0;
+        
+        for( type = 0; type < MEMDEBUG_ALLOC_TYPES; type++ )
         {
-            printf
-            (
-                "#     %lu:%s\n",
-                frame_num,
-                ++symbol
-            );
+            stats->live[ size_class ]  += memdebug_histograms.live[ type ][ size_class ];
+            stats->total[ size_class ] += memdebug_histograms.total[ type ][ size_class ];
         }
     }
     
-    /* Horizontal ruler */
-    printf
-    (
-        "# \n"
-        MEMDEBUG_HR
-    );
+    for( i = 0; i < count; i++ )
+    {
+        site = &memdebug_sites.sites[ top[ i ] ];
+        
+        strncpy( stats->sites[ i ].func, ( site->func == NULL ) ? "" : site->func, MEMDEBUG_STATS_NAME_SIZE - 1 );
+        strncpy( stats->sites[ i ].file, ( site->file == NULL ) ? "" : site->file, MEMDEBUG_STATS_NAME_SIZE - 1 );
+        
+        stats->sites[ i ].func[ MEMDEBUG_STATS_NAME_SIZE - 1 ] = 0;
+        stats->sites[ i ].file[ MEMDEBUG_STATS_NAME_SIZE - 1 ] = 0;
+        stats->sites[ i ].line        = site->line;
+        stats->sites[ i ].live_count  = site->live_count;
+        stats->sites[ i ].live_size   = ( unsigned long int )site->live_size;
+        stats->sites[ i ].total_count = site->total_count;
+        stats->sites[ i ].total_size  = ( unsigned long int )site->total_size;
+    }
     
-    /* Frees the allocated memory for the backtrace and the backtrace symbols */
-    free( trace );
-    free( symbols );
+    stats->num_sites = count;
+    
+    __sync_synchronize();
+    
+    stats->sequence++;
+    
+    /* The counters */
+    memdebug_stats_update();
 }
 
-#endif
-
 /**
- * Asks for a debug command
+ * Creates a detached helper thread, which does not take the signals of the program
  * 
- * @return void
+ * The signals of the errors (handled by the thread causing them), and the
+ * signal stopping the threads during a leak check, are not blocked.
+ * 
+ * @param   pthread_t *                 The thread
+ * @param   void * ( * )( void * )      The main function of the thread
+ * @return  int                         0 on success, or an error number
  */
-static void memdebug_ask_debug_cmd( void )
+static int memdebug_create_thread( pthread_t * thread, void * ( * start )( void * ) )
 {
-    char c;
-    static unsigned int skip_levels = 3;
+    sigset_t signals;
+    sigset_t saved;
+    int error;
     
-    printf
-    (
-       "# \n"
-       "# Your choices are:\n"
-       "# \n"
-       "#     - c : Default: continue the program execution\n"
-       "#     - q : Abort the program execution\n"
-       "#     - s : Display the status of the memory allocations\n"
-   );
+    sigfillset( &signals );
+    sigdelset( &signals, SIGSEGV );
+    sigdelset( &signals, SIGBUS );
     
-    /* Checks if we can have a backtrace */
-    #ifdef MEMDEBUG_HAVE_EXECINFO_H
-    printf
-    (
-        "#     - t : Display the backtrace (function call stack)\n"
-    );
-    #endif
+    /* Checks if the leak scanner can stop the other threads */
+    #ifdef MEMDEBUG_HAVE_LEAK_SCANNER
     
-    printf
-    (
-        "#     - p : Display all memory records (active and free)\n"
-        "#     - a : Display only the active memory records\n"
-        "#     - f : Display only the freed memory records\n"
-        "# \n"
-        MEMDEBUG_HR
-        "\n"
-        "Choice: "
-    );
+    sigdelset( &signals, MEMDEBUG_LEAK_SIGNAL );
     
-    /* Reads a character from STDIN to know what to do */
-    fflush( stdin );
-    c = getchar();
+    #endif
     
-    /* Checks if the user choosed a command */
-    if( c == '\n' )
-    {
-        /* Default - continues the program execution */
-        return;
-    }
+    /* The new thread inherits the signal mask */
+    pthread_sigmask( SIG_SETMASK, &signals, &saved );
     
-    /* Don't not about the next characters */
-    while( getchar() != '\n' ) {}
+    error = pthread_create( thread, NULL, start, NULL );
     
-    /* Checks if the user answer */
-    if( c == 's' || c == 'S' )
+    pthread_sigmask( SIG_SETMASK, &saved, NULL );
+    
+    if( error == 0 )
     {
-        /* Prints the memory allocation status */
-        printf( "\n" );
-        memdebug_print_status();
-        
+        pthread_detach( *( thread ) );
     }
     
-    /* Checks if we can have a backtrace */
-    #ifdef MEMDEBUG_HAVE_EXECINFO_H
+    return error;
+}
+
+/**
+ * Gets the number of a signal, from its name (like "USR1" or "SIGUSR1") or its number
+ * 
+ * @param   const char *    The name or the number of the signal
+ * @return  int             The number of the signal, or 0 if invalid
+ */
+static int memdebug_signal_number( const char * name )
+{
+    char * end;
+    long number;
     
-    else if( c == 't' || c == 'T' )
+    if( strncmp( name, "SIG", 3 ) == 0 )
     {
-        /* Prints the function call stack */
-        printf( "\n" );
-        memdebug_backtrace( skip_levels );
+        name += 3;
     }
     
-    #endif
-    
-    else if( c == 'p' || c == 'P' )
+    if( strcmp( name, "USR1" ) == 0 )
     {
-        /* Prints all allocated objects */
-        printf( "\n" );
-        memdebug_print_objects();
+        return SIGUSR1;
     }
-    else if( c == 'a' || c == 'A' )
+    else if( strcmp( name, "USR2" ) == 0 )
     {
-        /* Prints all active objects */
-        printf( "\n" );
-        memdebug_print_active();
+        return SIGUSR2;
     }
-    else if( c == 'f' || c == 'F' )
+    else if( strcmp( name, "HUP" ) == 0 )
     {
-        /* Prints all freed objects */
-        printf( "\n" );
-        memdebug_print_free();
+        return SIGHUP;
     }
-    else if( c == 'q' || c == 'Q' )
+    
+    number = strtol( name, &end, 0 );
+    
+    if( *( name ) == 0 || *( end ) != 0 || number <= 0 || number >= NSIG || number == SIGKILL || number == SIGSTOP || number == SIGSEGV || number == SIGBUS )
     {
-        /* Aborts the program execution */
-        printf
-        (
-            "\n"
-            "Program execution stopped\n"
-        );
-        exit( EXIT_FAILURE );
+        return 0;
+    }
+    
+    return ( int )number;
+}
+
+/**
+ * Starts the thread writing the dumps of the active memory records, and handles the dump signal
+ * 
+ * @return  void
+ */
+static void memdebug_dumper_start( void )
+{
+    struct sigaction sa;
+    
+    if( pipe( memdebug_dumper.pipe ) != 0 )
+    {
+        fprintf( memdebug_output, "MEMDebug: cannot handle the dump signal. Reason: %s\n", strerror( errno ) );
+        return;
     }
-    else
+    
+    /* The signal handler must never block */
+    fcntl( memdebug_dumper.pipe[ 0 ], F_SETFD, FD_CLOEXEC );
+    fcntl( memdebug_dumper.pipe[ 1 ], F_SETFD, FD_CLOEXEC );
+    fcntl( memdebug_dumper.pipe[ 1 ], F_SETFL, fcntl( memdebug_dumper.pipe[ 1 ], F_GETFL ) | O_NONBLOCK );
+    
+    if( memdebug_create_thread( &memdebug_dumper.thread, memdebug_dumper_main ) != 0 )
     {
-        /* Default - continues the program execution */
+        fprintf( memdebug_output, "MEMDebug: cannot handle the dump signal. Reason: cannot create the thread\n" );
+        
+        close( memdebug_dumper.pipe[ 0 ] );
+        close( memdebug_dumper.pipe[ 1 ] );
+        
         return;
     }
     
-    skip_levels++;
+    /* The interrupted system calls of the program are restarted */
+    sa.sa_handler = memdebug_dumper_handler;
+    sa.sa_flags   = SA_RESTART;
+    sigemptyset( &sa.sa_mask );
     
-    /* Asks for a command again */
-    memdebug_ask_debug_cmd();
+    if( sigaction( memdebug_config.dump_signal, &sa, NULL ) != 0 )
+    {
+        fprintf( memdebug_output, "MEMDebug: cannot handle the dump signal. Reason: %s\n", strerror( errno ) );
+    }
 }
 
 /**
- * Handles signals (SIGSEGV and SIGBUS)
+ * Handler of the dump signal - Only wakes the dump thread up
  * 
- * @param   int     The ID of the signal
+ * @param   int     The signal number
  * @return  void
  */
-static void memdebug_sig_handler( int id )
+static void memdebug_dumper_handler( int id )
 {
-    /* Checks the signal ID */
-    if( id == SIGSEGV || id == SIGBUS )
+    int error;
+    char c;
+    
+    ( void )id;
+    
+    error                     = errno;
+    c                         = 0;
+    memdebug_dumper.requested = 1;
+    
+    /* A full pipe means that the thread is already awake */
+    if( write( memdebug_dumper.pipe[ 1 ], &c, 1 ) < 0 ) {}
+    
+    errno = error;
+}
+
+/**
+ * Main function of the dump thread - Writes a dump each time the signal is received
+ * 
+ * @param   void *  Unused
+ * @return  void *  NULL
+ */
+static void * memdebug_dumper_main( void * data )
+{
+    char buffer[ 64 ];
+    ssize_t length;
+    
+    ( void )data;
+    
+    for( ;; )
     {
-        if( id == SIGSEGV )
-        {
-            /* Segmentation fault */
-            printf
-            (
-                MEMDEBUG_HR
-                "# MEMDebug: SIGSEGV\n"
-                MEMDEBUG_REV
-                MEMDEBUG_HR
-                "# \n"
-                "# A segmentation fault was detected.\n"
-            );
-        }
-        else
+        length = read( memdebug_dumper.pipe[ 0 ], buffer, sizeof( buffer ) );
+        
+        if( length < 0 && errno == EINTR )
         {
-            /* Bus error */
-            printf
-            (
-                MEMDEBUG_HR
-                "# MEMDebug: SIGBUS\n"
-                MEMDEBUG_REV
-                MEMDEBUG_HR
-                "# \n"
-                "# A bus error was detected.\n"
-                "Choice: "
-            );
+            continue;
         }
         
-        /* Asks for a debug command */
-        memdebug_ask_debug_cmd();
-        
-        /* Checks the signal ID */
-        if( id == SIGSEGV )
+        if( length <= 0 )
         {
-            /* Segmentation fault */
-            printf
-            (
-                "\n"
-                "SIGSEGV - Segmentation fault\n"
-                "Program execution stopped\n"
-            );
+            break;
         }
-        else
+        
+        /* Several signals received during a dump only lead to one more dump */
+        if( memdebug_dumper.requested != 0 )
         {
-            /* Bus error */
-            printf
-            (
-                "\n"
-                "SIGBUS - Bus error\n"
-                "Program execution stopped\n"
-            );
+            memdebug_dumper.requested = 0;
+            
+            memdebug_dumper_write();
         }
-        
-        /* Aborts the program execution */
-        exit( EXIT_FAILURE );
     }
+    
+    return NULL;
 }
 
 /**
- * Issues a warning
+ * Writes the active memory records to a timestamped file, as JSON Lines
+ * 
+ * The file is named memdebug-<pid>-<date>-<time>.<milliseconds>.jsonl, in
+ * the directory of the dump_dir option. The active records are copied to
+ * the metadata arena, so the program is only blocked during the copy, and
+ * not while the file is written.
  * 
- * @param   const char *    The warning message
- * @param   const char *    The file concerned by the warning
- * @param   const int       The line number concerned by the warning
- * @param   const char *    The function concerned by the warning
- * @param   ...             The parameters for the warning message, if any
  * @return  void
  */
-static void memdebug_warning( const char * str, const char * file, const int line, const char * func, ... )
+static void memdebug_dumper_write( void )
 {
-    va_list ap;
+    int fd;
+    unsigned long int i;
+    unsigned long int count;
+    unsigned long int num_active;
+    struct memdebug_object * objects;
+    unsigned long int * records;
+    struct timeval now;
+    struct tm date;
+    time_t seconds;
+    char timestamp[ 32 ];
+    char path[ 512 ];
     
-    /* Gets the variable arguments */
-    va_start( ap, func );
+    gettimeofday( &now, NULL );
     
-    /* Issues the warning message */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug: WARNING\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-        "# \n"
-        "# "
-    );
-    vprintf( str, ap );
-    printf
-    (
-        "\n"
-        "# \n"
-        "# Function:    %s()\n"
-        "# File:        %s\n"
-        "# Line:        %i\n",
-        func,
-        file,
-        line
-    );
+    seconds = now.tv_sec;
     
-    /* Cleanup */
-    va_end( ap );
+    localtime_r( &seconds, &date );
+    strftime( timestamp, sizeof( timestamp ), "%Y%m%d-%H%M%S", &date );
+    snprintf( path, sizeof( path ), "%s/memdebug-%li-%s.%03li.jsonl", memdebug_config.dump_dir, ( long )getpid(), timestamp, ( long )( now.tv_usec / 1000 ) );
     
-    /* Asks for a debug command */
-    memdebug_ask_debug_cmd();
+    /* The dump may be written by a child process */
+    if( memdebug_report_fork() == MEMDEBUG_TRUE )
+    {
+        return;
+    }
+    
+    if( ( fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) == -1 )
+    {
+        MEMDEBUG_LOCK;
+        fprintf( memdebug_output, "MEMDebug: cannot open the file '%s'. Reason: %s\n", path, strerror( errno ) );
+        fflush( memdebug_output );
+        MEMDEBUG_UNLOCK;
+        memdebug_report_end();
+        
+        return;
+    }
+    
+    /* The active records are copied under the lock, and written once the lock is released */
+    MEMDEBUG_LOCK;
+    
+    memdebug_arena_retire_all();
+    
+    num_active = memdebug_trace->num_active;
+    objects    = ( struct memdebug_object * )memdebug_meta_alloc( ( num_active + 1 ) * sizeof( struct memdebug_object ) );
+    records    = ( unsigned long int * )memdebug_meta_alloc( ( num_active + 1 ) * sizeof( unsigned long int ) );
+    count      = 0;
+    
+    for( i = 0; i < memdebug_trace->num_objects && count < num_active; i++ )
+    {
+        if( memdebug_trace->objects[ i ].free == MEMDEBUG_FALSE )
+        {
+            objects[ count ] = memdebug_trace->objects[ i ];
+            records[ count ] = memdebug_archive.dropped + memdebug_archive.count + i + 1;
+            
+            count++;
+        }
+    }
+    
+    MEMDEBUG_UNLOCK;
+    
+    memdebug_writer_init( &memdebug_dumper_writer, fd );
+    
+    for( i = 0; i < count; i++ )
+    {
+        memdebug_export_object( &memdebug_dumper_writer, &objects[ i ], records[ i ], MEMDEBUG_EXPORT_JSON );
+    }
+    
+    memdebug_writer_flush( &memdebug_dumper_writer );
+    
+    memdebug_meta_free( objects );
+    memdebug_meta_free( records );
+    
+    MEMDEBUG_LOCK;
+    fprintf( memdebug_output, "MEMDebug: %lu active memory records written to '%s'\n", count, path );
+    fflush( memdebug_output );
+    MEMDEBUG_UNLOCK;
+    
+    close( fd );
+    memdebug_report_end();
 }
 
 /**
- * Prints informations about an allocated object
+ * Forks a child process to write a report (fork_reports option)
  * 
- * @param   struct memdebug_object *    The allocated object
- * @return  void
+ * The child works on a copy-on-write image of the memory records, so the
+ * program only waits for the fork. The child forks again and exits at
+ * once, so the program never has to reap the process writing the report.
+ * If a fork fails, the report is written by the current process.
+ * 
+ * @return  memdebug_bool   MEMDEBUG_TRUE in the program, if the report is written by a child process, otherwise MEMDEBUG_FALSE
  */
-static void memdebug_print_object( struct memdebug_object * object )
+static memdebug_bool memdebug_report_fork( void )
 {
-    /* Pointer address and size */
-    printf
-    (
-        "# \n"
-        "# - Address:                 %p\n"
-        "# - Size:                    %lu\n",
-        object->ptr,
-        ( unsigned long int )object->size
-    );
+    pid_t pid;
+    int status;
+    pthread_mutexattr_t attributes;
     
-    /* Checks the allocation type */
-    switch( object->alloc_type )
+    if( memdebug_config.fork_reports == MEMDEBUG_FALSE || memdebug_report_child == MEMDEBUG_TRUE )
     {
-        /* malloc */
-        case MEMDEBUG_ALLOC_TYPE_MALLOC:
-            
-            printf( "# - Allocation type:         malloc\n" );
-            break;
-            
-        /* calloc */
-        case MEMDEBUG_ALLOC_TYPE_CALLOC:
-            
-            printf( "# - Allocation type:         calloc\n" );
-            break;
-            
-        /* realloc */
-        case MEMDEBUG_ALLOC_TYPE_REALLOC:
-            
-            printf( "# - Allocation type:         realloc\n" );
-            break;
-            
-        /* alloca */
-        case MEMDEBUG_ALLOC_TYPE_ALLOCA_FUNC:
-            
-            printf( "# - Allocation type:         alloca\n" );
-            break;
-            
-        /* __builtin_alloca */
-        case MEMDEBUG_ALLOC_TYPE_ALLOCA_BUILTIN:
-            
-            printf( "# - Allocation type:         alloca (built-in)\n" );
-            break;
-            
-        /* gc_malloc */
-        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC:
-            
-            printf( "# - Allocation type:         malloc (GC)\n" );
-            break;
-            
-        /* gc_malloc_atomic */
-        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_MALLOC_ATOMIC:
-            
-            printf( "# - Allocation type:         atomic malloc (GC)\n" );
-            break;
-            
-        /* gc_calloc */
-        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_CALLOC:
-            
-            printf( "# - Allocation type:         calloc (GC)\n" );
-            break;
-            
-        /* gc_realloc */
-        case MEMDEBUG_ALLOC_TYPE_OBJC_GC_REALLOC:
-            
-            printf( "# - Allocation type:         realloc (GC)\n" );
-            break;
-            
-        /* malloc_zone_malloc */
-        case MEMDEBUG_ALLOC_TYPE_ZONE_MALLOC:
-            
-            printf( "# - Allocation type:         zone malloc\n" );
-            break;
-            
-        /* malloc_zone_calloc */
-        case MEMDEBUG_ALLOC_TYPE_ZONE_CALLOC:
-            
-            printf( "# - Allocation type:         zone calloc\n" );
-            break;
-            
-        /* malloc_zone_valloc */
-        case MEMDEBUG_ALLOC_TYPE_ZONE_VALLOC:
-            
-            printf( "# - Allocation type:         zone valloc\n" );
-            break;
-            
-        /* malloc_zone_realloc */
-        case MEMDEBUG_ALLOC_TYPE_ZONE_REALLOC:
-            
-            printf( "# - Allocation type:         zone realloc\n" );
-            break;
-            
-        /* Unknown type */
-        default:
-            
-            printf( "# - Allocation type:         <unknown>\n" );
-            break;
+        return MEMDEBUG_FALSE;
     }
     
-    /* Allocation nformations */
-    printf
-    (
-        "# \n"
-        "# - Allocated in function:   %s()"
-        #ifdef __GNUC__
-        " - %p"
-        #endif
-        "\n"
-        "# - Allocated in file:       %s\n"
-        "# - Allocated at line:       %i\n"
-        "# \n",
-        object->alloc_func,
-        #ifdef __GNUC__
-        object->alloc_func_addr,
-        #endif
-        object->alloc_file,
-        object->alloc_line
-    );
+    /* The memory records are copied in a consistent state, and the output buffer is not copied */
+    MEMDEBUG_LOCK;
     
-    /* Checks if the object was freed */
-    if( object->free == MEMDEBUG_TRUE )
+    fflush( memdebug_output );
+    
+    if( ( pid = fork() ) == -1 )
     {
-        /* Checks if the object is automatically freed */
-        if( object->alloc_type & MEMDEBUG_ALLOC_TYPE_ALLOCA || object->alloc_type & MEMDEBUG_ALLOC_TYPE_OBJC_GC )
-        {
-            /* Free informations not available */
-            printf
-            (
-                "# - Freed:                   auto\n"
-                "# \n"
-            );
-        }
-        else
-        {
-            /* Free informations */
-            printf
-            (
-                "# - Freed:                   yes\n"
-                "# - Freed in function:       %s()"
-                #ifdef __GNUC__
-                " - %p"
-                #endif
-                "\n"
-                "# - Freed in file:           %s\n"
-                "# - Freed at line:           %i\n"
-                "# \n",
-                object->free_func,
-                #ifdef __GNUC__
-                object->free_func_addr,
-                #endif
-                object->free_file,
-                object->free_line
-            );
-        }
+        MEMDEBUG_UNLOCK;
+        
+        return MEMDEBUG_FALSE;
     }
-    else
+    
+    if( pid == 0 )
     {
-        /* No free information */
-        printf
-        (
-            "# - Freed:                   no\n"
-            "# \n"
-            "# - Memory dump:\n"
-            "# \n"
-        );
+        /* The intermediate child exits at once (the grandchild is reparented) */
+        if( ( pid = fork() ) > 0 )
+        {
+            _exit( EXIT_SUCCESS );
+        }
         
-        /* Dumps the actual data */
-        memdebug_dump( object );
-        printf( "# \n" );
+        /* The lock belongs to a thread which does not exist in the child process */
+        pthread_mutexattr_init( &attributes );
+        pthread_mutexattr_settype( &attributes, PTHREAD_MUTEX_RECURSIVE );
+        pthread_mutex_init( &memdebug_lock, &attributes );
+        pthread_mutexattr_destroy( &attributes );
+        
+        /* Without a grandchild, the intermediate child writes the report, and the program waits for it */
+        memdebug_report_child = MEMDEBUG_TRUE;
+        
+        return MEMDEBUG_FALSE;
     }
     
-    /* Prints a separator */
-    printf
-    (
-        MEMDEBUG_HR
-    );
+    MEMDEBUG_UNLOCK;
+    
+    while( waitpid( pid, &status, 0 ) == -1 && errno == EINTR );
+    
+    return MEMDEBUG_TRUE;
 }
 
 /**
- * Prints the status of the memory allocations
+ * Ends a report - The child process writing it exits (see memdebug_report_fork())
+ * 
+ * The exit handlers of the program are not called by the child process.
  * 
  * @return  void
  */
-void memdebug_print_status( void )
+static void memdebug_report_end( void )
 {
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    if( memdebug_report_child == MEMDEBUG_FALSE )
+    {
+        return;
+    }
     
-    /* Prints the allocation status */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug - Status\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-    );
-    printf
-    (
-        "# \n"
-        "# - Total allocated objects:               %lu\n"
-        "# - Number of non-freed objects:           %lu\n"
-        "# - Number of freed objects:               %lu\n"
-        "# - Number of automatically-freed objects: %lu\n",
-        memdebug_trace->num_objects,
-        memdebug_trace->num_active,
-        memdebug_trace->num_free,
-        memdebug_trace->num_auto
-    );
-    printf
-    (
-        "# \n"
-        "# - Total memory:                          %lu\n"
-        "# - Active memory:                         %lu\n"
-        "# \n"
-        MEMDEBUG_HR,
-        memdebug_trace->memory_total,
-        memdebug_trace->memory_active
-    );
+    fflush( memdebug_output );
+    _exit( EXIT_SUCCESS );
 }
 
 /**
- * Prints informations about the allocated objects (active and free)
+ * Starts or stops the capture of the allocation sequence
  * 
- * @return  void
+ * Each call to malloc(), calloc(), valloc(), realloc() and free() is
+ * appended to the file, as a CSV line:
+ * 
+ *      op,thread,ticks,address,size,new_address
+ * 
+ * The threads are numbered from 1, in the order of their first operation,
+ * and the ticks are those of the clock of the lifetimes (CPU cycles on x86,
+ * nanoseconds otherwise), since the initialization of MEMDebug. The file is
+ * replayed by the memdebug-replay program. The lines are buffered, and
+ * written when the buffer is full, when the capture stops, and when the
+ * program exits.
+ * 
+ * @param   const char *    The path of the capture file (truncated), or NULL to stop the capture
+ * @return  int             0 on success, -1 on failure (errno is set)
  */
-void memdebug_print_objects( void )
+int memdebug_capture( const char * path )
 {
-    unsigned long int i;
+    int fd;
+    struct memdebug_writer * writer;
     
-    /* Initialization check */
     MEMDEBUG_INIT_CHECK;
     
-    /* Header */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug - Allocated objects\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-    );
+    MEMDEBUG_LOCK;
     
-    /* Checks if objects were allocated */
-    if( memdebug_trace->num_objects == 0 )
+    /* Stops the current capture */
+    if( NULL != ( writer = memdebug_capturer.writer ) )
     {
-        /* No allocated objects */
-        printf
-        (
-            "# No objects were allocated\n"
-            MEMDEBUG_HR
-        );
+        memdebug_capturer.writer = NULL;
+        
+        memdebug_writer_flush( writer );
+        close( writer->fd );
+        memdebug_meta_free( writer );
     }
-    else
+    
+    memdebug_fast_update();
+    
+    if( path == NULL )
     {
-        /* Process each allocated object */
-        for( i = 0; i < memdebug_trace->num_objects; i++ )
+        MEMDEBUG_UNLOCK;
+        
+        return 0;
+    }
+    
+    if( ( fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 ) ) == -1 )
+    {
+        MEMDEBUG_UNLOCK;
+        
+        return -1;
+    }
+    
+    fcntl( fd, F_SETFD, FD_CLOEXEC );
+    
+    if( memdebug_capturer.has_key == MEMDEBUG_FALSE )
+    {
+        if( pthread_key_create( &memdebug_capturer.thread_key, NULL ) != 0 )
         {
-            /* Prints information about the current object */
-            printf
-            (
-                "# \n"
-                "# - Memory record:           #%lu\n",
-                i + 1
-            );
-            memdebug_print_object( &memdebug_trace->objects[ i ] );
+            close( fd );
+            
+            MEMDEBUG_UNLOCK;
+            
+            errno = EAGAIN;
+            
+            return -1;
         }
+        
+        memdebug_capturer.has_key = MEMDEBUG_TRUE;
+        
+        atexit( memdebug_capture_atexit );
     }
+    
+    writer = ( struct memdebug_writer * )memdebug_meta_alloc( sizeof( struct memdebug_writer ) );
+    
+    memdebug_writer_init( writer, fd );
+    MEMDEBUG_WRITER_LITERAL( writer, "op,thread,ticks,address,size,new_address\n" );
+    
+    memdebug_capturer.count  = 0;
+    memdebug_capturer.writer = writer;
+    
+    memdebug_fast_update();
+    
+    MEMDEBUG_UNLOCK;
+    
+    return 0;
 }
 
 /**
- * Prints informations about the freed objects
+ * Appends an operation to the capture file
  * 
+ * @param   const char *    The operation (malloc, calloc, valloc, realloc or free)
+ * @param   void *          The address of the memory area
+ * @param   void *          The new address of the memory area (realloc only)
+ * @param   size_t          The size of the memory area (0 for free)
  * @return  void
  */
-void memdebug_print_free( void )
+static void memdebug_capture_op( const char * op, void * ptr, void * ptr_new, size_t size )
 {
-    unsigned long int i;
+    unsigned long int thread;
+    unsigned long long ticks;
+    void * key;
+    struct memdebug_writer * writer;
     
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    ticks = memdebug_ticks() - memdebug_clock.ticks;
     
-    /* Header */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug - Freed objects\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-    );
+    MEMDEBUG_LOCK;
     
-    /* Checks if objects were freed */
-    if( memdebug_trace->num_free == 0 )
+    /* The capture may have stopped since the check of the caller */
+    if( NULL == ( writer = memdebug_capturer.writer ) )
     {
-        /* No freed object */
-        printf
-        (
-            "# No objects were freed\n"
-            MEMDEBUG_HR
-        );
+        MEMDEBUG_UNLOCK;
+        
+        return;
+    }
+    
+    /* Numbers the thread on its first operation */
+    if( NULL == ( key = pthread_getspecific( memdebug_capturer.thread_key ) ) )
+    {
+        thread = ++memdebug_capturer.num_threads;
+        
+        pthread_setspecific( memdebug_capturer.thread_key, ( void * )thread );
     }
     else
     {
-        /* Process each allocated object */
-        for( i = 0; i < memdebug_trace->num_objects; i++ )
-        {
-            /* Checks if the current object was freed */
-            if( memdebug_trace->objects[ i ].free == MEMDEBUG_TRUE )
-            {
-                /* Prints information about the current object */
-                printf
-                (
-                    "# \n"
-                    "# - Memory record:           #%lu\n",
-                    i + 1
-                );
-                memdebug_print_object( &memdebug_trace->objects[ i ] );
-            }
-        }
+        thread = ( unsigned long int )key;
+    }
+    
+    memdebug_writer_append( writer, op, strlen( op ) );
+    MEMDEBUG_WRITER_LITERAL( writer, "," );
+    memdebug_writer_append_ulong( writer, thread );
+    MEMDEBUG_WRITER_LITERAL( writer, "," );
+    memdebug_writer_append_ulong( writer, ( unsigned long int )ticks );
+    MEMDEBUG_WRITER_LITERAL( writer, "," );
+    memdebug_writer_append_pointer( writer, ptr );
+    MEMDEBUG_WRITER_LITERAL( writer, "," );
+    memdebug_writer_append_ulong( writer, ( unsigned long int )size );
+    MEMDEBUG_WRITER_LITERAL( writer, "," );
+    
+    if( ptr_new != NULL )
+    {
+        memdebug_writer_append_pointer( writer, ptr_new );
     }
+    
+    MEMDEBUG_WRITER_LITERAL( writer, "\n" );
+    
+    memdebug_capturer.count++;
+    
+    MEMDEBUG_UNLOCK;
 }
 
 /**
- * Prints informations about the active objects
+ * Writes the buffered operations of the capture when the program exits
  * 
  * @return  void
  */
-void memdebug_print_active( void )
+static void memdebug_capture_atexit( void )
 {
-    unsigned long int i;
+    MEMDEBUG_LOCK;
+    
+    if( memdebug_capturer.writer != NULL )
+    {
+        memdebug_writer_flush( memdebug_capturer.writer );
+    }
+    
+    MEMDEBUG_UNLOCK;
+}
+
+/**
+ * Gets the time spent inside MEMDebug, by internal phase
+ * 
+ * The phases are measured when the self_profile option is enabled:
+ * 
+ *  -   MEMDEBUG_SELF_INDEX:    the lookups and updates of the index of the active memory records
+ *  -   MEMDEBUG_SELF_FENCES:   the writes and checks of the fences
+ *  -   MEMDEBUG_SELF_RECORDS:  the creation and the updates of the memory records, without the other phases
+ *  -   MEMDEBUG_SELF_SITES:    the capture of the call site of the allocations
+ *  -   MEMDEBUG_SELF_REPORTS:  the warnings (without the wait for a debug command) and the exports
+ * 
+ * Each measure reads the clock twice, which costs a few tens of cycles
+ * on x86, so the shortest phases are overestimated.
+ * 
+ * @param   struct memdebug_self_stats *    The statistics
+ * @return  int                             1 if the self-profiling is enabled, otherwise 0 (the statistics are zeroed)
+ */
+int memdebug_self_stats( struct memdebug_self_stats * stats )
+{
+    unsigned int phase;
+    double tick_ns;
     
     /* Initialization check */
     MEMDEBUG_INIT_CHECK;
     
-    /* Header */
-    printf
-    (
-        MEMDEBUG_HR
-        "# MEMDebug - Active objects\n"
-        MEMDEBUG_REV
-        MEMDEBUG_HR
-    );
+    memset( stats, 0, sizeof( struct memdebug_self_stats ) );
     
-    /* Checks if objects are active */
-    if( memdebug_trace->num_active == 0 )
+    if( memdebug_config.self_profile == MEMDEBUG_FALSE )
     {
-        /* No active object */
-        printf
-        (
-            "# No objects are currently active\n"
-            MEMDEBUG_HR
-        );
+        return 0;
     }
-    else
+    
+    tick_ns = memdebug_tick_ns();
+    
+    for( phase = 0; phase < MEMDEBUG_SELF_PHASES; phase++ )
     {
-        /* Process each allocated object */
-        for( i = 0; i < memdebug_trace->num_objects; i++ )
-        { 
-            /* Checks if the current object is active */
-            if( memdebug_trace->objects[ i ].free == MEMDEBUG_FALSE )
-            {
-                /* Prints information about the current object */
-                printf
-                (
-                    "# \n"
-                    "# - Memory record:           #%lu\n",
-                    i + 1
-                );
-                memdebug_print_object( &memdebug_trace->objects[ i ] );
-            }
-        }
+        stats->calls[ phase ] = memdebug_self.calls[ phase ];
+        stats->ticks[ phase ] = memdebug_self.ticks[ phase ];
+        stats->ns[ phase ]    = ( double )memdebug_self.ticks[ phase ] * tick_ns;
     }
+    
+    return 1;
 }
 
 /**
- * Gets the number of allocated objects (active and freed)
+ * Accounts a measure of an internal phase (see MEMDEBUG_SELF_START() and MEMDEBUG_SELF_END())
  * 
- * @return  unsigned long int   The number of allocated objects
+ * The counters are updated atomically, as the fences may be checked
+ * without the lock of the memory records.
+ * 
+ * @param   unsigned int        The phase (MEMDEBUG_SELF_XXX)
+ * @param   unsigned long long  The ticks at the start of the measure
+ * @param   unsigned long long  The ticks of the nested phases, which are not accounted twice
+ * @return  void
  */
-unsigned long int memdebug_num_objects( void )
+static void memdebug_self_add( unsigned int phase, unsigned long long start, unsigned long long nested )
 {
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    unsigned long long ticks;
     
-    /* Returns the number of allocated objects */
-    return memdebug_trace->num_objects;
+    ticks = memdebug_ticks() - start;
+    ticks = ( ticks > nested ) ? ticks - nested : 0;
+    
+    __sync_fetch_and_add( &memdebug_self.calls[ phase ], 1 );
+    __sync_fetch_and_add( &memdebug_self.ticks[ phase ], ticks );
+    
+    if( phase != MEMDEBUG_SELF_RECORDS )
+    {
+        __sync_fetch_and_add( &memdebug_self.nested, ticks );
+    }
 }
 
 /**
- * Gets the number of freed objects
+ * Prints the time spent inside MEMDebug, by internal phase (self_profile option)
  * 
- * @return  unsigned long int   The number of freed objects
+ * @return  void
  */
-unsigned long int memdebug_num_free( void )
+static void memdebug_print_self_stats( void )
 {
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    unsigned int phase;
+    char total[ 32 ];
+    char average[ 32 ];
+    struct memdebug_self_stats stats;
+    static const char * names[ MEMDEBUG_SELF_PHASES ] =
+    {
+        "index",
+        "fences",
+        "records",
+        "call sites",
+        "reports"
+    };
+    
+    if( memdebug_self_stats( &stats ) == 0 )
+    {
+        return;
+    }
     
-    /* Returns the number of freed objects */
-    return memdebug_trace->num_free;
+    fprintf
+    (
+        memdebug_output,
+        "# \n"
+    );
+    
+    for( phase = 0; phase < MEMDEBUG_SELF_PHASES; phase++ )
+    {
+        memdebug_format_duration( stats.ns[ phase ], total, sizeof( total ) );
+        memdebug_format_duration( ( stats.calls[ phase ] == 0 ) ? 0 : stats.ns[ phase ] / ( double )stats.calls[ phase ], average, sizeof( average ) );
+        
+        fprintf
+        (
+            memdebug_output,
+            "# - Time inside MEMDebug (%s):%*s%s in %lu calls (%s per call)\n",
+            names[ phase ],
+            ( int )( 15 - strlen( names[ phase ] ) ),
+            "",
+            total,
+            stats.calls[ phase ],
+            average
+        );
+    }
 }
 
 /**
- * Gets the number of active objects
+ * Enables or disables the inline fast path of the header (see memdebug_fast_malloc())
  * 
- * @return  unsigned long int   The number of active objects
+ * The fast path only handles the memory areas skipped by the sampling, so
+ * it is disabled without sampling, and while the allocations are captured,
+ * as each of them must then be written to the capture file.
+ * 
+ * @return  void
  */
-unsigned long int memdebug_num_active( void )
+static void memdebug_fast_update( void )
 {
-    /* Initialization check */
-    MEMDEBUG_INIT_CHECK;
+    memdebug_fast_ready =
+    (
+           memdebug_config.enabled == MEMDEBUG_TRUE
+        && memdebug_config.sample_rate > 1
+        && memdebug_capturer.writer == NULL
+    ) ? 1 : 0;
+}
+
+/**
+ * Adds the allocations skipped by the inline fast path of the calling thread to the status
+ * 
+ * The other threads add theirs with their next recorded allocation, or when
+ * they exit, so the number of non-sampled allocations may lag by up to the
+ * sampling rate for each running thread.
+ * 
+ * @return  void
+ */
+static void memdebug_sampling_flush( void )
+{
+    memdebug_trace->num_untracked += memdebug_sampling.untracked;
+    memdebug_sampling.untracked    = 0;
+}
+
+/**
+ * Destructor of the key of the sampling state - Adds the allocations skipped by the exiting thread to the status
+ * 
+ * @param   void *  The sampling state of the thread (unused, as it is still the current one)
+ * @return  void
+ */
+static void memdebug_sampling_exit( void * data )
+{
+    ( void )data;
     
-    /* Returns the number of active objects */
-    return memdebug_trace->num_active;
+    MEMDEBUG_LOCK;
+    
+    memdebug_sampling_flush();
+    
+    MEMDEBUG_UNLOCK;
 }
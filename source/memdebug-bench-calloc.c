@@ -0,0 +1,249 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+
+/* Includes the MEMDebug header (not activated, so the C library functions are also available) */
+#include "libmemdebug.h"
+
+/* The smallest measured size, in megabytes (above the dynamic mmap threshold of glibc) */
+#define BENCH_MIN_SIZE 64
+
+/* The number of repetitions of each measure (the best time is kept) */
+#define BENCH_RUNS 3
+
+/* The allocation methods */
+#define BENCH_LIBC      0
+#define BENCH_MEMDEBUG  1
+#define BENCH_MEMSET    2
+#define BENCH_METHODS   3
+
+/* The names of the allocation methods */
+static const char * bench_names[ BENCH_METHODS ] =
+{
+    "libc calloc",
+    "memdebug calloc",
+    "malloc + memset"
+};
+
+/**
+ * Returns the current time, in microseconds
+ * 
+ * @return  double  The current time
+ */
+static double bench_time( void )
+{
+    struct timeval tv;
+    
+    gettimeofday( &tv, NULL );
+    
+    return ( double )tv.tv_sec * 1000000.0 + ( double )tv.tv_usec;
+}
+
+/**
+ * Returns the resident set size of the process, in bytes
+ * 
+ * @return  long    The resident set size, or -1 if it is not available
+ */
+static long bench_rss( void )
+{
+    long pages;
+    FILE * fp;
+    
+    pages = -1;
+    
+    /* Only Linux gives the current resident set size */
+    if( NULL != ( fp = fopen( "/proc/self/statm", "r" ) ) )
+    {
+        if( fscanf( fp, "%*s %ld", &pages ) != 1 )
+        {
+            pages = -1;
+        }
+        
+        fclose( fp );
+    }
+    
+    return ( pages < 0 ) ? -1 : pages * sysconf( _SC_PAGESIZE );
+}
+
+/**
+ * Returns the number of minor page faults of the process
+ * 
+ * @return  long    The number of minor page faults
+ */
+static long bench_faults( void )
+{
+    struct rusage usage;
+    
+    getrusage( RUSAGE_SELF, &usage );
+    
+    return usage.ru_minflt;
+}
+
+/**
+ * Allocates a zeroed memory area
+ * 
+ * @param   int     The allocation method (BENCH_XXX)
+ * @param   size_t  The size of the memory area
+ * @return  void *  The memory area
+ */
+static void * bench_alloc( int method, size_t size )
+{
+    void * ptr;
+    
+    switch( method )
+    {
+        case BENCH_LIBC:
+            
+            return calloc( size, 1 );
+        
+        case BENCH_MEMDEBUG:
+            
+            return memdebug_calloc( size, 1, __FILE__, __LINE__, __func__ );
+        
+        default:
+            
+            /* The previous implementation of memdebug_calloc() */
+            if( NULL != ( ptr = memdebug_malloc( size, __FILE__, __LINE__, __func__ ) ) )
+            {
+                memset( ptr, 0, size );
+            }
+            
+            return ptr;
+    }
+}
+
+/**
+ * Frees a memory area allocated by bench_alloc()
+ * 
+ * @param   int     The allocation method (BENCH_XXX)
+ * @param   void *  The memory area
+ * @return  void
+ */
+static void bench_free( int method, void * ptr )
+{
+    if( method == BENCH_LIBC )
+    {
+        free( ptr );
+    }
+    else
+    {
+        memdebug_free( ptr, __FILE__, __LINE__, __func__ );
+    }
+}
+
+/**
+ * C main function
+ * 
+ * Allocates large zeroed memory areas with the C library, with MEMDebug,
+ * and with malloc() plus memset(), and measures the duration of the
+ * allocation, and the growth of the resident set size and the page faults
+ * it causes. Areas whose pages are not touched stay mostly out of the RSS.
+ * 
+ * Usage: memdebug-bench-calloc [maximum size in megabytes]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    unsigned long int max_size;
+    unsigned long int size;
+    unsigned int run;
+    int method;
+    double start;
+    double time;
+    double best;
+    long rss;
+    long faults;
+    void * ptr;
+    
+    max_size = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 0 ) : 256;
+    
+    if( max_size < BENCH_MIN_SIZE )
+    {
+        fprintf( stderr, "Usage: %s [maximum size in megabytes, at least %i]\n", argv[ 0 ], BENCH_MIN_SIZE );
+        return EXIT_FAILURE;
+    }
+    
+    /* The reports are not needed */
+    setenv( "MEMDEBUG_OPTIONS", "output=/dev/null", 1 );
+    
+    printf( "%10s %-16s %12s %12s %12s\n", "size (MB)", "method", "time (ms)", "RSS (MB)", "faults" );
+    
+    for( size = BENCH_MIN_SIZE; size <= max_size; size *= 2 )
+    {
+        for( method = 0; method < BENCH_METHODS; method++ )
+        {
+            best   = 0;
+            rss    = 0;
+            faults = 0;
+            
+            for( run = 0; run < BENCH_RUNS; run++ )
+            {
+                rss    = bench_rss();
+                faults = bench_faults();
+                start  = bench_time();
+                
+                if( NULL == ( ptr = bench_alloc( method, size * 1024 * 1024 ) ) )
+                {
+                    fprintf( stderr, "Cannot allocate %lu megabytes\n", size );
+                    return EXIT_FAILURE;
+                }
+                
+                time   = bench_time() - start;
+                best   = ( run == 0 || time < best ) ? time : best;
+                rss    = ( rss < 0 ) ? -1 : bench_rss() - rss;
+                faults = bench_faults() - faults;
+                
+                bench_free( method, ptr );
+            }
+            
+            if( rss < 0 )
+            {
+                printf( "%10lu %-16s %12.3f %12s %12ld\n", size, bench_names[ method ], best / 1000.0, "-", faults );
+            }
+            else
+            {
+                printf( "%10lu %-16s %12.3f %12.1f %12ld\n", size, bench_names[ method ], best / 1000.0, ( double )rss / ( 1024.0 * 1024.0 ), faults );
+            }
+        }
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/time.h>
+
+/* Activates MEMDebug */
+#define MEMDEBUG 1
+
+/* Includes the MEMDebug header */
+#include "libmemdebug.h"
+
+/* The number of children of each node of the benchmark heap */
+#define BENCH_CHILDREN 8
+
+/* The number of repetitions of each measure (the best time is kept) */
+#define BENCH_RUNS 3
+
+/* A node of the benchmark heap */
+struct bench_node
+{
+    struct bench_node * children[ BENCH_CHILDREN ];
+    unsigned long int payload[ 8 ];
+};
+
+/* The root of the benchmark heap, so it is reachable from the data segment (volatile, so the store is kept) */
+static struct bench_node * volatile bench_root;
+
+/**
+ * Returns the current time, in microseconds
+ * 
+ * @return  double  The current time
+ */
+static double bench_time( void )
+{
+    struct timeval tv;
+    
+    gettimeofday( &tv, NULL );
+    
+    return ( double )tv.tv_sec * 1000000.0 + ( double )tv.tv_usec;
+}
+
+/**
+ * C main function
+ * 
+ * Builds a tree of memory areas reachable from a global variable, plus a
+ * few leaked ones, and measures the duration of the leak check with an
+ * increasing number of threads for the mark phase.
+ * 
+ * Usage: memdebug-bench-leaks [number of nodes] [maximum number of threads]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    unsigned long int num_nodes;
+    unsigned long int i;
+    unsigned long int leaks;
+    unsigned int max_threads;
+    unsigned int threads;
+    unsigned int run;
+    double start;
+    double time;
+    double best;
+    double base;
+    struct bench_node ** nodes;
+    
+    num_nodes   = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 0 ) : 1000000;
+    max_threads = ( argc > 2 ) ? ( unsigned int )strtoul( argv[ 2 ], NULL, 0 ) : 8;
+    
+    if( num_nodes == 0 || max_threads == 0 )
+    {
+        fprintf( stderr, "Usage: %s [number of nodes] [maximum number of threads]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    
+    /* The reports are not needed, only the durations */
+    setenv( "MEMDEBUG_OPTIONS", "output=/dev/null", 1 );
+    
+    /* The index of the nodes is only used to build the tree, and is freed before the measures */
+    nodes = ( struct bench_node ** )calloc( num_nodes, sizeof( struct bench_node * ) );
+    
+    for( i = 0; i < num_nodes; i++ )
+    {
+        nodes[ i ] = ( struct bench_node * )calloc( 1, sizeof( struct bench_node ) );
+        
+        if( i > 0 )
+        {
+            nodes[ ( i - 1 ) / BENCH_CHILDREN ]->children[ ( i - 1 ) % BENCH_CHILDREN ] = nodes[ i ];
+        }
+    }
+    
+    bench_root = nodes[ 0 ];
+    
+    /* Leaks one node out of 1000, with its subtree */
+    for( i = num_nodes - 1; i > 0; i-- )
+    {
+        if( i % 1000 == 0 )
+        {
+            nodes[ ( i - 1 ) / BENCH_CHILDREN ]->children[ ( i - 1 ) % BENCH_CHILDREN ] = NULL;
+        }
+    }
+    
+    free( nodes );
+    
+    nodes = NULL;
+    leaks = 0;
+    base  = 0;
+    
+    printf( "Leak check of %lu memory areas\n\n", num_nodes );
+    printf( "%8s %14s %10s %10s\n", "threads", "time (ms)", "speedup", "leaks" );
+    
+    for( threads = 1; threads <= max_threads; threads *= 2 )
+    {
+        memdebug_set_leak_threads( threads );
+        
+        best = 0;
+        
+        for( run = 0; run < BENCH_RUNS; run++ )
+        {
+            start = bench_time();
+            leaks = memdebug_check_leaks();
+            time  = bench_time() - start;
+            best  = ( run == 0 || time < best ) ? time : best;
+        }
+        
+        base = ( threads == 1 ) ? best : base;
+        
+        printf( "%8u %14.3f %9.2fx %10lu\n", threads, best / 1000.0, base / best, leaks );
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,391 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+/* Includes the MEMDebug header (not activated, so the C library functions are also available) */
+#include "libmemdebug.h"
+
+/* The number of measured calls of each operation, for each thread */
+#define BENCH_CALLS 100000
+
+/* The maximum number of threads */
+#define BENCH_MAX_THREADS 64
+
+/* The size of the memory areas */
+#define BENCH_SIZE 64
+
+/* The allocation methods */
+#define BENCH_LIBC      0
+#define BENCH_CALL      1
+#define BENCH_INLINE    2
+#define BENCH_METHODS   3
+
+/* The measured operations */
+#define BENCH_MALLOC    0
+#define BENCH_REALLOC   1
+#define BENCH_FREE      2
+#define BENCH_OPS       3
+
+/* The names of the allocation methods */
+static const char * bench_methods[ BENCH_METHODS ] =
+{
+    "libc",
+    "call",
+    "inline"
+};
+
+/* The names of the measured operations */
+static const char * bench_ops[ BENCH_OPS ] =
+{
+    "malloc",
+    "realloc",
+    "free"
+};
+
+/* Structure for a benchmark thread */
+struct bench_thread
+{
+    /* The thread */
+    pthread_t thread;
+    
+    /* The allocation method (BENCH_XXX) */
+    int method;
+    
+    /* The measured ticks of each operation */
+    unsigned long long ticks[ BENCH_OPS ];
+};
+
+/**
+ * Returns the current value of the cycle counter (or a time, in nanoseconds, without one)
+ * 
+ * @return  unsigned long long  The current ticks
+ */
+static unsigned long long bench_ticks( void )
+{
+    /* Checks for the time-stamp counter */
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    
+    return __builtin_ia32_rdtsc();
+    
+    #else
+    
+    struct timeval now;
+    
+    gettimeofday( &now, NULL );
+    
+    return ( unsigned long long )now.tv_sec * 1000000000ULL + ( unsigned long long )now.tv_usec * 1000ULL;
+    
+    #endif
+}
+
+/* Checks if the inline fast path is available */
+#ifdef __GNUC__
+
+/* The fast path of the header */
+#define BENCH_FAST_MALLOC( size )       memdebug_fast_malloc( size, __FILE__, __LINE__, __func__ )
+#define BENCH_FAST_REALLOC( ptr, size ) memdebug_fast_realloc( ptr, size, __FILE__, __LINE__, __func__ )
+#define BENCH_FAST_FREE( ptr )          memdebug_fast_free( ptr, __FILE__, __LINE__, __func__ )
+
+#else
+
+/* No fast path - The same as the calls */
+#define BENCH_FAST_MALLOC( size )       memdebug_malloc( size, __FILE__, __LINE__, __func__ )
+#define BENCH_FAST_REALLOC( ptr, size ) memdebug_realloc( ptr, size, __FILE__, __LINE__, __func__ )
+#define BENCH_FAST_FREE( ptr )          memdebug_free( ptr, __FILE__, __LINE__, __func__ )
+
+#endif
+
+/**
+ * Measures each operation on BENCH_CALLS memory areas
+ * 
+ * The operations of each method are written in their own loop, so the
+ * inline fast path is inlined in the measured loop, as in a program built
+ * with MEMDEBUG defined.
+ * 
+ * @param   void *  The benchmark thread (struct bench_thread)
+ * @return  void *  NULL
+ */
+static void * bench_thread_main( void * data )
+{
+    unsigned long int i;
+    unsigned long long start;
+    struct bench_thread * thread;
+    void ** ptrs;
+    
+    thread = ( struct bench_thread * )data;
+    
+    if( NULL == ( ptrs = ( void ** )malloc( BENCH_CALLS * sizeof( void * ) ) ) )
+    {
+        fprintf( stderr, "Cannot allocate the benchmark areas\n" );
+        exit( EXIT_FAILURE );
+    }
+    
+    start = bench_ticks();
+    
+    switch( thread->method )
+    {
+        case BENCH_LIBC:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = malloc( BENCH_SIZE );
+            }
+            
+            break;
+        
+        case BENCH_CALL:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = memdebug_malloc( BENCH_SIZE, __FILE__, __LINE__, __func__ );
+            }
+            
+            break;
+        
+        default:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = BENCH_FAST_MALLOC( BENCH_SIZE );
+            }
+            
+            break;
+    }
+    
+    thread->ticks[ BENCH_MALLOC ] = bench_ticks() - start;
+    start                         = bench_ticks();
+    
+    switch( thread->method )
+    {
+        case BENCH_LIBC:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = realloc( ptrs[ i ], BENCH_SIZE * 2 );
+            }
+            
+            break;
+        
+        case BENCH_CALL:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = memdebug_realloc( ptrs[ i ], BENCH_SIZE * 2, __FILE__, __LINE__, __func__ );
+            }
+            
+            break;
+        
+        default:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                ptrs[ i ] = BENCH_FAST_REALLOC( ptrs[ i ], BENCH_SIZE * 2 );
+            }
+            
+            break;
+    }
+    
+    thread->ticks[ BENCH_REALLOC ] = bench_ticks() - start;
+    start                          = bench_ticks();
+    
+    switch( thread->method )
+    {
+        case BENCH_LIBC:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                free( ptrs[ i ] );
+            }
+            
+            break;
+        
+        case BENCH_CALL:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                memdebug_free( ptrs[ i ], __FILE__, __LINE__, __func__ );
+            }
+            
+            break;
+        
+        default:
+            
+            for( i = 0; i < BENCH_CALLS; i++ )
+            {
+                BENCH_FAST_FREE( ptrs[ i ] );
+            }
+            
+            break;
+    }
+    
+    thread->ticks[ BENCH_FREE ] = bench_ticks() - start;
+    
+    free( ptrs );
+    
+    return NULL;
+}
+
+/**
+ * Runs a benchmark configuration, and writes its results as CSV lines
+ * 
+ * @param   int                 The allocation method (BENCH_XXX)
+ * @param   unsigned long int   The sampling rate
+ * @param   unsigned int        The number of threads
+ * @return  void
+ */
+static void bench_run( int method, unsigned long int sample, unsigned int threads )
+{
+    unsigned int t;
+    int op;
+    unsigned long long ticks;
+    struct bench_thread bench_threads[ BENCH_MAX_THREADS ];
+    
+    memset( bench_threads, 0, sizeof( bench_threads ) );
+    
+    for( t = 0; t < threads; t++ )
+    {
+        bench_threads[ t ].method = method;
+        
+        if( pthread_create( &bench_threads[ t ].thread, NULL, bench_thread_main, &bench_threads[ t ] ) != 0 )
+        {
+            fprintf( stderr, "Cannot create the benchmark threads\n" );
+            exit( EXIT_FAILURE );
+        }
+    }
+    
+    for( t = 0; t < threads; t++ )
+    {
+        pthread_join( bench_threads[ t ].thread, NULL );
+    }
+    
+    for( op = 0; op < BENCH_OPS; op++ )
+    {
+        for( ticks = 0, t = 0; t < threads; t++ )
+        {
+            ticks += bench_threads[ t ].ticks[ op ];
+        }
+        
+        printf
+        (
+            "%s,%s,%lu,%u,%lu,%.1f\n",
+            bench_methods[ method ],
+            bench_ops[ op ],
+            sample,
+            threads,
+            ( unsigned long int )BENCH_CALLS * threads,
+            ( double )ticks / ( ( double )BENCH_CALLS * threads )
+        );
+    }
+}
+
+/**
+ * C main function
+ * 
+ * Measures the cost of each call to malloc(), realloc() and free(), with
+ * the C library, with the calls to the MEMDebug functions (before the
+ * inline fast path), and with the inline fast path of the header, for
+ * sampling rates of 1 up to the given rate (multiplied by 10 each time),
+ * so for decreasing rates of recorded allocations, and for 1 thread up to
+ * the given number (multiplied by 2 each time). Each configuration runs in
+ * its own child process. The results are written to the standard output
+ * as CSV, in cycles per call (or in nanoseconds per call without a cycle
+ * counter).
+ * 
+ * Usage: memdebug-bench-sample [maximum sampling rate] [maximum number of threads]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    unsigned long int max_sample;
+    unsigned long int sample;
+    unsigned int max_threads;
+    unsigned int threads;
+    int method;
+    int status;
+    pid_t pid;
+    char options[ 64 ];
+    
+    max_sample  = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 0 ) : 1000;
+    max_threads = ( argc > 2 ) ? ( unsigned int )strtoul( argv[ 2 ], NULL, 0 ) : 4;
+    
+    if( max_sample == 0 || max_threads == 0 || max_threads > BENCH_MAX_THREADS )
+    {
+        fprintf( stderr, "Usage: %s [maximum sampling rate, at least 1] [maximum number of threads, at most %i]\n", argv[ 0 ], BENCH_MAX_THREADS );
+        return EXIT_FAILURE;
+    }
+    
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    printf( "method,operation,sample,threads,calls,cycles_per_call\n" );
+    #else
+    printf( "method,operation,sample,threads,calls,ns_per_call\n" );
+    #endif
+    
+    fflush( stdout );
+    
+    for( sample = 1; sample <= max_sample; sample *= 10 )
+    {
+        /* The reports are not needed */
+        snprintf( options, sizeof( options ), "output=/dev/null:sample=%lu", sample );
+        setenv( "MEMDEBUG_OPTIONS", options, 1 );
+        
+        for( threads = 1; threads <= max_threads; threads *= 2 )
+        {
+            for( method = 0; method < BENCH_METHODS; method++ )
+            {
+                if( ( pid = fork() ) == 0 )
+                {
+                    bench_run( method, sample, threads );
+                    fflush( stdout );
+                    _exit( EXIT_SUCCESS );
+                }
+                
+                if( pid < 0 || waitpid( pid, &status, 0 ) < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+                {
+                    fprintf( stderr, "The benchmark failed (sample: %lu, threads: %u)\n", sample, threads );
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+    }
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,399 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+/* Includes the MEMDebug header (not activated, so the C library functions are also available) */
+#include "libmemdebug.h"
+
+/* The number of measured calls of each operation, for each thread */
+#define BENCH_CALLS 100000
+
+/* The maximum number of threads */
+#define BENCH_MAX_THREADS 64
+
+/* The allocation methods */
+#define BENCH_LIBC      0
+#define BENCH_MEMDEBUG  1
+#define BENCH_METHODS   2
+
+/* The measured operations */
+#define BENCH_MALLOC    0
+#define BENCH_CALLOC    1
+#define BENCH_REALLOC   2
+#define BENCH_FREE      3
+#define BENCH_OPS       4
+
+/* The names of the allocation methods */
+static const char * bench_methods[ BENCH_METHODS ] =
+{
+    "libc",
+    "memdebug"
+};
+
+/* The names of the measured operations */
+static const char * bench_ops[ BENCH_OPS ] =
+{
+    "malloc",
+    "calloc",
+    "realloc",
+    "free"
+};
+
+/* The measured allocation sizes */
+static const size_t bench_sizes[] = { 16, 256, 4096 };
+
+/* Structure for a benchmark thread */
+struct bench_thread
+{
+    /* The thread */
+    pthread_t thread;
+    
+    /* The allocation method (BENCH_XXX) */
+    int method;
+    
+    /* The allocation size */
+    size_t size;
+    
+    /* The measured ticks of each operation */
+    unsigned long long ticks[ BENCH_OPS ];
+};
+
+/**
+ * Returns the current value of the cycle counter (or a time, in nanoseconds, without one)
+ * 
+ * @return  unsigned long long  The current ticks
+ */
+static unsigned long long bench_ticks( void )
+{
+    /* Checks for the time-stamp counter */
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    
+    return __builtin_ia32_rdtsc();
+    
+    #else
+    
+    struct timeval now;
+    
+    gettimeofday( &now, NULL );
+    
+    return ( unsigned long long )now.tv_sec * 1000000000ULL + ( unsigned long long )now.tv_usec * 1000ULL;
+    
+    #endif
+}
+
+/**
+ * Allocates a memory area
+ * 
+ * @param   int     The allocation method (BENCH_XXX)
+ * @param   int     The operation (BENCH_MALLOC or BENCH_CALLOC)
+ * @param   size_t  The size of the memory area
+ * @return  void *  The memory area
+ */
+static void * bench_alloc( int method, int op, size_t size )
+{
+    if( method == BENCH_LIBC )
+    {
+        return ( op == BENCH_CALLOC ) ? calloc( 1, size ) : malloc( size );
+    }
+    
+    return ( op == BENCH_CALLOC ) ? memdebug_calloc( 1, size, __FILE__, __LINE__, __func__ ) : memdebug_malloc( size, __FILE__, __LINE__, __func__ );
+}
+
+/**
+ * Reallocates a memory area
+ * 
+ * @param   int     The allocation method (BENCH_XXX)
+ * @param   void *  The memory area
+ * @param   size_t  The new size of the memory area
+ * @return  void *  The reallocated memory area
+ */
+static void * bench_realloc( int method, void * ptr, size_t size )
+{
+    if( method == BENCH_LIBC )
+    {
+        return realloc( ptr, size );
+    }
+    
+    return memdebug_realloc( ptr, size, __FILE__, __LINE__, __func__ );
+}
+
+/**
+ * Frees a memory area
+ * 
+ * @param   int     The allocation method (BENCH_XXX)
+ * @param   void *  The memory area
+ * @return  void
+ */
+static void bench_free( int method, void * ptr )
+{
+    if( method == BENCH_LIBC )
+    {
+        free( ptr );
+    }
+    else
+    {
+        memdebug_free( ptr, __FILE__, __LINE__, __func__ );
+    }
+}
+
+/**
+ * Measures each operation on BENCH_CALLS memory areas
+ * 
+ * The calloc() calls are measured on areas freed afterwards, and the
+ * malloc() calls on the areas then reallocated to twice their size, and
+ * freed.
+ * 
+ * @param   void *  The benchmark thread (struct bench_thread)
+ * @return  void *  NULL
+ */
+static void * bench_thread_main( void * data )
+{
+    unsigned long int i;
+    unsigned long long start;
+    struct bench_thread * thread;
+    void ** ptrs;
+    
+    thread = ( struct bench_thread * )data;
+    
+    if( NULL == ( ptrs = ( void ** )malloc( BENCH_CALLS * sizeof( void * ) ) ) )
+    {
+        fprintf( stderr, "Cannot allocate the benchmark areas\n" );
+        exit( EXIT_FAILURE );
+    }
+    
+    start = bench_ticks();
+    
+    for( i = 0; i < BENCH_CALLS; i++ )
+    {
+        ptrs[ i ] = bench_alloc( thread->method, BENCH_CALLOC, thread->size );
+    }
+    
+    thread->ticks[ BENCH_CALLOC ] = bench_ticks() - start;
+    
+    for( i = 0; i < BENCH_CALLS; i++ )
+    {
+        bench_free( thread->method, ptrs[ i ] );
+    }
+    
+    start = bench_ticks();
+    
+    for( i = 0; i < BENCH_CALLS; i++ )
+    {
+        ptrs[ i ] = bench_alloc( thread->method, BENCH_MALLOC, thread->size );
+    }
+    
+    thread->ticks[ BENCH_MALLOC ] = bench_ticks() - start;
+    start                         = bench_ticks();
+    
+    for( i = 0; i < BENCH_CALLS; i++ )
+    {
+        ptrs[ i ] = bench_realloc( thread->method, ptrs[ i ], thread->size * 2 );
+    }
+    
+    thread->ticks[ BENCH_REALLOC ] = bench_ticks() - start;
+    start                          = bench_ticks();
+    
+    for( i = 0; i < BENCH_CALLS; i++ )
+    {
+        bench_free( thread->method, ptrs[ i ] );
+    }
+    
+    thread->ticks[ BENCH_FREE ] = bench_ticks() - start;
+    
+    free( ptrs );
+    
+    return NULL;
+}
+
+/**
+ * Runs a benchmark configuration, and writes its results as CSV lines
+ * 
+ * The live set is allocated first, and stays allocated during the measures,
+ * so the cost of the lookups of the records is included.
+ * 
+ * @param   int                 The allocation method (BENCH_XXX)
+ * @param   unsigned long int   The number of live memory areas
+ * @param   size_t              The allocation size
+ * @param   unsigned int        The number of threads
+ * @return  void
+ */
+static void bench_run( int method, unsigned long int live, size_t size, unsigned int threads )
+{
+    unsigned long int i;
+    unsigned int t;
+    int op;
+    unsigned long long ticks;
+    void ** ptrs;
+    struct bench_thread bench_threads[ BENCH_MAX_THREADS ];
+    
+    if( NULL == ( ptrs = ( void ** )malloc( live * sizeof( void * ) ) ) )
+    {
+        fprintf( stderr, "Cannot allocate the live set of %lu memory areas\n", live );
+        exit( EXIT_FAILURE );
+    }
+    
+    for( i = 0; i < live; i++ )
+    {
+        ptrs[ i ] = bench_alloc( method, BENCH_MALLOC, size );
+    }
+    
+    memset( bench_threads, 0, sizeof( bench_threads ) );
+    
+    for( t = 0; t < threads; t++ )
+    {
+        bench_threads[ t ].method = method;
+        bench_threads[ t ].size   = size;
+        
+        if( pthread_create( &bench_threads[ t ].thread, NULL, bench_thread_main, &bench_threads[ t ] ) != 0 )
+        {
+            fprintf( stderr, "Cannot create the benchmark threads\n" );
+            exit( EXIT_FAILURE );
+        }
+    }
+    
+    for( t = 0; t < threads; t++ )
+    {
+        pthread_join( bench_threads[ t ].thread, NULL );
+    }
+    
+    for( op = 0; op < BENCH_OPS; op++ )
+    {
+        for( ticks = 0, t = 0; t < threads; t++ )
+        {
+            ticks += bench_threads[ t ].ticks[ op ];
+        }
+        
+        printf
+        (
+            "%s,%s,%lu,%lu,%u,%lu,%.1f\n",
+            bench_methods[ method ],
+            bench_ops[ op ],
+            live,
+            ( unsigned long int )size,
+            threads,
+            ( unsigned long int )BENCH_CALLS * threads,
+            ( double )ticks / ( ( double )BENCH_CALLS * threads )
+        );
+    }
+    
+    for( i = 0; i < live; i++ )
+    {
+        bench_free( method, ptrs[ i ] );
+    }
+    
+    free( ptrs );
+}
+
+/**
+ * C main function
+ * 
+ * Measures the cost of each call to malloc(), calloc(), realloc() and
+ * free(), with the C library and with MEMDebug, for live sets of 1K
+ * memory areas up to the given number (multiplied by 10 each time), for
+ * several allocation sizes, and for 1 thread up to the given number
+ * (multiplied by 2 each time). Each configuration runs in its own child
+ * process, as MEMDebug keeps the records of the previous ones. The results
+ * are written to the standard output as CSV, in cycles per call (or in
+ * nanoseconds per call without a cycle counter).
+ * 
+ * Usage: memdebug-bench [maximum number of live memory areas] [maximum number of threads]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    unsigned long int max_live;
+    unsigned long int live;
+    unsigned int max_threads;
+    unsigned int threads;
+    unsigned int size;
+    int method;
+    int status;
+    pid_t pid;
+    
+    max_live    = ( argc > 1 ) ? strtoul( argv[ 1 ], NULL, 0 ) : 1000000;
+    max_threads = ( argc > 2 ) ? ( unsigned int )strtoul( argv[ 2 ], NULL, 0 ) : 4;
+    
+    if( max_live < 1000 || max_threads == 0 || max_threads > BENCH_MAX_THREADS )
+    {
+        fprintf( stderr, "Usage: %s [maximum number of live memory areas, at least 1000] [maximum number of threads, at most %i]\n", argv[ 0 ], BENCH_MAX_THREADS );
+        return EXIT_FAILURE;
+    }
+    
+    /* The reports are not needed */
+    setenv( "MEMDEBUG_OPTIONS", "output=/dev/null", 1 );
+    
+    #if defined( __GNUC__ ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+    printf( "method,operation,live,size,threads,calls,cycles_per_call\n" );
+    #else
+    printf( "method,operation,live,size,threads,calls,ns_per_call\n" );
+    #endif
+    
+    fflush( stdout );
+    
+    for( live = 1000; live <= max_live; live *= 10 )
+    {
+        for( size = 0; size < sizeof( bench_sizes ) / sizeof( size_t ); size++ )
+        {
+            for( threads = 1; threads <= max_threads; threads *= 2 )
+            {
+                for( method = 0; method < BENCH_METHODS; method++ )
+                {
+                    if( ( pid = fork() ) == 0 )
+                    {
+                        bench_run( method, live, bench_sizes[ size ], threads );
+                        fflush( stdout );
+                        _exit( EXIT_SUCCESS );
+                    }
+                    
+                    if( pid < 0 || waitpid( pid, &status, 0 ) < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+                    {
+                        fprintf( stderr, "The benchmark failed (live: %lu, size: %lu, threads: %u)\n", live, ( unsigned long int )bench_sizes[ size ], threads );
+                        return EXIT_FAILURE;
+                    }
+                }
+            }
+        }
+    }
+    
+    return EXIT_SUCCESS;
+}
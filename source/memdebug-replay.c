@@ -0,0 +1,538 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* Includes the MEMDebug header (not activated, so the C library functions are also available) */
+#include "libmemdebug.h"
+
+/* The default number of repetitions of the replay (the best time is kept) */
+#define REPLAY_RUNS 5
+
+/* The replayed operations */
+#define REPLAY_MALLOC   0
+#define REPLAY_CALLOC   1
+#define REPLAY_VALLOC   2
+#define REPLAY_REALLOC  3
+#define REPLAY_FREE     4
+
+/* Structure for a replayed operation */
+struct replay_op
+{
+    /* The operation (REPLAY_XXX) */
+    int type;
+    
+    /* The number of the memory area */
+    unsigned long int id;
+    
+    /* The size of the memory area */
+    size_t size;
+};
+
+/* Structure for a slot of the table of the captured addresses */
+struct replay_slot
+{
+    /* The captured address (0 for an empty slot) */
+    unsigned long int address;
+    
+    /* The number of the memory area */
+    unsigned long int id;
+};
+
+/* Structure for a capture file, resolved to numbered memory areas */
+struct replay_capture
+{
+    /* The operations */
+    struct replay_op * ops;
+    
+    /* The number of operations */
+    unsigned long int num_ops;
+    
+    /* The capacity of the operations array */
+    unsigned long int ops_size;
+    
+    /* The number of memory areas */
+    unsigned long int num_ids;
+    
+    /* The table of the live captured addresses, with linear probing */
+    struct replay_slot * slots;
+    
+    /* The capacity of the table (a power of 2) */
+    unsigned long int slots_size;
+    
+    /* The number of live captured addresses */
+    unsigned long int num_live;
+    
+    /* The peak number of live memory areas */
+    unsigned long int peak_live;
+    
+    /* The number of threads of the capture */
+    unsigned long int num_threads;
+    
+    /* The number of ignored operations (areas allocated before the capture) */
+    unsigned long int skipped;
+};
+
+/**
+ * Returns the current time, in microseconds
+ * 
+ * @return  double  The current time
+ */
+static double replay_time( void )
+{
+    struct timeval tv;
+    
+    gettimeofday( &tv, NULL );
+    
+    return ( double )tv.tv_sec * 1000000.0 + ( double )tv.tv_usec;
+}
+
+/**
+ * Gets the slot of a captured address in the table
+ * 
+ * @param   struct replay_capture *     The capture
+ * @param   unsigned long int           The captured address
+ * @return  unsigned long int           The slot of the address, or the empty slot ending its probe sequence
+ */
+static unsigned long int replay_slot( struct replay_capture * capture, unsigned long int address )
+{
+    unsigned long int slot;
+    
+    slot = ( ( address >> 4 ) * 2654435761UL ) & ( capture->slots_size - 1 );
+    
+    while( capture->slots[ slot ].address != 0 && capture->slots[ slot ].address != address )
+    {
+        slot = ( slot + 1 ) & ( capture->slots_size - 1 );
+    }
+    
+    return slot;
+}
+
+/**
+ * Sets the number of the memory area at a captured address
+ * 
+ * @param   struct replay_capture *     The capture
+ * @param   unsigned long int           The captured address
+ * @param   unsigned long int           The number of the memory area
+ * @return  void
+ */
+static void replay_insert( struct replay_capture * capture, unsigned long int address, unsigned long int id )
+{
+    unsigned long int i;
+    unsigned long int slot;
+    unsigned long int size;
+    struct replay_slot * slots;
+    
+    /* Keeps the table at most half full */
+    if( ( capture->num_live + 1 ) * 2 > capture->slots_size )
+    {
+        slots               = capture->slots;
+        size                = capture->slots_size;
+        capture->slots_size = ( size == 0 ) ? 1024 : size * 2;
+        
+        if( NULL == ( capture->slots = ( struct replay_slot * )calloc( capture->slots_size, sizeof( struct replay_slot ) ) ) )
+        {
+            fprintf( stderr, "Cannot allocate the table of the captured addresses\n" );
+            exit( EXIT_FAILURE );
+        }
+        
+        for( i = 0; i < size; i++ )
+        {
+            if( slots[ i ].address != 0 )
+            {
+                capture->slots[ replay_slot( capture, slots[ i ].address ) ] = slots[ i ];
+            }
+        }
+        
+        free( slots );
+    }
+    
+    slot = replay_slot( capture, address );
+    
+    if( capture->slots[ slot ].address == 0 )
+    {
+        capture->num_live++;
+    }
+    
+    capture->slots[ slot ].address = address;
+    capture->slots[ slot ].id      = id;
+    capture->peak_live             = ( capture->num_live > capture->peak_live ) ? capture->num_live : capture->peak_live;
+}
+
+/**
+ * Removes a captured address from the table
+ * 
+ * The following slots of the probe sequence are moved back, so the table
+ * never needs tombstones.
+ * 
+ * @param   struct replay_capture *     The capture
+ * @param   unsigned long int           The captured address
+ * @param   unsigned long int *         On success, the number of the memory area at the address
+ * @return  int                         1 if the address was found, otherwise 0
+ */
+static int replay_remove( struct replay_capture * capture, unsigned long int address, unsigned long int * id )
+{
+    unsigned long int slot;
+    unsigned long int next;
+    unsigned long int home;
+    unsigned long int mask;
+    
+    if( capture->slots_size == 0 || capture->slots[ slot = replay_slot( capture, address ) ].address == 0 )
+    {
+        return 0;
+    }
+    
+    *( id ) = capture->slots[ slot ].id;
+    mask    = capture->slots_size - 1;
+    next    = slot;
+    
+    capture->num_live--;
+    
+    for( ;; )
+    {
+        next = ( next + 1 ) & mask;
+        
+        if( capture->slots[ next ].address == 0 )
+        {
+            break;
+        }
+        
+        home = ( ( capture->slots[ next ].address >> 4 ) * 2654435761UL ) & mask;
+        
+        /* Moves the entry back if its home slot is not between the freed slot and its slot */
+        if( ( ( next - home ) & mask ) >= ( ( next - slot ) & mask ) )
+        {
+            capture->slots[ slot ] = capture->slots[ next ];
+            slot                   = next;
+        }
+    }
+    
+    capture->slots[ slot ].address = 0;
+    
+    return 1;
+}
+
+/**
+ * Appends an operation to the capture
+ * 
+ * @param   struct replay_capture *     The capture
+ * @param   int                         The operation (REPLAY_XXX)
+ * @param   unsigned long int           The number of the memory area
+ * @param   size_t                      The size of the memory area
+ * @return  void
+ */
+static void replay_add( struct replay_capture * capture, int type, unsigned long int id, size_t size )
+{
+    if( capture->num_ops == capture->ops_size )
+    {
+        capture->ops_size = ( capture->ops_size == 0 ) ? 65536 : capture->ops_size * 2;
+        
+        if( NULL == ( capture->ops = ( struct replay_op * )realloc( capture->ops, capture->ops_size * sizeof( struct replay_op ) ) ) )
+        {
+            fprintf( stderr, "Cannot allocate the replayed operations\n" );
+            exit( EXIT_FAILURE );
+        }
+    }
+    
+    capture->ops[ capture->num_ops ].type = type;
+    capture->ops[ capture->num_ops ].id   = id;
+    capture->ops[ capture->num_ops ].size = size;
+    
+    capture->num_ops++;
+}
+
+/**
+ * Reads a capture file (see memdebug_capture())
+ * 
+ * The captured addresses are resolved to numbered memory areas, so the
+ * replay only indexes an array. An address allocated again before being
+ * freed (threads racing between the allocation and the capture) gets a
+ * new number. Areas allocated before the capture are reallocated as new
+ * allocations, and their deallocations are ignored.
+ * 
+ * @param   const char *                The path of the capture file
+ * @param   struct replay_capture *     The capture
+ * @return  int                         0 on success, -1 if the file cannot be read
+ */
+static int replay_read( const char * path, struct replay_capture * capture )
+{
+    FILE * fp;
+    char line[ 256 ];
+    char op[ 16 ];
+    unsigned long int thread;
+    unsigned long long ticks;
+    unsigned long int address;
+    unsigned long int size;
+    unsigned long int address_new;
+    unsigned long int id;
+    int fields;
+    
+    if( NULL == ( fp = fopen( path, "r" ) ) )
+    {
+        return -1;
+    }
+    
+    memset( capture, 0, sizeof( struct replay_capture ) );
+    
+    while( fgets( line, sizeof( line ), fp ) != NULL )
+    {
+        address_new = 0;
+        fields      = sscanf( line, "%15[a-z],%lu,%llu,%lx,%lu,%lx", op, &thread, &ticks, &address, &size, &address_new );
+        
+        /* Header line */
+        if( fields < 5 )
+        {
+            continue;
+        }
+        
+        capture->num_threads = ( thread > capture->num_threads ) ? thread : capture->num_threads;
+        
+        if( strcmp( op, "free" ) == 0 )
+        {
+            if( replay_remove( capture, address, &id ) == 0 )
+            {
+                capture->skipped++;
+                continue;
+            }
+            
+            replay_add( capture, REPLAY_FREE, id, 0 );
+        }
+        else if( strcmp( op, "realloc" ) == 0 )
+        {
+            if( replay_remove( capture, address, &id ) == 0 )
+            {
+                id = capture->num_ids++;
+            }
+            
+            replay_add( capture, REPLAY_REALLOC, id, size );
+            replay_insert( capture, address_new, id );
+        }
+        else
+        {
+            id = capture->num_ids++;
+            
+            replay_add( capture, ( op[ 0 ] == 'c' ) ? REPLAY_CALLOC : ( ( op[ 0 ] == 'v' ) ? REPLAY_VALLOC : REPLAY_MALLOC ), id, size );
+            replay_insert( capture, address, id );
+        }
+    }
+    
+    fclose( fp );
+    
+    return 0;
+}
+
+/**
+ * Replays the operations of a capture through the MEMDebug functions
+ * 
+ * @param   struct replay_capture *     The capture
+ * @param   void **                     The memory areas, by number (initially NULL)
+ * @return  void
+ */
+static void replay_run( struct replay_capture * capture, void ** ptrs )
+{
+    unsigned long int i;
+    struct replay_op * op;
+    
+    for( i = 0; i < capture->num_ops; i++ )
+    {
+        op = &( capture->ops[ i ] );
+        
+        switch( op->type )
+        {
+            case REPLAY_MALLOC:
+                
+                ptrs[ op->id ] = memdebug_malloc( op->size, __FILE__, __LINE__, __func__ );
+                break;
+            
+            case REPLAY_CALLOC:
+                
+                ptrs[ op->id ] = memdebug_calloc( 1, op->size, __FILE__, __LINE__, __func__ );
+                break;
+            
+            case REPLAY_VALLOC:
+                
+                ptrs[ op->id ] = memdebug_valloc( op->size, __FILE__, __LINE__, __func__ );
+                break;
+            
+            case REPLAY_REALLOC:
+                
+                ptrs[ op->id ] = memdebug_realloc( ptrs[ op->id ], op->size, __FILE__, __LINE__, __func__ );
+                break;
+            
+            default:
+                
+                memdebug_free( ptrs[ op->id ], __FILE__, __LINE__, __func__ );
+                ptrs[ op->id ] = NULL;
+                break;
+        }
+    }
+}
+
+/**
+ * C main function
+ * 
+ * Replays a capture of the allocations of a program (see the capture
+ * option of MEMDebug) through the MEMDebug functions, and prints the
+ * best duration of the replay and the resident set size. The operations
+ * of all the threads are replayed in the captured order, by a single
+ * thread, so the replay is deterministic. Each replay runs in its own
+ * child process, with the configuration of the MEMDEBUG_OPTIONS
+ * environment variable, so configurations can be compared on the same
+ * allocation sequence:
+ * 
+ *      MEMDEBUG_OPTIONS=enabled=0 memdebug-replay capture.csv
+ *      MEMDEBUG_OPTIONS=sample=10 memdebug-replay capture.csv
+ *      MEMDEBUG_OPTIONS=quarantine=1048576 memdebug-replay capture.csv
+ * 
+ * Usage: memdebug-replay <capture file> [number of runs]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    struct replay_capture capture;
+    struct rusage usage;
+    unsigned long int runs;
+    unsigned long int run;
+    const char * options;
+    double result[ 2 ];
+    double best;
+    double rss;
+    double start;
+    void ** ptrs;
+    int fds[ 2 ];
+    int status;
+    pid_t pid;
+    
+    runs = ( argc > 2 ) ? strtoul( argv[ 2 ], NULL, 0 ) : REPLAY_RUNS;
+    
+    if( argc < 2 || runs == 0 )
+    {
+        fprintf( stderr, "Usage: %s <capture file> [number of runs, default %i]\n", argv[ 0 ], REPLAY_RUNS );
+        return EXIT_FAILURE;
+    }
+    
+    if( replay_read( argv[ 1 ], &capture ) != 0 )
+    {
+        fprintf( stderr, "Cannot read the capture file '%s'\n", argv[ 1 ] );
+        return EXIT_FAILURE;
+    }
+    
+    options = getenv( "MEMDEBUG_OPTIONS" );
+    best    = 0;
+    rss     = 0;
+    
+    for( run = 0; run < runs; run++ )
+    {
+        if( pipe( fds ) != 0 || ( pid = fork() ) < 0 )
+        {
+            fprintf( stderr, "Cannot start the replay\n" );
+            return EXIT_FAILURE;
+        }
+        
+        if( pid == 0 )
+        {
+            close( fds[ 0 ] );
+            
+            if( NULL == ( ptrs = ( void ** )calloc( capture.num_ids + 1, sizeof( void * ) ) ) )
+            {
+                _exit( EXIT_FAILURE );
+            }
+            
+            start = replay_time();
+            
+            replay_run( &capture, ptrs );
+            
+            result[ 0 ] = replay_time() - start;
+            
+            getrusage( RUSAGE_SELF, &usage );
+            
+            /* The maximum resident set size is in kilobytes on Linux, and in bytes on macOS */
+            #ifdef __APPLE__
+            result[ 1 ] = ( double )usage.ru_maxrss / ( 1024.0 * 1024.0 );
+            #else
+            result[ 1 ] = ( double )usage.ru_maxrss / 1024.0;
+            #endif
+            
+            if( write( fds[ 1 ], result, sizeof( result ) ) != sizeof( result ) )
+            {
+                _exit( EXIT_FAILURE );
+            }
+            
+            _exit( EXIT_SUCCESS );
+        }
+        
+        close( fds[ 1 ] );
+        
+        if( read( fds[ 0 ], result, sizeof( result ) ) != sizeof( result ) || waitpid( pid, &status, 0 ) < 0 || !WIFEXITED( status ) || WEXITSTATUS( status ) != EXIT_SUCCESS )
+        {
+            fprintf( stderr, "The replay failed\n" );
+            return EXIT_FAILURE;
+        }
+        
+        close( fds[ 0 ] );
+        
+        best = ( run == 0 || result[ 0 ] < best ) ? result[ 0 ] : best;
+        rss  = ( result[ 1 ] > rss ) ? result[ 1 ] : rss;
+    }
+    
+    printf
+    (
+        "Capture:          %s\n"
+        "Operations:       %lu (%lu threads, %lu ignored)\n"
+        "Memory areas:     %lu (peak: %lu live)\n"
+        "MEMDEBUG_OPTIONS: %s\n"
+        "Best time:        %.3f ms (%.1f ns per operation, %lu runs)\n"
+        "Peak RSS:         %.1f MB\n",
+        argv[ 1 ],
+        capture.num_ops,
+        capture.num_threads,
+        capture.skipped,
+        capture.num_ids,
+        capture.peak_live,
+        ( options == NULL ) ? "" : options,
+        best / 1000.0,
+        ( capture.num_ops == 0 ) ? 0.0 : ( best * 1000.0 ) / ( double )capture.num_ops,
+        runs,
+        rss
+    );
+    
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,242 @@
+/*******************************************************************************
+ * Copyright (c) 2009, Jean-David Gadina - www.xs-labs.com
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ * 
+ *  -   Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *  -   Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *  -   Neither the name of 'Jean-David Gadina' nor the names of its
+ *      contributors may be used to endorse or promote products derived from
+ *      this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+ * INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+ * CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ * ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ ******************************************************************************/
+
+/* $Id$ */
+
+
+/* System includes */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+/* Includes the MEMDebug header (MEMDebug is not activated, only the definitions are used) */
+#include "libmemdebug.h"
+
+/* The maximum number of attempts to read a consistent statistics page */
+#define TOP_READ_ATTEMPTS 1000
+
+/**
+ * Copies the statistics page, with the sequence lock
+ * 
+ * @param   const struct memdebug_stats *   The shared memory statistics page
+ * @param   struct memdebug_stats *         The copy
+ * @return  int                             1 on success, 0 if the page keeps changing
+ */
+static int top_read( const volatile struct memdebug_stats * page, struct memdebug_stats * stats )
+{
+    unsigned int attempt;
+    unsigned long int sequence;
+    
+    for( attempt = 0; attempt < TOP_READ_ATTEMPTS; attempt++ )
+    {
+        sequence = page->sequence;
+        
+        /* The page is being updated */
+        if( sequence & 1 )
+        {
+            sched_yield();
+            continue;
+        }
+        
+        __sync_synchronize();
+        
+        memcpy( stats, ( const void * )page, sizeof( struct memdebug_stats ) );
+        
+        __sync_synchronize();
+        
+        if( page->sequence == sequence )
+        {
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+/**
+ * Prints the statistics
+ * 
+ * @param   const struct memdebug_stats *   The statistics
+ * @param   const char *                    The name of the shared memory object
+ * @return  void
+ */
+static void top_print( const struct memdebug_stats * stats, const char * name )
+{
+    unsigned int i;
+    
+    /* Clears the terminal */
+    printf( "\033[H\033[2J" );
+    
+    printf
+    (
+        "MEMDebug - %s - process %li\n"
+        "\n"
+        "Objects:  %lu total, %lu active, %lu freed, %lu automatically freed, %lu not sampled, %lu peak\n"
+        "Memory:   %lu total, %lu active, %lu quarantined, %lu peak\n"
+        "\n",
+        name,
+        stats->pid,
+        stats->num_objects,
+        stats->num_active,
+        stats->num_free,
+        stats->num_auto,
+        stats->num_untracked,
+        stats->num_peak,
+        stats->memory_total,
+        stats->memory_active,
+        stats->memory_quarantine,
+        stats->memory_peak
+    );
+    
+    printf( "%25s %12s %12s\n", "SIZE (bytes)", "ACTIVE", "TOTAL" );
+    
+    for( i = 0; i < MEMDEBUG_SIZE_CLASSES; i++ )
+    {
+        if( stats->total[ i ] == 0 )
+        {
+            continue;
+        }
+        
+        printf
+        (
+            "%12lu - %-10lu %12lu %12lu\n",
+            ( i == 0 ) ? 0UL : 1UL << i,
+            ( i == MEMDEBUG_SIZE_CLASSES - 1 ) ? ( unsigned long int )-1 : ( 1UL << ( i + 1 ) ) - 1,
+            stats->live[ i ],
+            stats->total[ i ]
+        );
+    }
+    
+    printf( "\n%12s %10s %12s %10s  %s\n", "ACTIVE", "OBJECTS", "TOTAL", "OBJECTS", "SITE" );
+    
+    for( i = 0; i < stats->num_sites && i < MEMDEBUG_STATS_SITES; i++ )
+    {
+        printf
+        (
+            "%12lu %10lu %12lu %10lu  %s() - %s:%i\n",
+            stats->sites[ i ].live_size,
+            stats->sites[ i ].live_count,
+            stats->sites[ i ].total_size,
+            stats->sites[ i ].total_count,
+            stats->sites[ i ].func,
+            stats->sites[ i ].file,
+            stats->sites[ i ].line
+        );
+    }
+    
+    fflush( stdout );
+}
+
+/**
+ * C main function
+ * 
+ * Attaches to the statistics published by a program (stats option of
+ * MEMDEBUG_OPTIONS, or memdebug_publish_stats()), read-only, and refreshes
+ * them until the program exits.
+ * 
+ * Usage: memdebug-top <name> [interval in milliseconds]
+ * 
+ * @param   int     The number of arguments
+ * @param   char ** The arguments
+ * @return  int     The program exit status
+ */
+int main( int argc, char ** argv )
+{
+    int fd;
+    unsigned long int interval;
+    struct timespec delay;
+    struct memdebug_stats stats;
+    const volatile struct memdebug_stats * page;
+    
+    if( argc < 2 )
+    {
+        fprintf( stderr, "Usage: %s <name> [interval in milliseconds]\n", argv[ 0 ] );
+        return EXIT_FAILURE;
+    }
+    
+    interval = ( argc > 2 ) ? strtoul( argv[ 2 ], NULL, 0 ) : 1000;
+    
+    if( ( fd = shm_open( argv[ 1 ], O_RDONLY, 0 ) ) == -1 )
+    {
+        fprintf( stderr, "Cannot open the statistics '%s'. Reason: %s\n", argv[ 1 ], strerror( errno ) );
+        return EXIT_FAILURE;
+    }
+    
+    page = ( const volatile struct memdebug_stats * )mmap( NULL, sizeof( struct memdebug_stats ), PROT_READ, MAP_SHARED, fd, 0 );
+    
+    close( fd );
+    
+    if( page == MAP_FAILED )
+    {
+        fprintf( stderr, "Cannot map the statistics '%s'. Reason: %s\n", argv[ 1 ], strerror( errno ) );
+        return EXIT_FAILURE;
+    }
+    
+    delay.tv_sec  = ( time_t )( interval / 1000 );
+    delay.tv_nsec = ( long )( interval % 1000 ) * 1000000;
+    
+    for( ;; )
+    {
+        /* The program may not have finished the publication yet */
+        if( page->magic != MEMDEBUG_STATS_MAGIC )
+        {
+            nanosleep( &delay, NULL );
+            continue;
+        }
+        
+        if( page->size != sizeof( struct memdebug_stats ) )
+        {
+            fprintf( stderr, "The statistics '%s' were published by an incompatible version of MEMDebug\n", argv[ 1 ] );
+            return EXIT_FAILURE;
+        }
+        
+        if( top_read( page, &stats ) )
+        {
+            top_print( &stats, argv[ 1 ] );
+        }
+        
+        /* The program has exited (its process ID is written once, before the magic number) */
+        if( kill( ( pid_t )page->pid, 0 ) != 0 && errno == ESRCH )
+        {
+            printf( "\nThe process %li has exited\n", page->pid );
+            break;
+        }
+        
+        nanosleep( &delay, NULL );
+    }
+    
+    return EXIT_SUCCESS;
+}